@@ -0,0 +1,98 @@
+// Cancel latency vs. queue depth at a single price level.
+// With intrusive nodes the per-cancel cost should stay flat as depth grows.
+// Then session end: cancel_side() / cancel_day() against cancelling the same
+// orders one at a time, in random id order, per order removed.
+#include "ob/book.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using clk = std::chrono::steady_clock;
+
+static double bench_depth(size_t depth, size_t ops)
+{
+    OrderBook ob("BENCH", 1);
+    const int64_t px = 10000;
+    uint64_t next_id = 1;
+
+    std::vector<uint64_t> live;
+    live.reserve(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        ob.add(Order{next_id, Side::Buy, Type::Limit, TIF::Day, px, 10, 0, false});
+        live.push_back(next_id++);
+    }
+
+    // Cancel a random resting order and immediately re-add one at the back,
+    // keeping the queue length constant. Only the cancel is timed.
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> samples;
+    samples.reserve(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        const size_t slot = rng() % live.size();
+        const uint64_t id = live[slot];
+
+        const auto t0 = clk::now();
+        ob.cancel(id, 0);
+        const auto t1 = clk::now();
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+        ob.add(Order{next_id, Side::Buy, Type::Limit, TIF::Day, px, 10, 0, false});
+        live[slot] = next_id++;
+        ob.events().clear();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return static_cast<double>(samples[samples.size() / 2]);
+}
+
+// orders resting over `levels` bid levels, every other one GTC.
+static void bench_session_end(size_t orders, size_t levels)
+{
+    auto fill = [&](OrderBook& ob) {
+        for (size_t i = 0; i < orders; ++i) {
+            const TIF tif = i % 2 ? TIF::GTC : TIF::Day;
+            ob.add(Order{i + 1, Side::Buy, Type::Limit, tif, 10000 - static_cast<int64_t>(i % levels), 10, 0, false});
+        }
+        ob.events().clear();
+    };
+    std::vector<uint64_t> ids(orders);
+    for (size_t i = 0; i < orders; ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), std::mt19937_64(7));
+    const BookConfig cfg{.orders = orders, .events = 2 * orders};
+    auto per_order = [](clk::duration d, size_t n) { return std::chrono::duration<double, std::nano>(d).count() / static_cast<double>(n); };
+
+    OrderBook bulk("BENCH", 1, cfg), single("BENCH", 1, cfg);
+    fill(bulk);
+    fill(single);
+    auto t0 = clk::now();
+    bulk.cancel_side(Side::Buy, 1);
+    auto t1 = clk::now();
+    for (uint64_t id : ids) single.cancel(id, 1);
+    auto t2 = clk::now();
+    std::printf("%-12s %9zu %7zu %10.1f %10.1f\n", "cancel_side", orders, levels, per_order(t1 - t0, orders), per_order(t2 - t1, orders));
+
+    OrderBook day("BENCH", 1, cfg), day_single("BENCH", 1, cfg);
+    fill(day);
+    fill(day_single);
+    t0 = clk::now();
+    const size_t n = day.cancel_day(1);
+    t1 = clk::now();
+    for (uint64_t id : ids) if (id % 2) day_single.cancel(id, 1);    // ids 1, 3, ... are the Day ones
+    t2 = clk::now();
+    std::printf("%-12s %9zu %7zu %10.1f %10.1f\n", "cancel_day", orders, levels, per_order(t1 - t0, n), per_order(t2 - t1, n));
+}
+
+int main()
+{
+    std::printf("%10s %14s\n", "depth", "cancel_p50_ns");
+    for (size_t depth : {16u, 256u, 4096u, 65536u}) {
+        std::printf("%10zu %14.1f\n", depth, bench_depth(depth, 200000));
+    }
+
+    std::printf("\n%-12s %9s %7s %10s %10s\n", "session_end", "orders", "levels", "bulk_ns", "single_ns");
+    for (size_t orders : {10'000u, 1'000'000u}) bench_session_end(orders, 1000);
+    return 0;
+}
@@ -0,0 +1,225 @@
+#pragma once
+// Shared pieces for the benchmark executables: a synthetic message mix,
+// a tiny JSON writer and command-line parsing.
+#include "ob/book.hpp"
+#include "ob/order.hpp"
+#include "ob/timing.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+enum class Op : uint8_t { Add, Cancel, Replace, Market };
+
+struct Msg
+{
+    Op op;
+    Order o;
+};
+
+// Message mix. Ratios need not sum to 1; they are normalised.
+struct Mix
+{
+    const char* name{"balanced"};
+    double add{0.45};
+    double cancel{0.40};
+    double replace{0.10};
+    double market{0.05};
+    int64_t band_ticks{50};      // passive orders rest within this many ticks of mid
+    int64_t max_qty{100};
+    size_t target_live{2000};    // resting orders the flow hovers around
+};
+
+inline std::vector<Mix> default_mixes()
+{
+    std::vector<Mix> m(4);
+    m[0] = Mix{};
+    m[1] = Mix{"cancel_heavy", 0.48, 0.47, 0.03, 0.02, 50, 100, 2000};
+    m[2] = Mix{"deep_queues", 0.45, 0.40, 0.10, 0.05, 5, 100, 50000};
+    m[3] = Mix{"aggressive", 0.40, 0.25, 0.10, 0.25, 20, 300, 500};
+    return m;
+}
+
+// Random flow around a slowly drifting mid. Cancels and replaces always
+// target an order id that the flow itself added (it may have traded away
+// since, as in real feeds).
+inline std::vector<Msg> make_flow(size_t n, const Mix& mix, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    const double total = mix.add + mix.cancel + mix.replace + mix.market;
+    const double p_add = mix.add / total;
+    const double p_cancel = p_add + mix.cancel / total;
+    const double p_replace = p_cancel + mix.replace / total;
+
+    std::vector<Msg> out;
+    out.reserve(n + mix.target_live);
+    std::vector<uint64_t> live;
+    live.reserve(mix.target_live * 2);
+    uint64_t next_id = 1;
+    int64_t mid = 100000;
+    int64_t ts = 0;
+
+    auto passive = [&](uint64_t id) {
+        const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+        const int64_t off = 1 + static_cast<int64_t>(rng() % static_cast<uint64_t>(mix.band_ticks));
+        const int64_t px = side == Side::Buy ? mid - off : mid + off;
+        const int64_t qty = 1 + static_cast<int64_t>(rng() % static_cast<uint64_t>(mix.max_qty));
+        return Order{id, side, Type::Limit, TIF::Day, px, qty, ts, false};
+    };
+
+    // Pre-fill the book to its target depth.
+    for (size_t i = 0; i < mix.target_live; ++i) {
+        out.push_back({Op::Add, passive(next_id)});
+        live.push_back(next_id++);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        ts += 1 + static_cast<int64_t>(rng() % 1000);
+        if ((rng() & 63) == 0) mid += static_cast<int64_t>(rng() % 3) - 1;
+
+        double r = u(rng);
+        // Steer the live count back towards the target.
+        if (live.size() < mix.target_live / 2) r = 0.0;
+        if (live.empty() && r >= p_add && r < p_replace) r = 0.0;
+
+        if (r < p_add) {
+            out.push_back({Op::Add, passive(next_id)});
+            live.push_back(next_id++);
+        } else if (r < p_cancel) {
+            const size_t k = rng() % live.size();
+            Order o{};
+            o.id = live[k];
+            o.ts_ns = ts;
+            out.push_back({Op::Cancel, o});
+            live[k] = live.back();
+            live.pop_back();
+        } else if (r < p_replace) {
+            Order o = passive(live[rng() % live.size()]);
+            out.push_back({Op::Replace, o});
+        } else {
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            const int64_t qty = 1 + static_cast<int64_t>(rng() % static_cast<uint64_t>(mix.max_qty * 2));
+            out.push_back({Op::Market, Order{next_id++, side, Type::Market, TIF::IOC, 0, qty, ts, false}});
+        }
+    }
+    return out;
+}
+
+template <class Book>
+inline bool apply(Book& ob, const Msg& m)
+{
+    switch (m.op) {
+        case Op::Add:
+        case Op::Market:  return ob.add(m.o);
+        case Op::Cancel:  return ob.cancel(m.o.id, m.o.ts_ns);
+        case Op::Replace: return ob.replace(m.o.id, m.o.px, m.o.qty, m.o.ts_ns);
+    }
+    return false;
+}
+
+inline const char* op_name(Op op)
+{
+    switch (op) {
+        case Op::Add:     return "add";
+        case Op::Cancel:  return "cancel";
+        case Op::Replace: return "replace";
+        case Op::Market:  return "market";
+    }
+    return "?";
+}
+
+// Minimal streaming JSON writer (objects, arrays, numbers, strings).
+class Json
+{
+    public:
+        explicit Json(FILE* f) : f_{f} {}
+
+        Json& begin_object(const char* key = nullptr) { open(key, '{'); return *this; }
+        Json& end_object() { close('}'); return *this; }
+        Json& begin_array(const char* key = nullptr) { open(key, '['); return *this; }
+        Json& end_array() { close(']'); return *this; }
+
+        Json& kv(const char* key, const std::string& v) { sep(key); std::fprintf(f_, "\"%s\"", v.c_str()); return *this; }
+        Json& kv(const char* key, const char* v) { return kv(key, std::string(v)); }
+        Json& kv(const char* key, double v) { sep(key); std::fprintf(f_, "%.6g", v); return *this; }
+        Json& kv(const char* key, uint64_t v) { sep(key); std::fprintf(f_, "%llu", static_cast<unsigned long long>(v)); return *this; }
+
+        void finish() { std::fputc('\n', f_); }
+
+    private:
+        void sep(const char* key)
+        {
+            if (!first_) std::fputc(',', f_);
+            first_ = false;
+            if (key) std::fprintf(f_, "\"%s\":", key);
+        }
+        void open(const char* key, char c) { sep(key); std::fputc(c, f_); first_ = true; }
+        void close(char c) { std::fputc(c, f_); first_ = false; }
+
+        FILE* f_;
+        bool first_{true};
+};
+
+inline void write_histogram(Json& j, const char* key, const LatencyHistogram& h, double cycles_per_ns_)
+{
+    auto ns = [&](uint64_t c) { return static_cast<double>(c) / cycles_per_ns_; };
+    j.begin_object(key)
+        .kv("count", h.count())
+        .kv("mean_ns", h.mean() / cycles_per_ns_)
+        .kv("p50_ns", ns(h.percentile(0.50)))
+        .kv("p99_ns", ns(h.percentile(0.99)))
+        .kv("p999_ns", ns(h.percentile(0.999)))
+        .kv("max_ns", ns(h.max()))
+        .end_object();
+}
+
+struct Args
+{
+    size_t messages{1'000'000};
+    uint64_t seed{1};
+    double seconds{1.0};        // simulated time per run (bench_sim)
+    std::string out;            // JSON path; empty = stdout
+};
+
+inline Args parse_args(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i < argc; ++i) {
+        const char* s = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!std::strcmp(s, "--messages") && v) { a.messages = std::strtoull(v, nullptr, 10); ++i; }
+        else if (!std::strcmp(s, "--seed") && v) { a.seed = std::strtoull(v, nullptr, 10); ++i; }
+        else if (!std::strcmp(s, "--seconds") && v) { a.seconds = std::strtod(v, nullptr); ++i; }
+        else if (!std::strcmp(s, "--out") && v) { a.out = v; ++i; }
+        else {
+            std::fprintf(stderr, "usage: %s [--messages N] [--seed S] [--seconds T] [--out file.json]\n", argv[0]);
+            std::exit(2);
+        }
+    }
+    return a;
+}
+
+inline FILE* open_out(const Args& a)
+{
+    if (a.out.empty()) return stdout;
+    FILE* f = std::fopen(a.out.c_str(), "w");
+    if (!f) { std::perror(a.out.c_str()); std::exit(1); }
+    return f;
+}
+
+inline BookConfig book_config(const Mix& mix)
+{
+    BookConfig cfg;
+    cfg.ladder = LadderConfig{100000, 1024, 256};
+    cfg.orders = mix.target_live * 2;
+    cfg.events = 1 << 14;
+    return cfg;
+}
+
+} // namespace bench
@@ -0,0 +1,154 @@
+// CSV I/O: order-log write and parse rates (MB/s, rows/s), parse + replay
+// into OrderBook, and event writing. Binary journal: append rate and mmap
+// replay rate. SQLite: trade rows/s through SqliteSink. A plain memchr line count over the same
+// mapping is reported as the bandwidth ceiling the parser is chasing.
+// The file is written to the temp directory and is page-cache hot when
+// parsed, so these are CPU-bound numbers.
+// JSON to stdout (or --out), human summary to stderr.
+#include "bench_common.hpp"
+#include "gen/poisson.hpp"
+#include "io/csv.hpp"
+#include "io/journal.hpp"
+#include "io/sqlite.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+using clk = std::chrono::steady_clock;
+
+static double secs_since(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+static void report(bench::Json& j, const char* name, double secs, double bytes, double rows)
+{
+    j.begin_object()
+        .kv("name", name)
+        .kv("seconds", secs)
+        .kv("mb_per_sec", bytes / secs / 1e6)
+        .kv("rows_per_sec", rows / secs)
+        .end_object();
+    std::fprintf(stderr, "%-16s %10.0f MB/s %12.0f rows/s\n", name, bytes / secs / 1e6, rows / secs);
+}
+
+int main(int argc, char** argv)
+{
+    const bench::Args args = bench::parse_args(argc, argv);
+    FILE* out = bench::open_out(args);
+    const std::string path = (std::filesystem::temp_directory_path() / "obsim_bench_io.csv").string();
+
+    std::vector<OrderMsg> msgs(args.messages);
+    gen::PoissonFlow flow(gen::FlowConfig{}, args.seed);
+    flow.fill(msgs);
+
+    bench::Json j(out);
+    j.begin_object().kv("benchmark", "io").kv("messages", static_cast<uint64_t>(args.messages));
+    j.begin_array("results");
+
+    // Write the order log.
+    double bytes = 0;
+    {
+        const auto t0 = clk::now();
+        io::CsvWriter w(path);
+        w.raw(io::kOrderHeader);
+        for (const OrderMsg& m : msgs) w.write(m);
+        w.flush();
+        bytes = static_cast<double>(w.bytes_written());
+        report(j, "write_orders", secs_since(t0), bytes, static_cast<double>(msgs.size()));
+    }
+    const double rows = static_cast<double>(msgs.size());
+
+    // Ceiling: just find every newline.
+    {
+        const auto t0 = clk::now();
+        io::MappedFile f(path);
+        size_t lines = 0;
+        for (const char* p = f.data(), *e = p + f.size();
+             const void* nl = std::memchr(p, '\n', static_cast<size_t>(e - p)); ++lines)
+            p = static_cast<const char*>(nl) + 1;
+        report(j, "scan_lines", secs_since(t0), bytes, static_cast<double>(lines));
+    }
+
+    // Parse into OrderMsg chunks.
+    std::vector<OrderMsg> chunk(4096);
+    {
+        const auto t0 = clk::now();
+        io::CsvOrderReader r(path);
+        size_t n = 0;
+        for (size_t k; (k = r.read(chunk)) != 0;) n += k;
+        report(j, "parse_orders", secs_since(t0), bytes, static_cast<double>(n));
+        if (n != msgs.size() || r.bad_lines()) std::fprintf(stderr, "parse mismatch: %zu rows, %zu bad\n", n, r.bad_lines());
+    }
+
+    // Parse and replay, writing every event back out.
+    {
+        const std::string ev_path = path + ".events";
+        const auto t0 = clk::now();
+        io::CsvOrderReader r(path);
+        io::CsvWriter w(ev_path);
+        w.raw(io::kEventHeader);
+        OrderBook ob("IO", 1, bench::book_config(bench::Mix{}));
+        std::vector<RejectReason> status(chunk.size());
+        for (size_t k; (k = r.read(chunk)) != 0;) {
+            ob.apply_batch(std::span(chunk).first(k), std::span(status).first(k));
+            ob.events().drain([&](const Event& e) { w.write(e); });
+        }
+        w.flush();
+        report(j, "replay_to_events", secs_since(t0), bytes, rows);
+        std::fprintf(stderr, "%-16s %10.1f MB of events\n", "", static_cast<double>(w.bytes_written()) / 1e6);
+        std::filesystem::remove(ev_path);
+    }
+
+    // Binary journal: append everything, then replay from the mapping.
+    {
+        const std::string jpath = path + ".journal";
+        const double jbytes = static_cast<double>(sizeof(io::JournalHeader) + msgs.size() * sizeof(OrderMsg));
+        {
+            const auto t0 = clk::now();
+            io::JournalWriter w(jpath, "IO", 1);
+            for (const OrderMsg& m : msgs) w.append(m);
+            w.flush();
+            report(j, "journal_append", secs_since(t0), jbytes, rows);
+        }
+        {
+            OrderBook ob("IO", 1, bench::book_config(bench::Mix{}));
+            const auto t0 = clk::now();
+            io::Journal jr(jpath);
+            io::replay(jr, ob);
+            report(j, "journal_replay", secs_since(t0), jbytes, rows);
+        }
+        std::filesystem::remove(jpath);
+    }
+
+    // Trades into SQLite: producer-side cost per row, and time until committed.
+    {
+        const std::string db_path = path + ".db";
+        std::filesystem::remove(db_path);
+        const size_t n = msgs.size();
+        double produce = 0, total = 0;
+        {
+            io::SqliteSink sink(db_path);
+            const auto t0 = clk::now();
+            for (size_t i = 0; i < n; ++i)
+                sink.write(Trade{i, i + 1, 100000 + static_cast<int64_t>(i % 64), 10, static_cast<int64_t>(i), (i & 1) != 0});
+            produce = secs_since(t0);
+            sink.flush();
+            total = secs_since(t0);
+        }
+        j.begin_object()
+            .kv("name", "sqlite_trades")
+            .kv("seconds", total)
+            .kv("rows_per_sec", static_cast<double>(n) / total)
+            .kv("producer_ns_per_row", produce * 1e9 / static_cast<double>(n))
+            .end_object();
+        std::fprintf(stderr, "%-16s %12.0f rows/s committed, %.1f ns/row on the producer\n", "sqlite_trades",
+                     static_cast<double>(n) / total, produce * 1e9 / static_cast<double>(n));
+        for (const char* suffix : {"", "-wal", "-shm"}) std::filesystem::remove(db_path + suffix);
+    }
+
+    std::filesystem::remove(path);
+    j.end_array().end_object().finish();
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
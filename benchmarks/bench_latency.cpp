@@ -0,0 +1,55 @@
+// Per-operation latency histograms (p50/p99/p99.9/max) for each message mix
+// and ladder, timed with the cycle counter around every single call.
+#include "bench_common.hpp"
+
+template <class Book>
+static void run(bench::Json& j, const std::string& name, const std::vector<bench::Msg>& flow,
+                const bench::Mix& mix, size_t warm)
+{
+    Book ob("BENCH", 1, bench::book_config(mix));
+    for (size_t i = 0; i < warm; ++i) bench::apply(ob, flow[i]);
+    ob.events().clear();
+
+    LatencyHistogram hist[4];
+    for (size_t i = warm; i < flow.size(); ++i) {
+        const uint64_t c0 = cycle_now();
+        bench::apply(ob, flow[i]);
+        const uint64_t c1 = cycle_now();
+        hist[static_cast<int>(flow[i].op)].record(c1 - c0);
+        if (ob.events().size() > 8192) ob.events().clear();
+    }
+
+    const double cpn = cycles_per_ns();
+    j.begin_object().kv("name", name);
+    for (int k = 0; k < 4; ++k) {
+        const auto op = static_cast<bench::Op>(k);
+        bench::write_histogram(j, bench::op_name(op), hist[k], cpn);
+        std::fprintf(stderr, "%-22s %-8s p50 %7.0f  p99 %7.0f  p99.9 %8.0f  max %9.0f ns\n",
+                     name.c_str(), bench::op_name(op),
+                     hist[k].percentile(0.50) / cpn, hist[k].percentile(0.99) / cpn,
+                     hist[k].percentile(0.999) / cpn, hist[k].max() / cpn);
+    }
+    j.end_object();
+}
+
+int main(int argc, char** argv)
+{
+    const bench::Args args = bench::parse_args(argc, argv);
+    FILE* out = bench::open_out(args);
+
+    bench::Json j(out);
+    j.begin_object().kv("benchmark", "latency").kv("messages", static_cast<uint64_t>(args.messages));
+    j.kv("cycles_per_ns", cycles_per_ns());
+    j.begin_array("results");
+
+    for (const bench::Mix& mix : bench::default_mixes()) {
+        const auto flow = bench::make_flow(args.messages, mix, args.seed);
+        const size_t warm = mix.target_live;
+        run<OrderBook>(j, std::string(mix.name) + "/map", flow, mix, warm);
+        run<ArrayOrderBook>(j, std::string(mix.name) + "/array", flow, mix, warm);
+    }
+
+    j.end_array().end_object().finish();
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
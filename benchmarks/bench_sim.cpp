@@ -0,0 +1,119 @@
+// Discrete-event kernel throughput (src/sim): events per second of wall time.
+//   timers  agents that only sleep: the cost of the heap and a coroutine resume
+//   trading agents quoting and taking on one book with jittered latencies,
+//           fills and quotes fed back to them
+// Each run covers --seconds of simulated time (default 1); --messages is unused.
+#include "bench_common.hpp"
+#include "sim/simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using clk = std::chrono::steady_clock;
+
+static void report(bench::Json& j, const char* kind, size_t agents, const sim::Simulation<ArrayOrderBook>& s,
+                   clk::duration wall)
+{
+    const double sec = std::chrono::duration<double>(wall).count();
+    const auto events = static_cast<double>(s.events_processed());
+    const std::string name = std::string(kind) + "/agents=" + std::to_string(agents);
+    j.begin_object()
+        .kv("name", name)
+        .kv("events", static_cast<uint64_t>(s.events_processed()))
+        .kv("seconds", sec)
+        .kv("events_per_sec", events / sec)
+        .kv("sim_seconds", static_cast<double>(s.now()) / 1e9)
+        .end_object();
+    std::fprintf(stderr, "%-8s %7zu %12.0f %9.3f %12.1f %9.1f\n", kind, agents, events, sec, events / sec / 1e6,
+                 static_cast<double>(s.now()) / 1e9);
+}
+
+static void timers(bench::Json& j, size_t agents, int64_t horizon_ns, uint64_t seed)
+{
+    sim::Simulation<ArrayOrderBook> s;
+    for (size_t i = 0; i < agents; ++i) {
+        sim::AgentConfig c;
+        c.seed = seed + i;
+        s.add_agent(c, [](sim::Agent<ArrayOrderBook>& a) -> sim::Task {
+            for (;;) co_await a.sleep(1 + static_cast<int64_t>(a.rng().below(1'000'000)));
+        });
+    }
+    const auto t0 = clk::now();
+    s.run(horizon_ns);
+    report(j, "timers", agents, s, clk::now() - t0);
+}
+
+// Half the agents keep a two-sided quote and requote after a random
+// interval or when one of their own orders fills, leaning the quote
+// toward the fill price; the other half take liquidity at random. Four
+// makers also follow the public quote, so quote fan-out stays bounded
+// instead of growing with the square of the agent count.
+static void trading(bench::Json& j, size_t agents, int64_t horizon_ns, uint64_t seed)
+{
+    sim::SimConfig sc;
+    sc.events = agents * 8;
+    sim::Simulation<ArrayOrderBook> s(sc);
+    const uint32_t book = s.add_book("SIM", 1);
+    for (size_t i = 0; i < agents; ++i) {
+        sim::AgentConfig c;
+        c.order_entry = {20'000, 30'000, sim::Latency::Jitter::Exponential};
+        c.market_data = {15'000, 10'000, sim::Latency::Jitter::Uniform};
+        c.processing_ns = 1'000;
+        c.start_ns = static_cast<int64_t>(i) * 100;
+        c.seed = seed + i;
+        if (i % 2 == 0) {
+            const bool follows = i < 8;
+            s.add_agent(c, [book, follows](sim::Agent<ArrayOrderBook>& a) -> sim::Task {
+                if (follows) a.subscribe(book);
+                int64_t mid = 100'000;
+                uint64_t bid = 0, ask = 0;
+                for (;;) {
+                    if (bid) a.cancel(book, bid);
+                    if (ask) a.cancel(book, ask);
+                    const int64_t off = 1 + static_cast<int64_t>(a.rng().below(5));
+                    bid = a.send(book, Order{.side = Side::Buy, .type = Type::Limit, .tif = TIF::Day, .px = mid - off, .qty = 10});
+                    ask = a.send(book, Order{.side = Side::Sell, .type = Type::Limit, .tif = TIF::Day, .px = mid + off, .qty = 10});
+                    const int64_t until = a.now() + static_cast<int64_t>(a.rng().exponential(5e6));
+                    for (;;) {
+                        const sim::Notice n = co_await a.next(std::max<int64_t>(0, until - a.now()));
+                        if (n.kind == sim::NoticeKind::Timer) break;
+                        if (n.kind == sim::NoticeKind::Fill) { mid = (mid + n.px) / 2; break; }
+                        if (n.kind == sim::NoticeKind::Quote && n.px && n.ask_px) mid = (n.px + n.ask_px) / 2;
+                    }
+                }
+            });
+        } else {
+            s.add_agent(c, [book](sim::Agent<ArrayOrderBook>& a) -> sim::Task {
+                for (;;) {
+                    co_await a.sleep(static_cast<int64_t>(a.rng().exponential(2e6)));
+                    const Side side = a.rng().below(2) ? Side::Buy : Side::Sell;
+                    a.send(book, Order{.side = side, .type = Type::Market, .tif = TIF::IOC, .qty = 5});
+                    while (a.pending()) co_await a.next();
+                }
+            });
+        }
+    }
+    const auto t0 = clk::now();
+    s.run(horizon_ns);
+    report(j, "trading", agents, s, clk::now() - t0);
+}
+
+int main(int argc, char** argv)
+{
+    const bench::Args args = bench::parse_args(argc, argv);
+    FILE* out = bench::open_out(args);
+    const auto horizon = static_cast<int64_t>(args.seconds * 1e9);
+
+    bench::Json j(out);
+    j.begin_object().kv("benchmark", "sim").kv("sim_seconds", args.seconds);
+    j.begin_array("results");
+    std::fprintf(stderr, "%-8s %7s %12s %9s %12s %9s\n", "kind", "agents", "events", "wall_s", "Mevents/s", "sim_s");
+    for (size_t n : {100u, 1000u, 10000u}) timers(j, n, horizon, args.seed);
+    for (size_t n : {100u, 1000u, 10000u}) trading(j, n, horizon, args.seed);
+    j.end_array().end_object().finish();
+
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Warm start: rebuilding a 1M-order book by replaying its journal versus
+// restoring it from a snapshot. The history holds the 1M orders that end up
+// resting plus kChurn short-lived orders (add then cancel) per resting one,
+// a modest stand-in for a trading day; replay time grows with history
+// while the snapshot only depends on what is left in the book.
+// JSON to stdout (or --out), human summary to stderr.
+#include "bench_common.hpp"
+#include "gen/rng.hpp"
+#include "io/journal.hpp"
+#include "io/snapshot.hpp"
+#include <chrono>
+#include <filesystem>
+
+using clk = std::chrono::steady_clock;
+
+static constexpr uint64_t kChurn = 4;
+
+static double secs_since(clk::time_point t0)
+{
+    return std::chrono::duration<double>(clk::now() - t0).count();
+}
+
+template <class Book>
+static void run(bench::Json& j, const char* ladder, const std::string& jpath, const std::string& spath, size_t orders)
+{
+    BookConfig cfg;
+    cfg.orders = orders;
+    cfg.ladder.base_px = 100000;
+
+    Book live("SNAP", 1, cfg);
+    const auto t0 = clk::now();
+    io::Journal jr(jpath);
+    io::replay(jr, live);
+    const double replay_s = secs_since(t0);
+
+    const auto t1 = clk::now();
+    io::save_snapshot(live, spath, jr.size());
+    const double save_s = secs_since(t1);
+
+    const auto t2 = clk::now();
+    Book back = io::load_snapshot<Book>(spath);
+    const double restore_s = secs_since(t2);
+    if (back.order_count() != live.order_count()) std::fprintf(stderr, "restore mismatch\n");
+
+    const std::string name = std::string("snapshot/") + ladder;
+    j.begin_object()
+        .kv("name", name)
+        .kv("orders", static_cast<uint64_t>(live.order_count()))
+        .kv("replay_ms", replay_s * 1e3)
+        .kv("save_ms", save_s * 1e3)
+        .kv("restore_ms", restore_s * 1e3)
+        .kv("snapshot_mb", static_cast<double>(std::filesystem::file_size(spath)) / 1e6)
+        .kv("speedup", replay_s / restore_s)
+        .end_object();
+    std::fprintf(stderr, "%-16s %8zu orders  replay %8.1f ms  save %6.1f ms  restore %6.1f ms  (%.1fx)\n",
+                 name.c_str(), live.order_count(), replay_s * 1e3, save_s * 1e3, restore_s * 1e3, replay_s / restore_s);
+}
+
+int main(int argc, char** argv)
+{
+    bench::Args args = bench::parse_args(argc, argv);
+    FILE* out = bench::open_out(args);
+    const size_t orders = args.messages;       // default 1M
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string jpath = (dir / "obsim_bench_snapshot.journal").string();
+    const std::string spath = (dir / "obsim_bench_snapshot.snap").string();
+
+    // Non-crossing passive adds within +-500 ticks of 100000; each resting
+    // order is followed by kChurn orders that are added and cancelled again.
+    {
+        gen::Rng rng(args.seed);
+        io::JournalWriter w(jpath, "SNAP", 1);
+        uint64_t next_id = 1;
+        int64_t ts = 0;
+        auto add = [&] {
+            const uint64_t id = next_id++;
+            const Side side = (id & 1) ? Side::Buy : Side::Sell;
+            const int64_t off = 1 + static_cast<int64_t>(rng.below(500));
+            const int64_t px = side == Side::Buy ? 100000 - off : 100000 + off;
+            w.add(Order{id, side, Type::Limit, TIF::Day, px, 1 + static_cast<int64_t>(rng.below(100)), ++ts, false});
+            return id;
+        };
+        for (size_t i = 0; i < orders; ++i) {
+            add();
+            uint64_t tmp[kChurn];
+            for (uint64_t& id : tmp) id = add();
+            for (uint64_t id : tmp) w.cancel(id, ++ts);
+        }
+    }
+
+    bench::Json j(out);
+    j.begin_object().kv("benchmark", "snapshot").kv("messages", static_cast<uint64_t>(orders * (1 + 2 * kChurn)));
+    j.begin_array("results");
+    run<OrderBook>(j, "map", jpath, spath, orders);
+    run<ArrayOrderBook>(j, "array", jpath, spath, orders);
+    j.end_array().end_object().finish();
+
+    std::filesystem::remove(jpath);
+    std::filesystem::remove(spath);
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
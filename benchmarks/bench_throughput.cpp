@@ -0,0 +1,175 @@
+// Messages per second for OrderBook under each message mix and ladder, for
+// Poisson flow (src/gen) fed through apply_batch (also with quiet-policy,
+// instrumented and top-of-book publishing books, and with self-trade
+// prevention on a flow owned by 64 accounts), and for the sharded
+// multi-symbol Engine at 1..N worker threads.
+// JSON to stdout (or --out), human summary to stderr.
+#include "bench_common.hpp"
+#include "engine/engine.hpp"
+#include "gen/poisson.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using clk = std::chrono::steady_clock;
+
+// No event sink, no input validation: the generator only emits valid adds.
+using QuietArrayBook = BasicOrderBook<ArrayLadder, Policies<NullSink, NoStp, TrustedInput>>;
+
+template <class Book>
+static double run(const std::vector<bench::Msg>& flow, const bench::Mix& mix, size_t warm)
+{
+    Book ob("BENCH", 1, bench::book_config(mix));
+    for (size_t i = 0; i < warm; ++i) bench::apply(ob, flow[i]);
+    ob.events().clear();
+
+    const auto t0 = clk::now();
+    for (size_t i = warm; i < flow.size(); ++i) {
+        bench::apply(ob, flow[i]);
+        if (ob.events().size() > 8192) ob.events().clear();
+    }
+    const auto t1 = clk::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+// Poisson flow applied in batches of 1024 messages.
+template <class Book>
+static double run_batched(const std::vector<OrderMsg>& flow, size_t warm)
+{
+    Book ob("BENCH", 1, bench::book_config(bench::Mix{}));
+    std::vector<RejectReason> status(1024);
+    const std::span<const OrderMsg> all(flow);
+    ob.apply_batch(all.first(warm), std::span(status).first(warm < 1024 ? warm : 1024));
+    ob.events().clear();
+
+    const auto t0 = clk::now();
+    for (size_t i = warm; i < flow.size(); i += 1024) {
+        const size_t n = std::min<size_t>(1024, flow.size() - i);
+        ob.apply_batch(all.subspan(i, n), std::span(status).first(n));
+        ob.events().clear();
+    }
+    const auto t1 = clk::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+// One producer thread per worker, each feeding its own slice of the symbols
+// (so per-symbol order is preserved); timed until every queue is drained.
+static double run_engine(size_t workers, size_t symbols, size_t messages, uint64_t seed)
+{
+    EngineConfig cfg;
+    cfg.workers = workers;
+    cfg.book = bench::book_config(bench::Mix{});
+    Engine eng(cfg);
+    for (size_t s = 0; s < symbols; ++s) eng.add_symbol("SYM" + std::to_string(s), 1);
+
+    const size_t producers = workers;
+    std::vector<std::vector<Command>> feeds(producers);
+    for (size_t p = 0; p < producers; ++p) {
+        std::vector<uint32_t> mine;
+        for (size_t s = p; s < symbols; s += producers) mine.push_back(static_cast<uint32_t>(s));
+        for (const bench::Msg& m : bench::make_flow(messages / producers, bench::Mix{}, seed + p)) {
+            Command c;
+            c.symbol = mine[m.o.id % mine.size()];
+            c.kind = m.op == bench::Op::Cancel ? CmdKind::Cancel
+                   : m.op == bench::Op::Replace ? CmdKind::Replace : CmdKind::Add;
+            c.o = m.o;
+            feeds[p].push_back(c);
+        }
+    }
+
+    eng.start();
+    const auto t0 = clk::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+        threads.emplace_back([&, p] { for (const Command& c : feeds[p]) eng.submit(c); });
+    for (auto& t : threads) t.join();
+    eng.stop();
+    const auto t1 = clk::now();
+    return static_cast<double>(eng.processed()) / std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv)
+{
+    const bench::Args args = bench::parse_args(argc, argv);
+    FILE* out = bench::open_out(args);
+
+    bench::Json j(out);
+    j.begin_object().kv("benchmark", "throughput").kv("messages", static_cast<uint64_t>(args.messages));
+    j.begin_array("results");
+
+    for (const bench::Mix& mix : bench::default_mixes()) {
+        const auto flow = bench::make_flow(args.messages, mix, args.seed);
+        const size_t warm = mix.target_live;
+        const double n = static_cast<double>(flow.size() - warm);
+
+        struct { const char* ladder; double secs; } runs[] = {
+            {"map",   run<OrderBook>(flow, mix, warm)},
+            {"array", run<ArrayOrderBook>(flow, mix, warm)},
+        };
+        for (const auto& r : runs) {
+            const std::string name = std::string(mix.name) + "/" + r.ladder;
+            j.begin_object()
+                .kv("name", name)
+                .kv("seconds", r.secs)
+                .kv("msgs_per_sec", n / r.secs)
+                .kv("ns_per_msg", r.secs * 1e9 / n)
+                .end_object();
+            std::fprintf(stderr, "%-22s %12.0f msg/s %8.1f ns/msg\n", name.c_str(), n / r.secs, r.secs * 1e9 / n);
+        }
+    }
+
+    // Generator speed on its own, then the same flow through both ladders.
+    {
+        std::vector<OrderMsg> flow(args.messages);
+        gen::PoissonFlow gen_flow(gen::FlowConfig{}, args.seed);
+        const auto t0 = clk::now();
+        gen_flow.fill(flow);
+        const double gen_secs = std::chrono::duration<double>(clk::now() - t0).count();
+        const double n = static_cast<double>(flow.size());
+        j.begin_object().kv("name", "gen/poisson").kv("seconds", gen_secs).kv("msgs_per_sec", n / gen_secs).end_object();
+        std::fprintf(stderr, "%-22s %12.0f msg/s\n", "gen/poisson", n / gen_secs);
+
+        // Same rates, every add owned by one of 64 accounts.
+        std::vector<OrderMsg> owned(args.messages);
+        gen::FlowConfig owned_cfg;
+        owned_cfg.accounts = 64;
+        gen::PoissonFlow(owned_cfg, args.seed).fill(owned);
+
+        const size_t warm = std::min<size_t>(1024, flow.size());
+        const double m = static_cast<double>(flow.size() - warm);
+        struct { const char* name; double secs; } runs[] = {
+            {"poisson_batch/map",   run_batched<OrderBook>(flow, warm)},
+            {"poisson_batch/array", run_batched<ArrayOrderBook>(flow, warm)},
+            {"poisson_batch/array+quiet", run_batched<QuietArrayBook>(flow, warm)},
+            {"poisson_batch/array+metrics", run_batched<InstrumentedArrayOrderBook>(flow, warm)},
+            {"poisson_batch/array+top5", run_batched<PublishingArrayOrderBook<5>>(flow, warm)},
+            {"poisson_batch/array+accounts", run_batched<ArrayOrderBook>(owned, warm)},
+            {"poisson_batch/array+stp", run_batched<StpArrayOrderBook<StpAction::CancelResting>>(owned, warm)},
+        };
+        for (const auto& r : runs) {
+            j.begin_object()
+                .kv("name", r.name)
+                .kv("seconds", r.secs)
+                .kv("msgs_per_sec", m / r.secs)
+                .kv("ns_per_msg", r.secs * 1e9 / m)
+                .end_object();
+            std::fprintf(stderr, "%-28s %12.0f msg/s %8.1f ns/msg\n", r.name, m / r.secs, r.secs * 1e9 / m);
+        }
+    }
+
+    // Engine scaling: 64 symbols spread over 1, 2, 4 ... hardware threads.
+    const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t w = 1; w < hw; w *= 2) counts.push_back(w);
+    counts.push_back(hw);
+    for (size_t w : counts) {
+        const double rate = run_engine(w, 64, args.messages * 4, args.seed);
+        const std::string name = "engine/workers=" + std::to_string(w);
+        j.begin_object().kv("name", name).kv("msgs_per_sec", rate).end_object();
+        std::fprintf(stderr, "%-22s %12.0f msg/s\n", name.c_str(), rate);
+    }
+
+    j.end_array().end_object().finish();
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,102 @@
+"""Reading book instrumentation (src/ob/metrics.hpp) from Python.
+
+Only the Instrumented* books collect metrics; OrderBook / ArrayOrderBook are
+built without them and pay nothing.
+
+    import metrics
+    book = obsim.InstrumentedOrderBook("SYM", 1)
+    metrics.drive(book, obsim.PoissonFlow().fill(1_000_000))
+    snap = metrics.snapshot(book)                 # plain dict, latencies in ns
+    metrics.report(snap)
+
+From the command line, drive an instrumented book with synthetic flow:
+
+    python metrics.py [--messages 1000000] [--array] [--seed 1]
+"""
+import argparse
+
+import obsim
+
+OPS = {"add": obsim.BookOp.Add, "cancel": obsim.BookOp.Cancel,
+       "replace": obsim.BookOp.Replace, "match": obsim.BookOp.Match}
+QUANTILES = (0.5, 0.9, 0.99, 0.999)
+COUNTERS = ("adds", "accepted", "cancels", "replaces", "fills", "filled_qty",
+            "aggressive", "levels_created", "levels_destroyed")
+CHUNK = 4096    # messages per apply_batch, as io::replay
+
+
+def drive(book, msgs, chunk=CHUNK):
+    """apply_batch msgs in chunks, dropping events after each one.
+
+    One big batch would leave every event of the run in the ring, and its
+    growth (reallocation and copying) would land in the latencies measured.
+    """
+    for i in range(0, len(msgs), chunk):
+        book.apply_batch(msgs[i:i + chunk], keep_events=False)
+
+
+def histogram(h, scale=1.0):
+    """Summary of one LatencyHistogram; values divided by scale (cycles -> ns)."""
+    out = {"count": h.count, "min": h.min / scale, "max": h.max / scale, "mean": h.mean / scale}
+    for q in QUANTILES:
+        out[f"p{q * 100:g}"] = h.percentile(q) / scale
+    return out
+
+
+def snapshot(book):
+    """Counters, rejects by reason, per-op latency (ns) and sweep depth as a dict."""
+    m = book.metrics()
+    c = m.counters
+    cpn = obsim.cycles_per_ns()
+    rejects = {}
+    for reason, n in zip(obsim.RejectReason.__members__.values(), c.rejects):
+        if n:
+            rejects[reason.name] = n
+    return {
+        "counters": {k: getattr(c, k) for k in COUNTERS},
+        "rejects": rejects,
+        "latency_ns": {name: histogram(m.latency(op), cpn) for name, op in OPS.items()},
+        "sweep_depth": histogram(m.sweep_depth),
+    }
+
+
+def latency_buckets(book, op="add"):
+    """(upper_bound_ns, count) arrays of the non-empty buckets for one op, for plotting."""
+    upper, counts = book.metrics().latency(OPS[op]).buckets()
+    return upper / obsim.cycles_per_ns(), counts
+
+
+def diff(after, before):
+    """Counter deltas between two snapshot() dicts (latency is cumulative; reset instead)."""
+    return {k: after["counters"][k] - before["counters"][k] for k in COUNTERS}
+
+
+def report(snap, out=print):
+    for k, v in snap["counters"].items():
+        out(f"{k:<18} {v:>14,}")
+    for k, v in snap["rejects"].items():
+        out(f"reject/{k:<11} {v:>14,}")
+    out(f"{'op':<10}{'count':>12}{'mean':>10}" + "".join(f"{'p' + format(q * 100, 'g'):>10}" for q in QUANTILES)
+        + f"{'max':>12}   (ns)")
+    for name, h in snap["latency_ns"].items():
+        out(f"{name:<10}{h['count']:>12,}{h['mean']:>10.1f}"
+            + "".join(f"{h['p' + format(q * 100, 'g')]:>10.1f}" for q in QUANTILES) + f"{h['max']:>12.1f}")
+    s = snap["sweep_depth"]
+    out(f"sweep depth: mean {s['mean']:.2f} levels, p99 {s['p99']:g}, max {s['max']:g}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--messages", type=int, default=1_000_000)
+    ap.add_argument("--array", action="store_true", help="use the dense array ladder")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    cls = obsim.InstrumentedArrayOrderBook if args.array else obsim.InstrumentedOrderBook
+    book = cls("SIM", 1)
+    drive(book, obsim.PoissonFlow(obsim.FlowConfig(), args.seed).fill(args.messages))
+    report(snapshot(book))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+"""Deterministic replay of binary order journals (src/io/journal.hpp).
+
+A journal holds every add/cancel/replace a book received, as fixed-width
+records. Replaying it into a fresh book reproduces the original run exactly.
+
+    import replay
+    book = replay.replay("run.journal")              # OrderBook at the end of the run
+    recs = replay.load("run.journal")                # structured NumPy view, no copy
+    replay.record("copy.journal", "SYM", 1, recs)    # write records back out
+
+From the command line:
+
+    python replay.py run.journal [--array] [--depth 5]
+"""
+import argparse
+
+import numpy as np
+
+import obsim
+
+KINDS = {0: "add", 1: "cancel", 2: "replace"}
+
+
+def load(path):
+    """Records of a journal as a read-only order_msg_dtype array over the file mapping."""
+    return obsim.Journal(path).records()
+
+
+def header(path):
+    j = obsim.Journal(path)
+    return {"symbol": j.symbol, "tick": j.tick, "version": j.version, "records": len(j)}
+
+
+def record(path, symbol, tick, msgs):
+    """Write an order_msg_dtype array (or anything convertible to one) as a journal."""
+    msgs = np.ascontiguousarray(msgs, dtype=obsim.order_msg_dtype())
+    with obsim.JournalWriter(path, symbol, tick) as w:
+        w.append(msgs)
+    return len(msgs)
+
+
+def replay(path, book=None, array_ladder=False, batch=None):
+    """Drive a book from a journal and return it.
+
+    With batch=None the whole journal is fed in C++ (Book.replay).
+    With batch=N the records are pushed through Book.apply_batch N at a time and
+    per-message status codes are returned alongside the book. Events are
+    dropped after each batch either way, so memory stays flat however long
+    the journal is.
+    """
+    j = obsim.Journal(path)
+    if book is None:
+        cls = obsim.ArrayOrderBook if array_ladder else obsim.OrderBook
+        book = cls(j.symbol, j.tick)
+    if batch is None:
+        book.replay(j)
+        return book
+
+    recs = j.records()
+    status = np.empty(len(recs), dtype=np.uint8)
+    for i in range(0, len(recs), batch):
+        book.apply_batch(recs[i:i + batch], status[i:i + batch], keep_events=False)
+    return book, status
+
+
+def summary(recs):
+    """Message counts by kind."""
+    kinds, counts = np.unique(recs["kind"], return_counts=True)
+    return {KINDS.get(int(k), str(k)): int(c) for k, c in zip(kinds, counts)}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("journal")
+    ap.add_argument("--array", action="store_true", help="use the dense array ladder")
+    ap.add_argument("--depth", type=int, default=5)
+    args = ap.parse_args()
+
+    print(header(args.journal))
+    print(summary(load(args.journal)))
+    book = replay(args.journal, array_ladder=args.array)
+    for name, side in (("asks", reversed(book.asks(args.depth))), ("bids", book.bids(args.depth))):
+        print(name)
+        for lvl in side:
+            print(f"  {lvl.px:>12} {lvl.qty:>10} ({lvl.orders})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+# Build the benchmarks in Release, run them, write JSON results and
+# optionally diff them against a saved baseline.
+#
+#   scripts/run_benchmarks.sh                    # run, results in bench_results/
+#   scripts/run_benchmarks.sh --save-baseline    # run and store as the baseline
+#   scripts/run_benchmarks.sh --messages 200000  # smaller run
+#
+# Comparison: every numeric field of every result is diffed against
+# bench_results/baseline/<bench>.json when that file exists.
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD="${BUILD_DIR:-$ROOT/build-bench}"
+RESULTS="${RESULTS_DIR:-$ROOT/bench_results}"
+MESSAGES=1000000
+SAVE_BASELINE=0
+
+while [[ $# -gt 0 ]]; do
+  case "$1" in
+    --save-baseline) SAVE_BASELINE=1 ;;
+    --messages) MESSAGES="$2"; shift ;;
+    *) echo "unknown option: $1" >&2; exit 2 ;;
+  esac
+  shift
+done
+
+cmake -S "$ROOT" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release -DOBSIM_BUILD_BENCHMARKS=ON >/dev/null
+cmake --build "$BUILD" -j"$(nproc)" --target bench_throughput bench_latency >/dev/null
+
+mkdir -p "$RESULTS/baseline"
+for b in bench_throughput bench_latency; do
+  echo "== $b" >&2
+  "$BUILD/$b" --messages "$MESSAGES" --out "$RESULTS/$b.json"
+  if [[ $SAVE_BASELINE -eq 1 ]]; then
+    cp "$RESULTS/$b.json" "$RESULTS/baseline/$b.json"
+  elif [[ -f "$RESULTS/baseline/$b.json" ]]; then
+    python3 - "$RESULTS/baseline/$b.json" "$RESULTS/$b.json" <<'PY'
+import json, sys
+
+def flatten(node, prefix=""):
+    out = {}
+    if isinstance(node, dict):
+        for k, v in node.items():
+            if k == "name":
+                continue
+            out.update(flatten(v, f"{prefix}.{k}" if prefix else k))
+    elif isinstance(node, (int, float)):
+        out[prefix] = float(node)
+    return out
+
+def index(path):
+    doc = json.load(open(path))
+    return {r["name"]: flatten(r) for r in doc["results"]}
+
+base, cur = index(sys.argv[1]), index(sys.argv[2])
+print(f"{'result':<26} {'metric':<22} {'baseline':>12} {'current':>12} {'delta':>8}")
+for name in sorted(cur):
+    for metric, v in sorted(cur[name].items()):
+        b = base.get(name, {}).get(metric)
+        if b is None or metric.endswith("count") or metric == "seconds":
+            continue
+        delta = (v - b) / b * 100 if b else 0.0
+        print(f"{name:<26} {metric:<22} {b:>12.1f} {v:>12.1f} {delta:>+7.1f}%")
+PY
+  fi
+done
+echo "results in $RESULTS" >&2
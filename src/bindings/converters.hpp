@@ -0,0 +1,112 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "ob/book.hpp"
+#include "ob/impact.hpp"
+#include "ob/order.hpp"
+
+// C++ containers -> NumPy without per-element Python objects.
+//
+// Structured arrays (level_dtype / trade_dtype / event_dtype, registered in py_module.cpp)
+// adopt the std::vector the book filled: the array owns it through a capsule
+// and frees it when the last view goes away, so nothing is copied or boxed.
+// The depth matrix is written by the book walk straight into the array.
+
+namespace py = pybind11;
+
+namespace conv {
+
+// Hand v's buffer to a 1-D array; v is moved to the heap and owned by the array.
+template <class T>
+py::array_t<T> to_numpy(std::vector<T>&& v)
+{
+  auto* owned = new std::vector<T>(std::move(v));
+  py::capsule free_when_done(owned, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+  return py::array_t<T>(static_cast<py::ssize_t>(owned->size()), owned->data(), free_when_done);
+}
+
+// Top `depth` levels of one side, best first, as a level_dtype array.
+template <class Book>
+py::array_t<LevelView> levels(const Book& ob, Side side, int depth)
+{
+  return to_numpy(side == Side::Buy ? ob.bids(depth) : ob.asks(depth));
+}
+
+// Drains the event ring; the trades in it as a trade_dtype array.
+template <class Book>
+py::array_t<Trade> pop_trades(Book& ob)
+{
+  return to_numpy(ob.pop_trade());
+}
+
+// Drains the event ring, oldest first, as an event_dtype array.
+template <class Book>
+py::array_t<Event> pop_events(Book& ob)
+{
+  std::vector<Event> out;
+  out.reserve(ob.events().size());
+  ob.events().drain([&](const Event& e) { out.push_back(e); });
+  return to_numpy(std::move(out));
+}
+
+// int64 array of shape (2, levels, 3): [side][level] = [px, qty, orders],
+// side 0 = bids, 1 = asks, best first. Rows past a side's depth are zero,
+// so a stack of matrices taken over time is rectangular.
+template <class Book>
+py::array_t<int64_t> depth_matrix(const Book& ob, size_t levels)
+{
+  const auto n = static_cast<py::ssize_t>(levels);
+  py::array_t<int64_t> out({py::ssize_t{2}, n, py::ssize_t{3}});
+  int64_t* p = out.mutable_data();
+  std::fill_n(p, 2 * levels * 3, int64_t{0});
+  if (levels == 0) return out;
+
+  for (Side side : {Side::Buy, Side::Sell}) {
+    int64_t* row = p + (side == Side::Buy ? 0 : levels * 3);
+    const int64_t* end = row + levels * 3;
+    ob.for_each_level(side, [&](const Level& l) {
+      row[0] = l.px;
+      row[1] = l.total_qty();
+      row[2] = static_cast<int64_t>(l.count());
+      row += 3;
+      return row != end;
+    });
+  }
+  return out;
+}
+
+// Vectorised DepthCurve::fill: one row per requested qty, columns as a dict
+// of arrays (qty, notional, vwap, worst_px, levels), like run_scenarios().
+inline py::dict fill_estimates(const DepthCurve& c, py::array_t<int64_t, py::array::c_style | py::array::forcecast> qtys)
+{
+  const auto n = static_cast<size_t>(qtys.size());
+  std::vector<int64_t> qty(n), worst(n);
+  std::vector<double> notional(n), vwap(n);
+  std::vector<uint64_t> levels(n);
+  const int64_t* in = qtys.data();
+  {
+    py::gil_scoped_release nogil;
+    for (size_t i = 0; i < n; ++i) {
+      const FillEstimate f = c.fill(in[i]);
+      qty[i] = f.qty;
+      notional[i] = f.notional;
+      vwap[i] = f.vwap();
+      worst[i] = f.worst_px;
+      levels[i] = f.levels;
+    }
+  }
+  py::dict out;
+  out["qty"] = to_numpy(std::move(qty));
+  out["notional"] = to_numpy(std::move(notional));
+  out["vwap"] = to_numpy(std::move(vwap));
+  out["worst_px"] = to_numpy(std::move(worst));
+  out["levels"] = to_numpy(std::move(levels));
+  return out;
+}
+
+} // namespace conv
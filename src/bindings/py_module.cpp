@@ -1,17 +1,173 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
+#include "bindings/converters.hpp"
+#include "engine/scenarios.hpp"
+#include "gen/poisson.hpp"
+#include "io/journal.hpp"
+#include "io/snapshot.hpp"
 #include "ob/book.hpp"
+#include "ob/msg.hpp"
 #include "ob/order.hpp"
 
 
 namespace py = pybind11;
 
+// Same Python surface for every ladder instantiation.
+//
+// A Book is not thread-safe, so every method that touches one keeps the GIL:
+// with it released, another Python thread could mutate or read the same
+// book mid-call. Only calls that work on a book no one else can see yet
+// (load_snapshot) let it go.
+template <class Book>
+static void bind_book(py::module_& m, const char* name)
+{
+  py::class_<Book> cls(m, name);
+  cls
+    .def(py::init<std::string, int64_t>())
+    .def(py::init<std::string, int64_t, const BookConfig&>())
+    .def("add", py::overload_cast<const Order&>(&Book::add))
+    .def("cancel", &Book::cancel)
+    .def("replace", &Book::replace)
+    .def("bids", &Book::bids)
+    .def("asks", &Book::asks)
+    .def("pop_trade", &Book::pop_trade)
+    // NumPy forms of the above, no Python object per level / trade:
+    // level_dtype and trade_dtype arrays, and the (2, levels, 3) int64
+    // depth matrix [bids, asks] x level x [px, qty, orders].
+    .def("bids_array", [](const Book& ob, int depth) { return conv::levels(ob, Side::Buy, depth); },
+         py::arg("depth"))
+    .def("asks_array", [](const Book& ob, int depth) { return conv::levels(ob, Side::Sell, depth); },
+         py::arg("depth"))
+    .def("pop_trades", &conv::pop_trades<Book>)
+    // Every pending event (event_dtype), or drop them all. The ring grows
+    // rather than losing events, so a loop that never drains it holds on to
+    // every Accept / LevelUpdate it caused.
+    .def("pop_events", &conv::pop_events<Book>)
+    .def("clear_events", [](Book& ob) { ob.events().clear(); })
+    .def("depth_matrix", &conv::depth_matrix<Book>, py::arg("levels"))
+    .def("begin_auction", &Book::begin_auction)
+    .def_property_readonly("in_auction", &Book::in_auction)
+    .def("auction_price", &Book::auction_price)
+    .def("uncross", &Book::uncross, py::arg("ts_ns"))
+    // GTD expiry and session-end bulk cancels; each returns the order count.
+    .def("advance_time", &Book::advance_time, py::arg("ts_ns"))
+    .def_property_readonly("expiry_count", &Book::expiry_count)
+    .def("cancel_day", &Book::cancel_day, py::arg("ts_ns"))
+    .def("cancel_side", &Book::cancel_side, py::arg("side"), py::arg("ts_ns"))
+    .def("cancel_beyond", &Book::cancel_beyond, py::arg("side"), py::arg("px"), py::arg("ts_ns"))
+    // Market impact of a taker on `side`, book unchanged. fill_estimates()
+    // takes an array of quantities and answers them all from one DepthCurve.
+    .def("fill_estimate", &Book::fill_estimate, py::arg("side"), py::arg("qty"))
+    .def("qty_up_to", &Book::qty_up_to, py::arg("side"), py::arg("px"))
+    .def("px_to_fill", &Book::px_to_fill, py::arg("side"), py::arg("qty"))
+    .def("depth_curve", &Book::depth_curve, py::arg("side"),
+         py::arg("max_levels") = std::numeric_limits<size_t>::max())
+    .def("fill_estimates",
+         [](const Book& ob, Side side, py::array_t<int64_t, py::array::c_style | py::array::forcecast> qtys) {
+           return conv::fill_estimates(ob.depth_curve(side), qtys);
+         },
+         py::arg("side"), py::arg("qtys"))
+    .def_property_readonly("symbol", &Book::symbol)
+    .def_property_readonly("tick", &Book::tick)
+    // Feed a whole journal through the book (events are discarded); returns
+    // the number of accepted messages.
+    .def("replay",
+         [](Book& ob, const io::Journal& j) { return io::replay(j, ob); },
+         py::arg("journal"))
+    // Warm start: save_snapshot(path, journal_offset) / Book.load_snapshot(path).
+    .def("save_snapshot",
+         [](const Book& ob, const std::string& path, uint64_t journal_offset) {
+           io::save_snapshot(ob, path, journal_offset);
+         },
+         py::arg("path"), py::arg("journal_offset") = 0)
+    .def_static("load_snapshot",
+         [](const std::string& path, const BookConfig& cfg) {
+           py::gil_scoped_release nogil;
+           return io::load_snapshot<Book>(path, cfg);
+         },
+         py::arg("path"), py::arg("cfg") = BookConfig{})
+    .def_property_readonly("order_count", &Book::order_count)
+    .def_property_readonly("stop_count", &Book::stop_count)
+    .def_property_readonly("iceberg_count", &Book::iceberg_count)
+    .def_property_readonly("last_trade_px", &Book::last_trade_px)
+    // msgs: contiguous NumPy array of order_msg_dtype (no copy). status: optional
+    // preallocated uint8 array, filled with RejectReason codes (0 = accepted).
+    // The events the batch caused are dropped unless keep_events is set.
+    .def("apply_batch",
+         [](Book& ob, py::array_t<OrderMsg, py::array::c_style> msgs, py::object out, bool keep_events) {
+           const auto n = static_cast<size_t>(msgs.size());
+           py::array_t<uint8_t, py::array::c_style> status =
+             out.is_none() ? py::array_t<uint8_t, py::array::c_style>(static_cast<py::ssize_t>(n))
+                           : out.cast<py::array_t<uint8_t, py::array::c_style>>();
+           if (!out.is_none() && status.ptr() != out.ptr())
+             throw py::type_error("status must be a contiguous uint8 array");
+           if (static_cast<size_t>(status.size()) < n)
+             throw py::value_error("status array is shorter than msgs");
+
+           const OrderMsg* in = msgs.data();
+           auto* st = reinterpret_cast<RejectReason*>(status.mutable_data());
+           ob.apply_batch({in, n}, {st, n});
+           if (!keep_events) ob.events().clear();
+           return status;
+         },
+         py::arg("msgs"), py::arg("status") = py::none(), py::arg("keep_events") = false)
+    .def("last_reject", &Book::last_reject);
+
+  if constexpr (Book::Stp::enabled) {
+    // Per-account open qty / position (AccountStp).
+    cls.def("account", [](const Book& ob, uint32_t id) { return ob.stp().account(id); }, py::arg("id"))
+       .def_property_readonly("accounts", [](const Book& ob) { return ob.stp().accounts(); });
+  }
+
+  if constexpr (Book::Metrics::enabled) {
+    // Copy of the counters and histograms; see obsim/metrics.py.
+    cls.def("metrics", [](const Book& ob) { return ob.metrics(); })
+       .def("reset_metrics", &Book::reset_metrics);
+  }
+}
+
 PYBIND11_MODULE(obsim, m) {
+  PYBIND11_NUMPY_DTYPE(OrderMsg, id, px, qty, ts_ns, kind, side, type, tif, account);
+  PYBIND11_NUMPY_DTYPE(LevelView, px, qty, orders);
+  PYBIND11_NUMPY_DTYPE(Trade, taker_id, maker_id, px, qty, ts_ns, taker_is_buy);
+  PYBIND11_NUMPY_DTYPE(Event, id, maker_id, px, qty, ts_ns, orders, type, reason, side);
+
   py::enum_<Side>(m, "Side").value("Buy", Side::Buy).value("Sell", Side::Sell);
-  py::enum_<Type>(m, "Type").value("Limit", Type::Limit).value("Market", Type::Market);
+  py::enum_<Type>(m, "Type")
+    .value("Limit", Type::Limit).value("Market", Type::Market)
+    .value("Stop", Type::Stop).value("StopLimit", Type::StopLimit);
   py::enum_<TIF>(m, "TIF")
     .value("Day", TIF::Day).value("IOC", TIF::IOC)
-    .value("FOK", TIF::FOK).value("GTC", TIF::GTC);
+    .value("FOK", TIF::FOK).value("GTC", TIF::GTC)
+    .value("PostOnly", TIF::PostOnly).value("GTD", TIF::GTD);
+
+  py::enum_<MsgKind>(m, "MsgKind")
+    .value("Add", MsgKind::Add).value("Cancel", MsgKind::Cancel).value("Replace", MsgKind::Replace);
+
+  py::enum_<EventType>(m, "EventType")
+    .value("Accept", EventType::Accept).value("Reject", EventType::Reject)
+    .value("Trade", EventType::Trade).value("Cancel", EventType::Cancel)
+    .value("Replace", EventType::Replace).value("LevelUpdate", EventType::LevelUpdate)
+    .value("OrderAdded", EventType::OrderAdded).value("OrderReduced", EventType::OrderReduced)
+    .value("OrderRemoved", EventType::OrderRemoved).value("StopTriggered", EventType::StopTriggered)
+    .value("SelfTradePrevented", EventType::SelfTradePrevented).value("Expire", EventType::Expire);
+
+  py::enum_<RejectReason>(m, "RejectReason")
+    .value("None_", RejectReason::None).value("BadQty", RejectReason::BadQty)
+    .value("BadPrice", RejectReason::BadPrice).value("DuplicateId", RejectReason::DuplicateId)
+    .value("UnknownId", RejectReason::UnknownId).value("WouldCross", RejectReason::WouldCross)
+    .value("CannotFill", RejectReason::CannotFill).value("BadMessage", RejectReason::BadMessage)
+    .value("Auction", RejectReason::Auction).value("BadExpiry", RejectReason::BadExpiry)
+    .value("BadAccount", RejectReason::BadAccount);
+
+  // Structured dtype matching OrderMsg, for building apply_batch() input.
+  m.def("order_msg_dtype", [] { return py::dtype::of<OrderMsg>(); });
+  // Element types of Book.bids_array / asks_array and Book.pop_trades.
+  m.def("level_dtype", [] { return py::dtype::of<LevelView>(); });
+  m.def("trade_dtype", [] { return py::dtype::of<Trade>(); });
+  // Book.pop_events; type / reason / side hold EventType / RejectReason / Side codes.
+  m.def("event_dtype", [] { return py::dtype::of<Event>(); });
 
   py::class_<Order>(m, "Order")
     .def(py::init<>())
@@ -22,18 +178,253 @@ PYBIND11_MODULE(obsim, m) {
     .def_readwrite("px", &Order::px)
     .def_readwrite("qty", &Order::qty)
     .def_readwrite("ts_ns", &Order::ts_ns)
-    .def_readwrite("post_only", &Order::post_only);
+    .def_readwrite("post_only", &Order::post_only)
+    .def_readwrite("stop_px", &Order::stop_px)
+    .def_readwrite("display_qty", &Order::display_qty)
+    .def_readwrite("account", &Order::account)
+    .def_readwrite("expire_ns", &Order::expire_ns);
 
   py::class_<LevelView>(m, "LevelView")
     .def_readonly("px", &LevelView::px)
     .def_readonly("qty", &LevelView::qty)
     .def_readonly("orders", &LevelView::orders);
 
-  py::class_<OrderBook>(m, "OrderBook")
-    .def(py::init<std::string, int64_t>())
-    .def("add", &OrderBook::add)
-    .def("cancel", &OrderBook::cancel)
-    .def("replace", &OrderBook::replace)
-    .def("bids", &OrderBook::bids)
-    .def("asks", &OrderBook::asks);
+  py::class_<Trade>(m, "Trade")
+    .def_readonly("taker_id", &Trade::taker_id)
+    .def_readonly("maker_id", &Trade::maker_id)
+    .def_readonly("px", &Trade::px)
+    .def_readonly("qty", &Trade::qty)
+    .def_readonly("ts_ns", &Trade::ts_ns)
+    .def_readonly("taker_is_buy", &Trade::taker_is_buy);
+
+  py::class_<AuctionResult>(m, "AuctionResult")
+    .def_readonly("px", &AuctionResult::px)
+    .def_readonly("qty", &AuctionResult::qty)
+    .def_readonly("imbalance", &AuctionResult::imbalance);
+
+  py::class_<FillEstimate>(m, "FillEstimate")
+    .def_readonly("qty", &FillEstimate::qty)
+    .def_readonly("notional", &FillEstimate::notional)
+    .def_readonly("worst_px", &FillEstimate::worst_px)
+    .def_readonly("levels", &FillEstimate::levels)
+    .def_property_readonly("vwap", &FillEstimate::vwap);
+
+  // Scalar methods as on the book; fill() / qty_up_to() / px_to_fill() also
+  // broadcast over NumPy arrays.
+  py::class_<DepthCurve>(m, "DepthCurve")
+    .def_property_readonly("taker", &DepthCurve::taker)
+    .def_property_readonly("levels", &DepthCurve::levels)
+    .def_property_readonly("total_qty", &DepthCurve::total_qty)
+    .def("fill", &DepthCurve::fill, py::arg("qty"))
+    .def("fill", &conv::fill_estimates, py::arg("qtys"))
+    .def("qty_up_to", py::vectorize(&DepthCurve::qty_up_to), py::arg("px"))
+    .def("px_to_fill", py::vectorize(&DepthCurve::px_to_fill), py::arg("qty"));
+
+  py::class_<LadderConfig>(m, "LadderConfig")
+    .def(py::init<>())
+    .def_readwrite("base_px", &LadderConfig::base_px)
+    .def_readwrite("ticks", &LadderConfig::ticks)
+    .def_readwrite("max_ticks", &LadderConfig::max_ticks);
+
+  py::class_<BookConfig>(m, "BookConfig")
+    .def(py::init<>())
+    .def_readwrite("ladder", &BookConfig::ladder)
+    .def_readwrite("orders", &BookConfig::orders)
+    .def_readwrite("events", &BookConfig::events)
+    .def_readwrite("stops", &BookConfig::stops)
+    .def_readwrite("expiry_tick_ns", &BookConfig::expiry_tick_ns);
+
+  // ---- instrumentation (src/ob/metrics.hpp) ----
+  py::enum_<BookOp>(m, "BookOp")
+    .value("Add", BookOp::Add).value("Cancel", BookOp::Cancel)
+    .value("Replace", BookOp::Replace).value("Match", BookOp::Match);
+
+  m.def("cycles_per_ns", &cycles_per_ns);
+
+  py::class_<LatencyHistogram>(m, "LatencyHistogram")
+    .def_property_readonly("count", &LatencyHistogram::count)
+    .def_property_readonly("min", &LatencyHistogram::min)
+    .def_property_readonly("max", &LatencyHistogram::max)
+    .def_property_readonly("mean", &LatencyHistogram::mean)
+    .def("percentile", &LatencyHistogram::percentile, py::arg("q"))
+    // Non-empty buckets as (upper_bound, count) uint64 arrays.
+    .def("buckets", [](const LatencyHistogram& h) {
+      std::vector<uint64_t> upper, counts;
+      const auto& b = h.buckets();
+      for (size_t i = 0; i < b.size(); ++i) {
+        if (!b[i]) continue;
+        upper.push_back(LatencyHistogram::bucket_upper(i));
+        counts.push_back(b[i]);
+      }
+      return py::make_tuple(py::array_t<uint64_t>(static_cast<py::ssize_t>(upper.size()), upper.data()),
+                            py::array_t<uint64_t>(static_cast<py::ssize_t>(counts.size()), counts.data()));
+    });
+
+  py::class_<BookCounters>(m, "BookCounters")
+    .def_readonly("adds", &BookCounters::adds)
+    .def_readonly("accepted", &BookCounters::accepted)
+    .def_readonly("cancels", &BookCounters::cancels)
+    .def_readonly("replaces", &BookCounters::replaces)
+    .def_readonly("fills", &BookCounters::fills)
+    .def_readonly("filled_qty", &BookCounters::filled_qty)
+    .def_readonly("aggressive", &BookCounters::aggressive)
+    .def_readonly("levels_created", &BookCounters::levels_created)
+    .def_readonly("levels_destroyed", &BookCounters::levels_destroyed)
+    // Indexed by int(RejectReason).
+    .def_property_readonly("rejects", [](const BookCounters& c) {
+      return std::vector<uint64_t>(std::begin(c.rejects), std::end(c.rejects));
+    });
+
+  py::class_<MetricsSnapshot>(m, "MetricsSnapshot")
+    .def_readonly("counters", &MetricsSnapshot::counters)
+    .def_readonly("sweep_depth", &MetricsSnapshot::sweep_depth)
+    .def("latency", [](const MetricsSnapshot& s, BookOp op) { return s.latency[static_cast<size_t>(op)]; },
+         py::arg("op"));
+
+  bind_book<OrderBook>(m, "OrderBook");
+  bind_book<ArrayOrderBook>(m, "ArrayOrderBook");
+  bind_book<InstrumentedOrderBook>(m, "InstrumentedOrderBook");
+  bind_book<InstrumentedArrayOrderBook>(m, "InstrumentedArrayOrderBook");
+
+  // ---- self-trade prevention (src/ob/stp.hpp) ----
+  py::class_<AccountTally>(m, "AccountTally")
+    .def_readonly("open_buy", &AccountTally::open_buy)
+    .def_readonly("open_sell", &AccountTally::open_sell)
+    .def_readonly("position", &AccountTally::position)
+    .def_readonly("traded", &AccountTally::traded);
+
+  bind_book<StpOrderBook<StpAction::CancelIncoming>>(m, "StpOrderBook");             // cancel newest
+  bind_book<StpOrderBook<StpAction::CancelResting>>(m, "StpCancelOldestOrderBook");
+  bind_book<StpOrderBook<StpAction::Decrement>>(m, "StpDecrementOrderBook");
+
+  // ---- binary journal (src/io/journal.hpp) ----
+  py::class_<io::JournalWriter>(m, "JournalWriter")
+    .def(py::init<const std::string&, std::string_view, int64_t>(),
+         py::arg("path"), py::arg("symbol"), py::arg("tick"))
+    .def("add", &io::JournalWriter::add)
+    .def("cancel", &io::JournalWriter::cancel)
+    .def("replace", &io::JournalWriter::replace)
+    .def("append",
+         [](io::JournalWriter& w, py::array_t<OrderMsg, py::array::c_style> msgs) {
+           w.append(std::span<const OrderMsg>(msgs.data(), static_cast<size_t>(msgs.size())));
+         },
+         py::arg("msgs"))
+    .def("flush", &io::JournalWriter::flush)
+    .def("sync", &io::JournalWriter::sync)
+    .def_property_readonly("records", &io::JournalWriter::records)
+    .def("__enter__", [](io::JournalWriter& w) -> io::JournalWriter& { return w; },
+         py::return_value_policy::reference)
+    .def("__exit__", [](io::JournalWriter& w, py::args) { w.flush(); });
+
+  py::class_<io::Journal>(m, "Journal")
+    .def(py::init<const std::string&>(), py::arg("path"))
+    .def_property_readonly("symbol", [](const io::Journal& j) { return std::string(j.symbol()); })
+    .def_property_readonly("tick", &io::Journal::tick)
+    .def_property_readonly("version", &io::Journal::version)
+    .def("__len__", &io::Journal::size)
+    // Read-only order_msg_dtype view straight over the mapping; keeps the
+    // Journal alive for as long as the array is.
+    .def("records", [](py::object self) {
+      const auto& j = self.cast<const io::Journal&>();
+      const auto recs = j.records();
+      py::array_t<OrderMsg> view(static_cast<py::ssize_t>(recs.size()), recs.data(), self);
+      view.attr("setflags")(py::arg("write") = false);
+      return view;
+    });
+
+  // ---- synthetic flow (src/gen) ----
+  py::enum_<gen::SizeDist>(m, "SizeDist")
+    .value("Uniform", gen::SizeDist::Uniform).value("Geometric", gen::SizeDist::Geometric);
+
+  py::class_<gen::WalkConfig>(m, "WalkConfig")
+    .def(py::init<>())
+    .def_readwrite("start_px", &gen::WalkConfig::start_px)
+    .def_readwrite("tick", &gen::WalkConfig::tick)
+    .def_readwrite("moves_per_sec", &gen::WalkConfig::moves_per_sec)
+    .def_readwrite("drift", &gen::WalkConfig::drift)
+    .def_readwrite("floor_px", &gen::WalkConfig::floor_px);
+
+  py::class_<gen::FlowConfig>(m, "FlowConfig")
+    .def(py::init<>())
+    .def_readwrite("limit_buy_rate", &gen::FlowConfig::limit_buy_rate)
+    .def_readwrite("limit_sell_rate", &gen::FlowConfig::limit_sell_rate)
+    .def_readwrite("market_buy_rate", &gen::FlowConfig::market_buy_rate)
+    .def_readwrite("market_sell_rate", &gen::FlowConfig::market_sell_rate)
+    .def_readwrite("cancel_rate", &gen::FlowConfig::cancel_rate)
+    .def_readwrite("replace_rate", &gen::FlowConfig::replace_rate)
+    .def_readwrite("offset_mean_ticks", &gen::FlowConfig::offset_mean_ticks)
+    .def_readwrite("max_offset_ticks", &gen::FlowConfig::max_offset_ticks)
+    .def_readwrite("marketable_frac", &gen::FlowConfig::marketable_frac)
+    .def_readwrite("size_dist", &gen::FlowConfig::size_dist)
+    .def_readwrite("size_min", &gen::FlowConfig::size_min)
+    .def_readwrite("size_max", &gen::FlowConfig::size_max)
+    .def_readwrite("size_mean", &gen::FlowConfig::size_mean)
+    .def_readwrite("accounts", &gen::FlowConfig::accounts)
+    .def_readwrite("max_live", &gen::FlowConfig::max_live)
+    .def_readwrite("first_id", &gen::FlowConfig::first_id)
+    .def_readwrite("walk", &gen::FlowConfig::walk);
+
+  // fill(n) returns a fresh order_msg_dtype array ready for apply_batch().
+  py::class_<gen::PoissonFlow>(m, "PoissonFlow")
+    .def(py::init<const gen::FlowConfig&, uint64_t>(), py::arg("cfg") = gen::FlowConfig{}, py::arg("seed") = 1)
+    .def("fill",
+         [](gen::PoissonFlow& f, size_t n) {
+           py::array_t<OrderMsg> out(static_cast<py::ssize_t>(n));
+           OrderMsg* p = out.mutable_data();
+           {
+             py::gil_scoped_release nogil;
+             f.fill({p, n});
+           }
+           return out;
+         },
+         py::arg("n"))
+    .def_property_readonly("now_ns", &gen::PoissonFlow::now_ns)
+    .def_property_readonly("mid", &gen::PoissonFlow::mid)
+    .def_property_readonly("live", &gen::PoissonFlow::live);
+
+  // ---- scenario sweeps (src/engine/scenarios.hpp) ----
+  py::class_<Scenario>(m, "Scenario")
+    .def(py::init<>())
+    .def_readwrite("seed", &Scenario::seed)
+    .def_readwrite("messages", &Scenario::messages)
+    .def_readwrite("flow", &Scenario::flow)
+    .def_readwrite("book", &Scenario::book)
+    .def_readwrite("array_ladder", &Scenario::array_ladder)
+    .def_readwrite("latency", &Scenario::latency)
+    .def_readwrite("sample_every", &Scenario::sample_every);
+
+  // Runs the scenarios on every core (threads = 0) with the GIL released;
+  // returns {column name: NumPy array}, row i = scenarios[i].
+  m.def("run_scenarios",
+        [](const std::vector<Scenario>& scenarios, size_t threads) {
+          ScenarioResults r;
+          {
+            py::gil_scoped_release nogil;
+            r = run_scenarios(scenarios, threads);
+          }
+          py::dict out;
+          auto col = [&](const char* name, const auto& v) {
+            using T = typename std::decay_t<decltype(v)>::value_type;
+            out[name] = py::array_t<T>(static_cast<py::ssize_t>(v.size()), v.data());
+          };
+          col("accepted", r.accepted);
+          col("trades", r.trades);
+          col("volume", r.volume);
+          col("vwap", r.vwap);
+          col("last_px", r.last_px);
+          col("spread_mean", r.spread_mean);
+          col("spread_p50", r.spread_p50);
+          col("spread_p99", r.spread_p99);
+          col("spread_max", r.spread_max);
+          col("two_sided", r.two_sided);
+          col("resting", r.resting);
+          col("add_p50_ns", r.add_p50_ns);
+          col("add_p99_ns", r.add_p99_ns);
+          col("cancel_p50_ns", r.cancel_p50_ns);
+          col("cancel_p99_ns", r.cancel_p99_ns);
+          col("seconds", r.seconds);
+          col("worker", r.worker);
+          return out;
+        },
+        py::arg("scenarios"), py::arg("threads") = 0);
 }
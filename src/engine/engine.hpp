@@ -0,0 +1,202 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "engine/mpsc_queue.hpp"
+#include "ob/book.hpp"
+
+// Multi-symbol matching engine. Every symbol is owned by exactly one worker
+// thread (chosen by hashing its name), each worker drains its own lock-free
+// inbound queue, and books are never touched by more than one thread, so
+// there is no mutex anywhere on the order path.
+
+struct EngineConfig
+{
+    size_t workers{1};
+    bool pin_threads{true};          // pin worker i to core (first_core + i) % ncpu
+    size_t first_core{0};
+    size_t queue_capacity{1 << 16};  // per worker
+    BookConfig book{};
+};
+
+enum class CmdKind : uint8_t { Add, Cancel, Replace };
+
+// One inbound message. Cancel uses o.id / o.ts_ns; Replace also o.px / o.qty.
+struct Command
+{
+    uint32_t symbol{};
+    CmdKind kind{};
+    Order o{};
+};
+
+template <class Book>
+class BasicEngine
+{
+    public:
+        // Called on the owning worker thread after each command with that
+        // book's event ring; the sink drains it (or it is cleared afterwards).
+        using EventSink = std::function<void(uint32_t symbol, EventRing& events)>;
+
+        explicit BasicEngine(const EngineConfig& cfg, EventSink sink = {})
+            : cfg_{cfg}, sink_{std::move(sink)}
+        {
+            if (cfg_.workers == 0) cfg_.workers = 1;
+            for (size_t i = 0; i < cfg_.workers; ++i)
+                workers_.push_back(std::make_unique<Worker>(cfg_.queue_capacity));
+        }
+
+        ~BasicEngine() { stop(); }
+
+        BasicEngine(const BasicEngine&) = delete;
+        BasicEngine& operator=(const BasicEngine&) = delete;
+
+        // Register a symbol. Only before start(); returns its dense id.
+        uint32_t add_symbol(const std::string& name, int64_t tick)
+        {
+            if (running_) throw std::logic_error("add_symbol after start");
+            if (ids_.count(name)) throw std::invalid_argument("duplicate symbol " + name);
+            const auto id = static_cast<uint32_t>(books_.size());
+            books_.push_back(std::make_unique<Book>(name, tick, cfg_.book));
+            owner_.push_back(std::hash<std::string>{}(name) % workers_.size());
+            ids_.emplace(name, id);
+            return id;
+        }
+
+        // Dense id for name, or -1.
+        int64_t symbol_id(const std::string& name) const
+        {
+            auto it = ids_.find(name);
+            return it == ids_.end() ? int64_t{-1} : static_cast<int64_t>(it->second);
+        }
+
+        size_t symbols() const { return books_.size(); }
+        size_t workers() const { return workers_.size(); }
+        size_t worker_of(uint32_t symbol) const { return owner_[symbol]; }
+
+        void start()
+        {
+            if (running_) return;
+            running_ = true;
+            for (size_t i = 0; i < workers_.size(); ++i) {
+                Worker& w = *workers_[i];
+                w.stop.store(false, std::memory_order_relaxed);
+                w.thread = std::thread([this, i] { run(i); });
+            }
+        }
+
+        // Drains every queue, then joins the workers.
+        void stop()
+        {
+            if (!running_) return;
+            for (auto& w : workers_) w->stop.store(true, std::memory_order_release);
+            for (auto& w : workers_) w->thread.join();
+            running_ = false;
+        }
+
+        // Thread-safe; never blocks. False if the owning worker's queue is full.
+        // Throws std::out_of_range for an unregistered symbol.
+        bool try_submit(const Command& c) { return queue_for(c.symbol).try_push(c); }
+
+        // Spins (yielding) while the owning worker's queue is full.
+        void submit(const Command& c)
+        {
+            auto& q = queue_for(c.symbol);
+            while (!q.try_push(c)) std::this_thread::yield();
+        }
+
+        uint64_t processed() const
+        {
+            uint64_t n = 0;
+            for (const auto& w : workers_) n += w->processed.load(std::memory_order_relaxed);
+            return n;
+        }
+
+        // Direct book access. Only safe while the engine is stopped.
+        Book& book(uint32_t symbol) { return *books_[symbol]; }
+        const Book& book(uint32_t symbol) const { return *books_[symbol]; }
+
+    private:
+        struct Worker
+        {
+            explicit Worker(size_t cap) : queue{cap} {}
+            MpscQueue<Command> queue;
+            std::thread thread;
+            alignas(64) std::atomic<bool> stop{false};
+            alignas(64) std::atomic<uint64_t> processed{0};
+        };
+
+        // owner_ is fixed once start() runs, so reading it here is race-free.
+        MpscQueue<Command>& queue_for(uint32_t symbol)
+        {
+            if (symbol >= owner_.size())
+                throw std::out_of_range("unknown symbol id " + std::to_string(symbol));
+            return workers_[owner_[symbol]]->queue;
+        }
+
+        void run(size_t idx)
+        {
+            pin(idx);
+            Worker& w = *workers_[idx];
+            Command c;
+            uint64_t done = 0;
+            auto process = [&] {
+                Book& ob = *books_[c.symbol];
+                switch (c.kind) {
+                    case CmdKind::Add:     ob.add(c.o); break;
+                    case CmdKind::Cancel:  ob.cancel(c.o.id, c.o.ts_ns); break;
+                    case CmdKind::Replace: ob.replace(c.o.id, c.o.px, c.o.qty, c.o.ts_ns); break;
+                }
+                if (sink_) sink_(c.symbol, ob.events());
+                ob.events().clear();
+                w.processed.store(++done, std::memory_order_relaxed);
+            };
+            for (;;) {
+                if (w.queue.try_pop(c)) {
+                    process();
+                } else if (w.stop.load(std::memory_order_acquire)) {
+                    // Re-check after seeing stop: anything pushed before stop()
+                    // is visible now, so an empty queue here really is drained.
+                    if (!w.queue.try_pop(c)) return;
+                    process();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        void pin(size_t idx)
+        {
+#if defined(__linux__)
+            if (!cfg_.pin_threads) return;
+            const unsigned ncpu = std::thread::hardware_concurrency();
+            if (ncpu == 0) return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET((cfg_.first_core + idx) % ncpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)idx;
+#endif
+        }
+
+        EngineConfig cfg_;
+        EventSink sink_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::unique_ptr<Book>> books_;
+        std::vector<size_t> owner_;
+        std::unordered_map<std::string, uint32_t> ids_;
+        bool running_{false};
+};
+
+using Engine = BasicEngine<OrderBook>;
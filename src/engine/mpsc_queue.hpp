@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer / single-consumer queue (Vyukov's
+// sequence-numbered ring). Producers claim a slot with one CAS on the
+// enqueue counter; the single consumer never touches shared counters
+// except each cell's sequence word. Capacity is rounded up to a power of two.
+template <class T>
+class MpscQueue
+{
+    public:
+        explicit MpscQueue(size_t capacity)
+            : mask_{std::bit_ceil(capacity < 2 ? size_t{2} : capacity) - 1},
+              cells_{std::make_unique<Cell[]>(mask_ + 1)}
+        {
+            for (size_t i = 0; i <= mask_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        // Any thread. False if the queue is full.
+        bool try_push(const T& v)
+        {
+            size_t pos = enq_.load(std::memory_order_relaxed);
+            Cell* c;
+            for (;;) {
+                c = &cells_[pos & mask_];
+                const size_t seq = c->seq.load(std::memory_order_acquire);
+                const auto dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (dif == 0) {
+                    if (enq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (dif < 0) {
+                    return false;
+                } else {
+                    pos = enq_.load(std::memory_order_relaxed);
+                }
+            }
+            c->value = v;
+            c->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer thread only. False if the queue is empty.
+        bool try_pop(T& out)
+        {
+            Cell& c = cells_[deq_ & mask_];
+            const size_t seq = c.seq.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(deq_ + 1) < 0) return false;
+            out = c.value;
+            c.seq.store(deq_ + mask_ + 1, std::memory_order_release);
+            ++deq_;
+            return true;
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> seq{0};
+            T value{};
+        };
+
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<size_t> enq_{0};
+        alignas(64) size_t deq_{0};
+};
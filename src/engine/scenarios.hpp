@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "engine/work_stealing.hpp"
+#include "gen/poisson.hpp"
+#include "ob/book.hpp"
+
+// Many independent simulations at once: each Scenario drives its own book
+// with its own PoissonFlow on one worker of a WorkStealingPool, and leaves
+// one row of summary metrics in a columnar ScenarioResults (one vector per
+// metric, row i = scenario i), ready to hand to NumPy without reshaping.
+// Results depend only on the scenario, never on the thread count.
+
+struct Scenario
+{
+    uint64_t seed{1};
+    size_t messages{100'000};
+    gen::FlowConfig flow{};         // flow.walk.tick is also the book's tick
+    BookConfig book{};
+    bool array_ladder{false};       // ArrayOrderBook instead of OrderBook
+    bool latency{true};             // instrumented book: per-op latency columns
+    size_t sample_every{64};        // messages between spread samples
+};
+
+struct ScenarioResults
+{
+    std::vector<uint64_t> accepted;         // messages the book accepted
+    std::vector<uint64_t> trades;
+    std::vector<int64_t> volume;            // traded qty
+    std::vector<double> vwap;               // NaN without trades
+    std::vector<int64_t> last_px;           // last trade price, 0 = none
+    std::vector<double> spread_mean;        // ticks, over samples with both sides quoted
+    std::vector<uint64_t> spread_p50;
+    std::vector<uint64_t> spread_p99;
+    std::vector<uint64_t> spread_max;
+    std::vector<double> two_sided;          // fraction of samples with both sides quoted
+    std::vector<uint64_t> resting;          // orders left in the book
+    std::vector<double> add_p50_ns;         // latency columns: NaN unless Scenario::latency
+    std::vector<double> add_p99_ns;
+    std::vector<double> cancel_p50_ns;
+    std::vector<double> cancel_p99_ns;
+    std::vector<double> seconds;            // wall time of the scenario, generation included
+    std::vector<uint32_t> worker;           // pool worker that ran it
+
+    size_t size() const { return trades.size(); }
+
+    void resize(size_t n)
+    {
+        accepted.resize(n); trades.resize(n); volume.resize(n); vwap.resize(n); last_px.resize(n);
+        spread_mean.resize(n); spread_p50.resize(n); spread_p99.resize(n); spread_max.resize(n);
+        two_sided.resize(n); resting.resize(n);
+        add_p50_ns.resize(n); add_p99_ns.resize(n); cancel_p50_ns.resize(n); cancel_p99_ns.resize(n);
+        seconds.resize(n); worker.resize(n);
+    }
+};
+
+namespace detail {
+
+template <class Book>
+void run_scenario(const Scenario& sc, ScenarioResults& out, size_t row)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    const int64_t tick = sc.flow.walk.tick > 0 ? sc.flow.walk.tick : 1;
+    Book ob("SIM", tick, sc.book);
+    gen::PoissonFlow flow(sc.flow, sc.seed);
+
+    const size_t step = sc.sample_every ? sc.sample_every : 1;
+    std::vector<OrderMsg> msgs(std::max(step, 4096 / step * step));    // whole sample steps
+    std::vector<RejectReason> status(step);
+    uint64_t accepted = 0, trades = 0, samples = 0, two_sided = 0;
+    int64_t volume = 0;
+    double notional = 0.0;
+    LatencyHistogram spread;
+
+    auto sample = [&] {
+        int64_t bid = 0, ask = 0;
+        ob.for_each_level(Side::Buy, [&](const Level& l) { bid = l.px; return false; });
+        ob.for_each_level(Side::Sell, [&](const Level& l) { ask = l.px; return false; });
+        ++samples;
+        if (bid && ask) {
+            ++two_sided;
+            spread.record(static_cast<uint64_t>((ask - bid) / tick));
+        }
+    };
+
+    for (size_t done = 0; done < sc.messages;) {
+        const size_t n = std::min(msgs.size(), sc.messages - done);
+        flow.fill(std::span(msgs).first(n));
+        for (size_t i = 0; i < n; i += step) {
+            const size_t k = std::min(step, n - i);
+            accepted += ob.apply_batch(std::span<const OrderMsg>(msgs).subspan(i, k), std::span(status).first(k));
+            ob.events().drain([&](const Event& e) {
+                if (e.type != EventType::Trade) return;
+                ++trades;
+                volume += e.qty;
+                notional += static_cast<double>(e.px) * static_cast<double>(e.qty);
+            });
+            sample();
+        }
+        done += n;
+    }
+
+    out.accepted[row] = accepted;
+    out.trades[row] = trades;
+    out.volume[row] = volume;
+    out.vwap[row] = volume ? notional / static_cast<double>(volume) : std::numeric_limits<double>::quiet_NaN();
+    out.last_px[row] = ob.last_trade_px();
+    out.spread_mean[row] = spread.mean();
+    out.spread_p50[row] = spread.percentile(0.5);
+    out.spread_p99[row] = spread.percentile(0.99);
+    out.spread_max[row] = spread.max();
+    out.two_sided[row] = samples ? static_cast<double>(two_sided) / static_cast<double>(samples) : 0.0;
+    out.resting[row] = ob.order_count();
+
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    out.add_p50_ns[row] = out.add_p99_ns[row] = out.cancel_p50_ns[row] = out.cancel_p99_ns[row] = nan;
+    if constexpr (Book::Metrics::enabled) {
+        const double cpn = cycles_per_ns();
+        const auto& m = ob.metrics();
+        const auto& add = m.latency[static_cast<size_t>(BookOp::Add)];
+        const auto& cxl = m.latency[static_cast<size_t>(BookOp::Cancel)];
+        out.add_p50_ns[row] = static_cast<double>(add.percentile(0.5)) / cpn;
+        out.add_p99_ns[row] = static_cast<double>(add.percentile(0.99)) / cpn;
+        out.cancel_p50_ns[row] = static_cast<double>(cxl.percentile(0.5)) / cpn;
+        out.cancel_p99_ns[row] = static_cast<double>(cxl.percentile(0.99)) / cpn;
+    }
+    out.seconds[row] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace detail
+
+// Run every scenario on a work-stealing pool of `threads` workers (0 = one
+// per hardware thread). Thread-safe to call from any thread; holds no locks
+// of its own, so callers from Python release the GIL around it.
+inline ScenarioResults run_scenarios(std::span<const Scenario> scenarios, size_t threads = 0)
+{
+    ScenarioResults out;
+    out.resize(scenarios.size());
+    cycles_per_ns();        // calibrate once up front, not inside the first timed scenario
+    WorkStealingPool pool(threads);
+    pool.run(scenarios.size(), [&](size_t i, size_t w) {
+        const Scenario& sc = scenarios[i];
+        if (sc.array_ladder) {
+            if (sc.latency) detail::run_scenario<InstrumentedArrayOrderBook>(sc, out, i);
+            else detail::run_scenario<ArrayOrderBook>(sc, out, i);
+        } else {
+            if (sc.latency) detail::run_scenario<InstrumentedOrderBook>(sc, out, i);
+            else detail::run_scenario<OrderBook>(sc, out, i);
+        }
+        out.worker[i] = static_cast<uint32_t>(w);
+    });
+    return out;
+}
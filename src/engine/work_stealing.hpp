@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join parallel loop over independent, coarse tasks (scenario sweeps,
+// one task = one whole simulation). Every worker starts with a contiguous
+// block of task indices in its own deque and takes from the front; once it
+// runs dry it steals from the back of the other deques, so slow scenarios do
+// not leave cores idle while others wait behind them. Tasks are milliseconds
+// long, so a mutex per deque is nowhere near the critical path.
+class WorkStealingPool
+{
+    public:
+        // threads = 0: one per hardware thread.
+        explicit WorkStealingPool(size_t threads = 0)
+            : n_{threads ? threads : std::max<size_t>(1, std::thread::hardware_concurrency())} {}
+
+        size_t threads() const { return n_; }
+
+        // f(task, worker) for every task in [0, tasks), worker in [0, threads()).
+        // The calling thread is worker 0. Returns once all tasks ran; the first
+        // exception thrown by f is rethrown here (remaining tasks are skipped).
+        template <class F>
+        void run(size_t tasks, F&& f)
+        {
+            if (tasks == 0) return;
+            const size_t workers = std::min(n_, tasks);
+            std::vector<Deque> q(workers);
+            for (size_t w = 0; w < workers; ++w)
+                for (size_t t = tasks * w / workers; t < tasks * (w + 1) / workers; ++t) q[w].tasks.push_back(t);
+
+            std::exception_ptr error;
+            std::mutex error_mu;
+            auto work = [&](size_t w) {
+                size_t t;
+                while (next(q, w, t)) {
+                    try {
+                        f(t, w);
+                    } catch (...) {
+                        std::lock_guard lock(error_mu);
+                        if (!error) error = std::current_exception();
+                        for (Deque& d : q) {
+                            std::lock_guard dl(d.mu);
+                            d.tasks.clear();
+                        }
+                    }
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(workers - 1);
+            for (size_t w = 1; w < workers; ++w) pool.emplace_back(work, w);
+            work(0);
+            for (auto& t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+        }
+
+    private:
+        struct Deque
+        {
+            std::mutex mu;
+            std::deque<size_t> tasks;
+        };
+
+        // Own front first, then the back of the others, nearest neighbour first.
+        static bool next(std::vector<Deque>& q, size_t self, size_t& out)
+        {
+            for (size_t i = 0; i < q.size(); ++i) {
+                Deque& d = q[(self + i) % q.size()];
+                std::lock_guard lock(d.mu);
+                if (d.tasks.empty()) continue;
+                if (i == 0) {
+                    out = d.tasks.front();
+                    d.tasks.pop_front();
+                } else {
+                    out = d.tasks.back();
+                    d.tasks.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        size_t n_;
+};
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "ob/msg.hpp"
+#include "ob/order.hpp"
+#include "random_walk.hpp"
+#include "rng.hpp"
+
+// Poisson order flow. Limit and market arrivals per side are independent
+// Poisson processes; cancels and replaces arrive at a per-resting-order
+// intensity, so the live count settles where adds balance removals. All
+// processes are merged into one stream: exponential gap at the total rate,
+// then a categorical draw picks the event. Passive prices sit a geometric
+// number of ticks away from a RandomWalk mid.
+//
+// Output is OrderMsg (add / cancel / replace), produced one at a time with
+// next() or in bulk into a caller buffer with fill(). Same config + seed
+// gives the same stream. Cancels and replaces only ever target ids this
+// generator added; those may have traded away since, as in a real feed.
+
+namespace gen {
+
+enum class SizeDist : uint8_t { Uniform, Geometric };
+
+struct FlowConfig
+{
+    // Arrivals per second.
+    double limit_buy_rate{40'000.0};
+    double limit_sell_rate{40'000.0};
+    double market_buy_rate{2'000.0};
+    double market_sell_rate{2'000.0};
+
+    // Per resting order, per second.
+    double cancel_rate{15.0};
+    double replace_rate{3.0};
+
+    // Passive placement: 1 + Geometric(offset_mean_ticks - 1) ticks from mid,
+    // capped at max_offset_ticks. marketable_frac of limits are placed that
+    // far through the mid instead.
+    double offset_mean_ticks{4.0};
+    int64_t max_offset_ticks{100};
+    double marketable_frac{0.0};
+
+    SizeDist size_dist{SizeDist::Geometric};
+    int64_t size_min{1};
+    int64_t size_max{1000};
+    double size_mean{50.0};         // Geometric only
+
+    uint32_t accounts{0};           // adds get a uniform account in [1, accounts]; 0 = none
+    size_t max_live{1u << 20};      // ids tracked for cancel/replace
+    uint64_t first_id{1};
+    WalkConfig walk{};
+};
+
+class PoissonFlow
+{
+    public:
+        explicit PoissonFlow(const FlowConfig& cfg = {}, uint64_t seed = 1)
+            : cfg_{cfg}, rng_{seed}, walk_{cfg.walk, seed ^ 0xA5A5A5A5A5A5A5A5ull},
+              size_geo_{cfg.size_mean - static_cast<double>(cfg.size_min)},
+              offset_geo_{cfg.offset_mean_ticks - 1.0}, next_id_{cfg.first_id}
+        {
+            cum_[0] = cfg.limit_buy_rate;
+            cum_[1] = cum_[0] + cfg.limit_sell_rate;
+            cum_[2] = cum_[1] + cfg.market_buy_rate;
+            cum_[3] = cum_[2] + cfg.market_sell_rate;
+            live_.reserve(cfg.max_live < 65536 ? cfg.max_live : 65536);
+        }
+
+        OrderMsg next()
+        {
+            const double per_order = cfg_.cancel_rate + cfg_.replace_rate;
+            const double rate = cum_[3] + per_order * static_cast<double>(live_.size());
+            if (rate <= 0.0) return add(Side::Buy, Type::Limit);
+
+            clock_ns_ += rng_.exponential(1e9 / rate);
+            const auto ts = static_cast<int64_t>(clock_ns_);
+            walk_.advance(ts - ts_ns_);
+            ts_ns_ = ts;
+
+            const double x = rng_.uniform() * rate;
+            if (x < cum_[0]) return add(Side::Buy, Type::Limit);
+            if (x < cum_[1]) return add(Side::Sell, Type::Limit);
+            if (x < cum_[2]) return add(Side::Buy, Type::Market);
+            if (x < cum_[3]) return add(Side::Sell, Type::Market);
+
+            const size_t k = rng_.below(live_.size());
+            if (x < cum_[3] + cfg_.cancel_rate * static_cast<double>(live_.size())) {
+                const uint64_t id = live_[k].id;
+                live_[k] = live_.back();
+                live_.pop_back();
+                return cancel_msg(id, ts_ns_);
+            }
+            return replace_msg(live_[k].id, passive_px(live_[k].side), size(), ts_ns_);
+        }
+
+        // Bulk generation into a preallocated buffer.
+        void fill(std::span<OrderMsg> out)
+        {
+            for (OrderMsg& m : out) m = next();
+        }
+
+        int64_t now_ns() const { return ts_ns_; }
+        int64_t mid() const { return walk_.mid(); }
+        size_t live() const { return live_.size(); }
+
+    private:
+        struct Live { uint64_t id; Side side; };
+
+        int64_t size()
+        {
+            int64_t q;
+            if (cfg_.size_dist == SizeDist::Uniform)
+                q = cfg_.size_min + static_cast<int64_t>(rng_.below(static_cast<uint64_t>(cfg_.size_max - cfg_.size_min + 1)));
+            else
+                q = cfg_.size_min + static_cast<int64_t>(size_geo_(rng_));
+            return q < cfg_.size_max ? q : cfg_.size_max;
+        }
+
+        int64_t offset_ticks()
+        {
+            const int64_t off = 1 + static_cast<int64_t>(offset_geo_(rng_));
+            return off < cfg_.max_offset_ticks ? off : cfg_.max_offset_ticks;
+        }
+
+        int64_t passive_px(Side side)
+        {
+            const int64_t tick = cfg_.walk.tick;
+            const int64_t px = side == Side::Buy ? walk_.mid() - offset_ticks() * tick
+                                                 : walk_.mid() + offset_ticks() * tick;
+            return px < tick ? tick : px;
+        }
+
+        OrderMsg add(Side side, Type type)
+        {
+            Order o;
+            o.id = next_id_++;
+            o.side = side;
+            o.type = type;
+            o.qty = size();
+            o.ts_ns = ts_ns_;
+            if (cfg_.accounts) o.account = 1 + static_cast<uint32_t>(rng_.below(cfg_.accounts));
+            if (type == Type::Market) {
+                o.tif = TIF::IOC;
+                return add_msg(o);
+            }
+            if (cfg_.marketable_frac > 0.0 && rng_.uniform() < cfg_.marketable_frac) {
+                const Side other = side == Side::Buy ? Side::Sell : Side::Buy;
+                o.px = passive_px(other);
+            } else {
+                o.px = passive_px(side);
+            }
+            if (live_.size() < cfg_.max_live) live_.push_back({o.id, side});
+            return add_msg(o);
+        }
+
+        FlowConfig cfg_;
+        Rng rng_;
+        RandomWalk walk_;
+        Geometric size_geo_;
+        Geometric offset_geo_;
+        double cum_[4];
+        std::vector<Live> live_;
+        uint64_t next_id_;
+        double clock_ns_{0.0};
+        int64_t ts_ns_{0};
+};
+
+} // namespace gen
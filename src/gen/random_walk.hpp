@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include "rng.hpp"
+
+// Random-walk mid price on the tick grid. Mid moves one tick at a time as a
+// Poisson process (moves_per_sec), up with probability 0.5 + drift, and never
+// below floor_px. advance() is driven by elapsed time so the walk stays in
+// step with whatever clock the flow generator is running.
+
+namespace gen {
+
+struct WalkConfig
+{
+    int64_t start_px{100000};
+    int64_t tick{1};
+    double moves_per_sec{50.0};
+    double drift{0.0};              // -0.5 .. 0.5
+    int64_t floor_px{1};
+};
+
+class RandomWalk
+{
+    public:
+        explicit RandomWalk(const WalkConfig& cfg = {}, uint64_t seed = 1)
+            : cfg_{cfg}, rng_{seed}, mid_{cfg.start_px}, p_up_{0.5 + cfg.drift},
+              gap_ns_{cfg.moves_per_sec > 0 ? 1e9 / cfg.moves_per_sec : 0.0}
+        {
+            next_move_ns_ = gap_ns_ > 0 ? rng_.exponential(gap_ns_) : -1.0;
+        }
+
+        int64_t mid() const { return mid_; }
+
+        // Move the clock forward by dt_ns, applying every tick move that fell
+        // inside the interval. Returns the new mid.
+        int64_t advance(int64_t dt_ns)
+        {
+            if (next_move_ns_ < 0) return mid_;
+            now_ns_ += static_cast<double>(dt_ns);
+            while (next_move_ns_ <= now_ns_) {
+                if (rng_.uniform() < p_up_) mid_ += cfg_.tick;
+                else if (mid_ - cfg_.tick >= cfg_.floor_px) mid_ -= cfg_.tick;
+                next_move_ns_ += rng_.exponential(gap_ns_);
+            }
+            return mid_;
+        }
+
+    private:
+        WalkConfig cfg_;
+        Rng rng_;
+        int64_t mid_;
+        double p_up_;
+        double gap_ns_;
+        double now_ns_{0.0};
+        double next_move_ns_;
+};
+
+} // namespace gen
@@ -0,0 +1,81 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Small, fast, seedable PRNG for the synthetic flow generators.
+// xoshiro256** seeded through splitmix64: a handful of cycles per draw and
+// the same sequence on every platform for the same seed.
+
+namespace gen {
+
+class Rng
+{
+    public:
+        explicit Rng(uint64_t seed = 1)
+        {
+            for (uint64_t& w : s_) w = splitmix(seed);
+        }
+
+        uint64_t next()
+        {
+            const uint64_t r = rotl(s_[1] * 5, 7) * 9;
+            const uint64_t t = s_[1] << 17;
+            s_[2] ^= s_[0];
+            s_[3] ^= s_[1];
+            s_[1] ^= s_[2];
+            s_[0] ^= s_[3];
+            s_[2] ^= t;
+            s_[3] = rotl(s_[3], 45);
+            return r;
+        }
+
+        // Uniform in [0, 1).
+        double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+        // Uniform in [0, n), n > 0 (multiply-shift, no division).
+        uint64_t below(uint64_t n)
+        {
+            return static_cast<uint64_t>((static_cast<u128>(next()) * n) >> 64);
+        }
+
+        // Uniform in (0, 1]; safe to take the log of.
+        double uniform_pos() { return static_cast<double>((next() >> 11) + 1) * 0x1.0p-53; }
+
+        // Exponential with the given mean.
+        double exponential(double mean) { return -mean * std::log(uniform_pos()); }
+
+
+    private:
+        __extension__ typedef unsigned __int128 u128;
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        static uint64_t splitmix(uint64_t& x)
+        {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t s_[4];
+};
+
+// Geometric on {0, 1, 2, ...} with a fixed mean (>= 0); the log of the
+// failure probability is computed once so a draw is one log and a multiply.
+class Geometric
+{
+    public:
+        explicit Geometric(double mean = 0.0)
+            : inv_{mean > 0.0 ? 1.0 / std::log(mean / (1.0 + mean)) : 0.0} {}
+
+        uint64_t operator()(Rng& rng) const
+        {
+            return inv_ == 0.0 ? 0 : static_cast<uint64_t>(std::log(rng.uniform_pos()) * inv_);
+        }
+
+    private:
+        double inv_;
+};
+
+} // namespace gen
@@ -0,0 +1,316 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+#include "io/file.hpp"
+#include "ob/event.hpp"
+#include "ob/msg.hpp"
+#include "ob/order.hpp"
+
+// CSV order logs in, trades/events out.
+//
+// Order rows:  ts_ns,kind,id,side,type,tif,px,qty
+//   kind A/C/R (add/cancel/replace), side B/S, type L/M/S/T, tif D/I/F/G/P/T
+//   (type S = stop, T = stop-limit; tif T = GTD). Like OrderMsg the row has
+//   no expiry or stop price, so a GTD add replays as a BadExpiry reject and a
+//   stop as a BadPrice one.
+//   Cancel rows may leave side..qty empty. A first line that does not start
+//   with a digit is taken as a header and skipped.
+// Trade rows:  ts_ns,taker_id,maker_id,px,qty,taker_side
+// Event rows:  ts_ns,type,id,maker_id,side,px,qty,orders,reason
+//
+// The reader maps the whole file and decodes rows straight from the mapping
+// into caller-provided OrderMsg chunks: no per-line or per-field allocation,
+// integers by a hand-rolled digit loop, consumed pages handed back to the kernel as
+// it goes so multi-GB logs don't pile up in RSS. The writer formats with
+// std::to_chars into one large buffer and write()s it out when full.
+
+namespace io {
+
+inline constexpr std::string_view kOrderHeader = "ts_ns,kind,id,side,type,tif,px,qty\n";
+inline constexpr std::string_view kTradeHeader = "ts_ns,taker_id,maker_id,px,qty,taker_side\n";
+inline constexpr std::string_view kEventHeader = "ts_ns,type,id,maker_id,side,px,qty,orders,reason\n";
+
+class CsvOrderReader
+{
+    public:
+        explicit CsvOrderReader(const std::string& path) : file_{path}
+        {
+            p_ = file_.data();
+            end_ = p_ + file_.size();
+            if (p_ != end_ && (*p_ < '0' || *p_ > '9')) {
+                skip_line();
+                ++lines_;
+            }
+        }
+
+        // Decode up to out.size() rows into out; returns the number written,
+        // 0 once the file is exhausted. Malformed rows are skipped and counted.
+        size_t read(std::span<OrderMsg> out)
+        {
+            size_t n = 0;
+            while (n < out.size() && p_ < end_) {
+                ++lines_;
+                if (*p_ == '\n' || *p_ == '\r') { skip_line(); continue; }     // blank line
+                const char* p = p_;
+                if (parse(p, end_, out[n]) && eol(p)) {
+                    p_ = p;
+                    ++n;
+                } else {
+                    skip_line();
+                    ++bad_lines_;
+                }
+            }
+            file_.release(static_cast<size_t>(p_ - file_.data()));
+            return n;
+        }
+
+        // Visit every remaining row, decoding in chunks of 4096.
+        template <class F>
+        size_t for_each(F&& f)
+        {
+            std::vector<OrderMsg> chunk(4096);
+            size_t total = 0;
+            for (size_t n; (n = read(chunk)) != 0; total += n)
+                for (size_t i = 0; i < n; ++i) f(chunk[i]);
+            return total;
+        }
+
+        bool done() const { return p_ >= end_; }
+        size_t lines() const { return lines_; }
+        size_t bad_lines() const { return bad_lines_; }
+        size_t bytes() const { return file_.size(); }
+
+    private:
+        void skip_line()
+        {
+            const void* nl = std::memchr(p_, '\n', static_cast<size_t>(end_ - p_));
+            p_ = nl ? static_cast<const char*>(nl) + 1 : end_;
+        }
+
+        // Rows are decoded straight off the mapping without finding the line
+        // end first; a row must finish exactly at "\n", "\r\n" or EOF.
+        bool eol(const char*& p) const
+        {
+            if (p < end_ && *p == '\r') ++p;
+            if (p == end_) return true;
+            if (*p != '\n') return false;
+            ++p;
+            return true;
+        }
+
+        static bool at_eol(const char* p, const char* e) { return p == e || *p == '\n' || *p == '\r'; }
+
+        // Field separator: end of line (not consumed) or a ',' (consumed).
+        static bool sep(const char*& p, const char* e)
+        {
+            if (at_eol(p, e)) return true;
+            if (*p != ',') return false;
+            ++p;
+            return true;
+        }
+
+        // Decimal integer field, empty = 0. Hand-rolled: the fields are short
+        // and a digit loop beats finding the field end first.
+        template <class Int>
+        static bool number(const char*& p, const char* e, Int& v)
+        {
+            bool neg = false;
+            if constexpr (std::is_signed_v<Int>) {
+                if (p < e && *p == '-') { neg = true; ++p; }
+            }
+            const char* b = p;
+            uint64_t x = 0;
+            while (p < e && static_cast<unsigned>(*p - '0') < 10) x = x * 10 + static_cast<uint64_t>(*p++ - '0');
+            if (p - b > 19 || (neg && p == b)) return false;
+            if constexpr (std::is_signed_v<Int>) {
+                if (x > static_cast<uint64_t>(std::numeric_limits<Int>::max())) return false;
+                v = neg ? -static_cast<Int>(x) : static_cast<Int>(x);
+            } else {
+                v = static_cast<Int>(x);
+            }
+            return sep(p, e);
+        }
+
+        // Single-character field, 0 when empty.
+        static bool letter(const char*& p, const char* e, char& c)
+        {
+            c = 0;
+            if (!at_eol(p, e) && *p != ',') c = *p++;
+            return sep(p, e);
+        }
+
+        static bool parse(const char*& p, const char* e, OrderMsg& m)
+        {
+            m = OrderMsg{};
+            char kind, side, type, tif;
+            if (!number(p, e, m.ts_ns) || !letter(p, e, kind) || !number(p, e, m.id)) return false;
+            if (!letter(p, e, side) || !letter(p, e, type) || !letter(p, e, tif)) return false;
+            if (!number(p, e, m.px) || !number(p, e, m.qty) || !at_eol(p, e)) return false;
+
+            switch (kind) {
+                case 'A': m.kind = static_cast<uint8_t>(MsgKind::Add); break;
+                case 'C': m.kind = static_cast<uint8_t>(MsgKind::Cancel); break;
+                case 'R': m.kind = static_cast<uint8_t>(MsgKind::Replace); break;
+                default: return false;
+            }
+            switch (side) {
+                case 0: case 'B': m.side = static_cast<uint8_t>(Side::Buy); break;
+                case 'S': m.side = static_cast<uint8_t>(Side::Sell); break;
+                default: return false;
+            }
+            switch (type) {
+                case 0: case 'L': m.type = static_cast<uint8_t>(Type::Limit); break;
+                case 'M': m.type = static_cast<uint8_t>(Type::Market); break;
+                case 'S': m.type = static_cast<uint8_t>(Type::Stop); break;
+                case 'T': m.type = static_cast<uint8_t>(Type::StopLimit); break;
+                default: return false;
+            }
+            switch (tif) {
+                case 0: case 'D': m.tif = static_cast<uint8_t>(TIF::Day); break;
+                case 'I': m.tif = static_cast<uint8_t>(TIF::IOC); break;
+                case 'F': m.tif = static_cast<uint8_t>(TIF::FOK); break;
+                case 'G': m.tif = static_cast<uint8_t>(TIF::GTC); break;
+                case 'P': m.tif = static_cast<uint8_t>(TIF::PostOnly); break;
+                case 'T': m.tif = static_cast<uint8_t>(TIF::GTD); break;
+                default: return false;
+            }
+            return true;
+        }
+
+        MappedFile file_;
+        const char* p_{nullptr};
+        const char* end_{nullptr};
+        size_t lines_{0};
+        size_t bad_lines_{0};
+};
+
+// Buffered CSV writer for orders, trades and book events.
+class CsvWriter
+{
+    public:
+        explicit CsvWriter(const std::string& path, size_t buffer_bytes = size_t{1} << 20)
+            : buf_(buffer_bytes < 4096 ? 4096 : buffer_bytes)
+        {
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0) throw std::runtime_error("cannot open " + path);
+        }
+
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+
+        ~CsvWriter()
+        {
+            if (fd_ < 0) return;
+            try { flush(); } catch (...) {}
+            ::close(fd_);
+        }
+
+        void raw(std::string_view s)
+        {
+            if (buf_.size() - len_ < s.size()) flush();
+            if (s.size() > buf_.size()) { write_all(s.data(), s.size()); return; }
+            std::memcpy(buf_.data() + len_, s.data(), s.size());
+            len_ += s.size();
+        }
+
+        void write(const OrderMsg& m)
+        {
+            reserve();
+            num(m.ts_ns); put(',');
+            put("ACR?"[m.kind < 3 ? m.kind : 3]); put(',');
+            num(m.id); put(',');
+            if (m.kind == static_cast<uint8_t>(MsgKind::Cancel)) {
+                put(",,,,");
+            } else {
+                if (m.kind == static_cast<uint8_t>(MsgKind::Add)) {
+                    put(m.side == static_cast<uint8_t>(Side::Buy) ? 'B' : 'S'); put(',');
+                    put("LMST?"[m.type < 4 ? m.type : 4]); put(',');
+                    put("DIFGPT?"[m.tif < 6 ? m.tif : 6]); put(',');
+                } else {
+                    put(",,,");
+                }
+                num(m.px); put(',');
+                num(m.qty);
+            }
+            put('\n');
+        }
+
+        void write(const Trade& t)
+        {
+            reserve();
+            num(t.ts_ns); put(',');
+            num(t.taker_id); put(',');
+            num(t.maker_id); put(',');
+            num(t.px); put(',');
+            num(t.qty); put(',');
+            put(t.taker_is_buy ? 'B' : 'S');
+            put('\n');
+        }
+
+        void write(const Event& e)
+        {
+            static constexpr std::string_view kTypes[] = {"accept", "reject", "trade", "cancel", "replace", "level",
+                                                          "order_added", "order_reduced", "order_removed",
+                                                          "stop_triggered", "self_trade_prevented", "expire"};
+            static_assert(std::size(kTypes) == static_cast<size_t>(EventType::Expire) + 1, "one name per EventType");
+            reserve();
+            num(e.ts_ns); put(',');
+            const auto t = static_cast<size_t>(e.type);
+            put(t < std::size(kTypes) ? kTypes[t] : std::string_view{"?"}); put(',');
+            num(e.id); put(',');
+            num(e.maker_id); put(',');
+            put(e.side == Side::Buy ? 'B' : 'S'); put(',');
+            num(e.px); put(',');
+            num(e.qty); put(',');
+            num(e.orders); put(',');
+            num(static_cast<unsigned>(e.reason));
+            put('\n');
+        }
+
+        void flush()
+        {
+            write_all(buf_.data(), len_);
+            len_ = 0;
+        }
+
+        uint64_t bytes_written() const { return written_ + len_; }
+
+    private:
+        static constexpr size_t kMaxRow = 256;
+
+        void reserve() { if (buf_.size() - len_ < kMaxRow) flush(); }
+        void put(char c) { buf_[len_++] = c; }
+        void put(std::string_view s) { std::memcpy(buf_.data() + len_, s.data(), s.size()); len_ += s.size(); }
+
+        template <class Int>
+        void num(Int v)
+        {
+            const auto r = std::to_chars(buf_.data() + len_, buf_.data() + buf_.size(), v);
+            len_ = static_cast<size_t>(r.ptr - buf_.data());
+        }
+
+        void write_all(const char* p, size_t n)
+        {
+            io::write_all(fd_, p, n);
+            written_ += n;
+        }
+
+        std::vector<char> buf_;
+        size_t len_{0};
+        int fd_{-1};
+        uint64_t written_{0};
+};
+
+} // namespace io
@@ -0,0 +1,100 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+// POSIX file helpers shared by the CSV reader/writer and the binary journal.
+
+namespace io {
+
+// Read-only mapping of a whole file.
+class MappedFile
+{
+    public:
+        explicit MappedFile(const std::string& path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("cannot open " + path);
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot stat " + path);
+            }
+            size_ = static_cast<size_t>(st.st_size);
+            if (size_) {
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    ::close(fd);
+                    throw std::runtime_error("cannot mmap " + path);
+                }
+                data_ = static_cast<const char*>(p);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& o) noexcept
+            : data_{std::exchange(o.data_, nullptr)}, size_{std::exchange(o.size_, 0)},
+              released_{std::exchange(o.released_, 0)} {}
+        MappedFile& operator=(MappedFile&& o) noexcept
+        {
+            if (this != &o) {
+                unmap();
+                data_ = std::exchange(o.data_, nullptr);
+                size_ = std::exchange(o.size_, 0);
+                released_ = std::exchange(o.released_, 0);
+            }
+            return *this;
+        }
+        ~MappedFile() { unmap(); }
+
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+
+        // Drop the pages of [0, upto) from the page cache mapping; they will
+        // not be read again.
+        void release(size_t upto)
+        {
+            const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            upto = upto / page * page;
+            if (upto > released_) {
+                ::madvise(const_cast<char*>(data_) + released_, upto - released_, MADV_DONTNEED);
+                released_ = upto;
+            }
+        }
+
+    private:
+        void unmap()
+        {
+            if (data_) ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+
+        const char* data_{nullptr};
+        size_t size_{0};
+        size_t released_{0};
+};
+
+// write() all of [p, p + n) to fd, retrying short writes and EINTR.
+inline void write_all(int fd, const char* p, size_t n)
+{
+    while (n) {
+        const ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("write failed");
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+}
+
+} // namespace io
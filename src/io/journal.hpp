@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include "io/file.hpp"
+#include "ob/event.hpp"
+#include "ob/msg.hpp"
+#include "ob/order.hpp"
+
+// Binary input journal: every add/cancel/replace a book saw, in order, so a
+// run can be replayed bit-exactly.
+//
+//   [JournalHeader, 64 bytes][OrderMsg, 40 bytes] * N
+//
+// Everything is fixed-width little-endian; records are OrderMsg verbatim, so
+// the writer is a memcpy into a buffer and the reader hands out a span over
+// the mapping with no decoding at all. A torn final record (crash mid-write)
+// is ignored.
+//
+// OrderMsg has no stop_px, display_qty or expire_ns, so stop, iceberg and
+// GTD orders cannot be journaled: JournalWriter::add (and so Recorder::add, before the book
+// sees the order) throws std::invalid_argument rather than record an order
+// that would replay as something else.
+
+static_assert(std::endian::native == std::endian::little, "journal records are written in host order");
+
+namespace io {
+
+struct JournalHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    int64_t tick;
+    char symbol[32];            // NUL-padded
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(JournalHeader) == 64, "journal header layout is part of the file format");
+
+inline constexpr char kJournalMagic[8] = {'O', 'B', 'J', 'O', 'U', 'R', 'N', 'L'};
+inline constexpr uint32_t kJournalVersion = 1;
+
+// Throws if o carries fields an OrderMsg record would drop.
+inline void check_journalable(const Order& o)
+{
+    if (o.type == Type::Stop || o.type == Type::StopLimit)
+        throw std::invalid_argument("journal records cannot hold stop orders (no stop_px)");
+    if (o.display_qty != 0)
+        throw std::invalid_argument("journal records cannot hold iceberg orders (no display_qty)");
+    if (o.tif == TIF::GTD)
+        throw std::invalid_argument("journal records cannot hold GTD orders (no expire_ns)");
+}
+
+class JournalWriter
+{
+    public:
+        JournalWriter(const std::string& path, std::string_view symbol, int64_t tick, size_t buffer_records = 1 << 15)
+            : buf_(buffer_records ? buffer_records : 1)
+        {
+            if (symbol.size() >= sizeof(JournalHeader::symbol))
+                throw std::invalid_argument("journal symbol too long: " + std::string(symbol));
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0) throw std::runtime_error("cannot open " + path);
+
+            JournalHeader h{};
+            std::memcpy(h.magic, kJournalMagic, sizeof h.magic);
+            h.version = kJournalVersion;
+            h.record_size = sizeof(OrderMsg);
+            h.tick = tick;
+            std::memcpy(h.symbol, symbol.data(), symbol.size());
+            io::write_all(fd_, reinterpret_cast<const char*>(&h), sizeof h);
+        }
+
+        JournalWriter(const JournalWriter&) = delete;
+        JournalWriter& operator=(const JournalWriter&) = delete;
+
+        ~JournalWriter()
+        {
+            if (fd_ < 0) return;
+            try { flush(); } catch (...) {}
+            ::close(fd_);
+        }
+
+        void append(const OrderMsg& m)
+        {
+            if (len_ == buf_.size()) flush();
+            buf_[len_++] = m;
+            ++records_;
+        }
+
+        void append(std::span<const OrderMsg> msgs)
+        {
+            if (msgs.size() >= buf_.size()) {
+                flush();
+                io::write_all(fd_, reinterpret_cast<const char*>(msgs.data()), msgs.size_bytes());
+                records_ += msgs.size();
+                return;
+            }
+            if (buf_.size() - len_ < msgs.size()) flush();
+            std::copy(msgs.begin(), msgs.end(), buf_.begin() + static_cast<ptrdiff_t>(len_));
+            len_ += msgs.size();
+            records_ += msgs.size();
+        }
+
+        void add(const Order& o)
+        {
+            check_journalable(o);
+            append(add_msg(o));
+        }
+        void cancel(uint64_t id, int64_t ts) { append(cancel_msg(id, ts)); }
+        void replace(uint64_t id, int64_t px, int64_t qty, int64_t ts) { append(replace_msg(id, px, qty, ts)); }
+
+        // Hand the buffer to the kernel; sync() additionally waits for the disk.
+        void flush()
+        {
+            io::write_all(fd_, reinterpret_cast<const char*>(buf_.data()), len_ * sizeof(OrderMsg));
+            len_ = 0;
+        }
+
+        void sync()
+        {
+            flush();
+            ::fdatasync(fd_);
+        }
+
+        uint64_t records() const { return records_; }
+
+    private:
+        std::vector<OrderMsg> buf_;
+        size_t len_{0};
+        int fd_{-1};
+        uint64_t records_{0};
+};
+
+// Read side: validates the header and exposes the records in place.
+class Journal
+{
+    public:
+        explicit Journal(const std::string& path) : file_{path}
+        {
+            if (file_.size() < sizeof(JournalHeader)) throw std::runtime_error("not a journal (too short): " + path);
+            std::memcpy(&header_, file_.data(), sizeof header_);
+            if (std::memcmp(header_.magic, kJournalMagic, sizeof header_.magic) != 0)
+                throw std::runtime_error("not a journal (bad magic): " + path);
+            if (header_.version != kJournalVersion || header_.record_size != sizeof(OrderMsg))
+                throw std::runtime_error("unsupported journal version: " + path);
+        }
+
+        std::string_view symbol() const { return {header_.symbol, strnlen(header_.symbol, sizeof header_.symbol)}; }
+        int64_t tick() const { return header_.tick; }
+        uint32_t version() const { return header_.version; }
+
+        // The mapping is page-aligned and the header is 64 bytes, so records
+        // are suitably aligned for OrderMsg.
+        std::span<const OrderMsg> records() const
+        {
+            const size_t n = (file_.size() - sizeof(JournalHeader)) / sizeof(OrderMsg);
+            return {reinterpret_cast<const OrderMsg*>(file_.data() + sizeof(JournalHeader)), n};
+        }
+
+        size_t size() const { return records().size(); }
+
+    private:
+        MappedFile file_;
+        JournalHeader header_{};
+};
+
+// Feed msgs into ob through apply_batch, in chunks of 4096. on_events(
+// ob.events()) runs after each chunk and is expected to drain the ring.
+// Returns the number of messages the book accepted. Pass
+// j.records().subspan(offset) to resume after a snapshot.
+template <class Book, class F>
+size_t replay(std::span<const OrderMsg> msgs, Book& ob, F&& on_events)
+{
+    constexpr size_t kChunk = 4096;
+    std::array<RejectReason, kChunk> status;
+    size_t accepted = 0;
+    for (size_t i = 0; i < msgs.size(); i += kChunk) {
+        accepted += ob.apply_batch(msgs.subspan(i, std::min(kChunk, msgs.size() - i)), status);
+        on_events(ob.events());
+    }
+    return accepted;
+}
+
+template <class Book>
+size_t replay(std::span<const OrderMsg> msgs, Book& ob)
+{
+    return replay(msgs, ob, [](EventRing& ev) { ev.clear(); });
+}
+
+template <class Book, class F>
+size_t replay(const Journal& j, Book& ob, F&& on_events)
+{
+    return replay(j.records(), ob, std::forward<F>(on_events));
+}
+
+template <class Book>
+size_t replay(const Journal& j, Book& ob)
+{
+    return replay(j.records(), ob);
+}
+
+// Book front end that journals every input before applying it.
+template <class Book>
+class Recorder
+{
+    public:
+        Recorder(Book& ob, JournalWriter& out) : ob_{ob}, out_{out} {}
+
+        bool add(const Order& o)
+        {
+            out_.add(o);
+            return ob_.add(o);
+        }
+
+        bool cancel(uint64_t id, int64_t ts)
+        {
+            out_.cancel(id, ts);
+            return ob_.cancel(id, ts);
+        }
+
+        bool replace(uint64_t id, int64_t px, int64_t qty, int64_t ts)
+        {
+            out_.replace(id, px, qty, ts);
+            return ob_.replace(id, px, qty, ts);
+        }
+
+        size_t apply_batch(std::span<const OrderMsg> msgs, std::span<RejectReason> status)
+        {
+            msgs = msgs.first(std::min(msgs.size(), status.size()));
+            out_.append(msgs);
+            return ob_.apply_batch(msgs, status);
+        }
+
+        Book& book() { return ob_; }
+
+    private:
+        Book& ob_;
+        JournalWriter& out_;
+};
+
+} // namespace io
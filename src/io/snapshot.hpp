@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "io/file.hpp"
+#include "ob/book.hpp"
+
+// Book snapshots for warm starts.
+//
+//   [SnapshotHeader, 96 bytes]
+//   per level, bids best-first then asks best-first:
+//     [SnapshotLevel, 16 bytes][RestingOrder, 32 bytes] * count   (FIFO order)
+//
+// Fixed-width little-endian, like the journal. journal_offset records how
+// many journal messages the book had consumed, so a restore followed by
+// replaying the journal from that offset reproduces the original run.
+// load_snapshot() sizes the pools from the header and bulk-loads each level
+// straight from the mapping through load_level(): no add(), no matching,
+// no events. The file is not trusted: the framing (sides, best-first order,
+// lifetimes) is checked here and each level's prices, quantities and ids by
+// load_level(); anything off throws std::runtime_error.
+
+namespace io {
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    int64_t tick;
+    char symbol[32];            // NUL-padded
+    uint64_t journal_offset;
+    uint64_t orders;
+    uint32_t bid_levels;
+    uint32_t ask_levels;
+    int64_t last_px;            // last trade price, 0 = none
+    uint8_t reserved[8];
+};
+
+struct SnapshotLevel
+{
+    int64_t px;
+    uint32_t count;
+    uint8_t side;               // Side
+    uint8_t pad[3];
+};
+
+static_assert(sizeof(SnapshotHeader) == 96, "snapshot header layout is part of the file format");
+static_assert(sizeof(SnapshotLevel) == 16, "snapshot level layout is part of the file format");
+static_assert(sizeof(RestingOrder) == 32, "snapshot order layout is part of the file format");
+
+inline constexpr char kSnapshotMagic[8] = {'O', 'B', 'S', 'N', 'A', 'P', 'S', 'H'};
+// v2: RestingOrder carries the account and the Day / GTC lifetime.
+// v3: the header carries the last trade price.
+inline constexpr uint32_t kSnapshotVersion = 3;
+
+struct SnapshotInfo
+{
+    std::string symbol;
+    int64_t tick{};
+    uint64_t journal_offset{};
+    uint64_t orders{};
+    uint32_t bid_levels{};
+    uint32_t ask_levels{};
+    int64_t last_px{};
+};
+
+// Written to path + ".tmp" and renamed over path, so a crash never leaves a
+// half-written snapshot under the real name.
+template <class Book>
+void save_snapshot(const Book& ob, const std::string& path, uint64_t journal_offset = 0)
+{
+    if (ob.symbol().size() >= sizeof(SnapshotHeader::symbol))
+        throw std::invalid_argument("snapshot symbol too long: " + ob.symbol());
+    // The format stores visible resting quantity, the account and the
+    // Day / GTC lifetime; GTD expiries are not kept.
+    if (ob.stop_count() || ob.iceberg_count())
+        throw std::invalid_argument("snapshot of a book with pending stops or icebergs is not supported");
+    if (ob.expiry_count())
+        throw std::invalid_argument("snapshot of a book with GTD orders is not supported");
+    if (ob.in_auction())
+        throw std::invalid_argument("snapshot of a book in a call auction is not supported");
+
+    const std::string tmp = path + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("cannot open " + tmp);
+
+    std::vector<char> buf(size_t{1} << 20);
+    size_t len = 0;
+    auto put = [&](const void* p, size_t n) {
+        if (buf.size() - len < n) {
+            write_all(fd, buf.data(), len);
+            len = 0;
+        }
+        std::memcpy(buf.data() + len, p, n);
+        len += n;
+    };
+
+    try {
+        SnapshotHeader h{};
+        std::memcpy(h.magic, kSnapshotMagic, sizeof h.magic);
+        h.version = kSnapshotVersion;
+        h.tick = ob.tick();
+        std::memcpy(h.symbol, ob.symbol().data(), ob.symbol().size());
+        h.journal_offset = journal_offset;
+        h.orders = ob.order_count();
+        h.bid_levels = static_cast<uint32_t>(ob.level_count(Side::Buy));
+        h.ask_levels = static_cast<uint32_t>(ob.level_count(Side::Sell));
+        h.last_px = ob.last_trade_px();
+        put(&h, sizeof h);
+
+        for (const Side side : {Side::Buy, Side::Sell}) {
+            ob.for_each_level(side, [&](const Level& lvl) {
+                SnapshotLevel l{};
+                l.px = lvl.px;
+                l.count = static_cast<uint32_t>(lvl.count());
+                l.side = static_cast<uint8_t>(side);
+                put(&l, sizeof l);
+                for (const QueueEntry* e = lvl.head; e; e = e->next) {
+                    const RestingOrder r{e->id, e->qty, e->ts_ns, e->account, e->tif, {}};
+                    put(&r, sizeof r);
+                }
+            });
+        }
+        write_all(fd, buf.data(), len);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    ::close(fd);
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        throw std::runtime_error("cannot rename snapshot to " + path);
+    }
+}
+
+inline SnapshotHeader read_snapshot_header(const MappedFile& f, const std::string& path)
+{
+    SnapshotHeader h{};
+    if (f.size() < sizeof h) throw std::runtime_error("not a snapshot (too short): " + path);
+    std::memcpy(&h, f.data(), sizeof h);
+    if (std::memcmp(h.magic, kSnapshotMagic, sizeof h.magic) != 0)
+        throw std::runtime_error("not a snapshot (bad magic): " + path);
+    if (h.version != kSnapshotVersion) throw std::runtime_error("unsupported snapshot version: " + path);
+    return h;
+}
+
+inline SnapshotInfo snapshot_info(const std::string& path)
+{
+    const MappedFile f(path);
+    const SnapshotHeader h = read_snapshot_header(f, path);
+    return SnapshotInfo{std::string(h.symbol, strnlen(h.symbol, sizeof h.symbol)), h.tick,
+                        h.journal_offset, h.orders, h.bid_levels, h.ask_levels, h.last_px};
+}
+
+inline const char* snapshot_reject_text(RejectReason why)
+{
+    switch (why) {
+        case RejectReason::BadPrice:    return "bad or out-of-range level price";
+        case RejectReason::WouldCross:  return "crossed levels";
+        case RejectReason::BadQty:      return "order with non-positive qty";
+        case RejectReason::BadAccount:  return "account out of range";
+        case RejectReason::DuplicateId: return "duplicate order id";
+        default:                        return "level refused";
+    }
+}
+
+// cfg supplies event-ring size and ladder shape; order and level capacities
+// are raised to at least what the snapshot holds. An ArrayLadder window with
+// no base_px is centred on the snapshot's touch, and never grows past
+// cfg.ladder.max_ticks to fit the rest.
+template <class Book>
+Book load_snapshot(const std::string& path, BookConfig cfg = {}, SnapshotInfo* info = nullptr)
+{
+    const MappedFile f(path);
+    const SnapshotHeader h = read_snapshot_header(f, path);
+    if (h.tick <= 0) throw std::runtime_error("snapshot with bad tick: " + path);
+    if (h.last_px < 0 || h.last_px % h.tick != 0) throw std::runtime_error("snapshot with bad last trade price: " + path);
+    const size_t levels = size_t{h.bid_levels} + h.ask_levels;
+    // the header sizes the pools below, so hold it to the file's real length first
+    const size_t body = f.size() - sizeof h;
+    if (h.orders > body / sizeof(RestingOrder) || levels > body / sizeof(SnapshotLevel) ||
+        levels * sizeof(SnapshotLevel) + h.orders * sizeof(RestingOrder) != body)
+        throw std::runtime_error("snapshot size does not match its header: " + path);
+
+    const char* p = f.data() + sizeof h;
+    const char* const end = f.data() + f.size();
+    auto need = [&](size_t n) {
+        if (static_cast<size_t>(end - p) < n) throw std::runtime_error("truncated snapshot: " + path);
+    };
+
+    cfg.orders = std::max<size_t>(cfg.orders, h.orders);
+    cfg.ladder.levels = std::max(cfg.ladder.levels, levels);
+    if (cfg.ladder.base_px == 0 && levels) {
+        need(sizeof(SnapshotLevel));
+        SnapshotLevel first;
+        std::memcpy(&first, p, sizeof first);
+        cfg.ladder.base_px = first.px;
+    }
+
+    Book ob(std::string(h.symbol, strnlen(h.symbol, sizeof h.symbol)), h.tick, cfg);
+    int64_t prev_px = 0;
+    for (size_t i = 0; i < levels; ++i) {
+        need(sizeof(SnapshotLevel));
+        SnapshotLevel l;
+        std::memcpy(&l, p, sizeof l);
+        p += sizeof l;
+
+        // bids best-first (strictly falling), then asks best-first (strictly rising)
+        const Side side = i < h.bid_levels ? Side::Buy : Side::Sell;
+        if (l.side != static_cast<uint8_t>(side)) throw std::runtime_error("snapshot level on the wrong side: " + path);
+        if (l.count == 0) throw std::runtime_error("empty snapshot level: " + path);
+        if (i != 0 && i != h.bid_levels)
+            if (side == Side::Buy ? l.px >= prev_px : l.px <= prev_px)
+                throw std::runtime_error("snapshot levels out of order: " + path);
+        prev_px = l.px;
+
+        need(size_t{l.count} * sizeof(RestingOrder));
+        // Records sit at 8-byte offsets inside a page-aligned mapping.
+        const std::span<const RestingOrder> fifo{reinterpret_cast<const RestingOrder*>(p), l.count};
+        for (const RestingOrder& r : fifo)
+            if (r.tif != TIF::Day && r.tif != TIF::GTC) throw std::runtime_error("snapshot order with bad lifetime: " + path);
+        if (const RejectReason why = ob.load_level(side, l.px, fifo); why != RejectReason::None)
+            throw std::runtime_error(std::string("snapshot ") + snapshot_reject_text(why) + ": " + path);
+        p += size_t{l.count} * sizeof(RestingOrder);
+    }
+    if (ob.order_count() != h.orders) throw std::runtime_error("snapshot order count mismatch: " + path);
+    ob.load_last_trade_px(h.last_px);
+
+    if (info) *info = SnapshotInfo{ob.symbol(), h.tick, h.journal_offset, h.orders, h.bid_levels, h.ask_levels, h.last_px};
+    return ob;
+}
+
+} // namespace io
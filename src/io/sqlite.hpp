@@ -0,0 +1,328 @@
+#pragma once
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine/mpsc_queue.hpp"
+#include "ob/book.hpp"
+#include "ob/event.hpp"
+#include "ob/order.hpp"
+
+// SQLite persistence for trades and L2 snapshots.
+//
+// The matching thread only copies a small row into a bounded lock-free queue;
+// a background thread owns the connection and does all the disk work. It
+// inserts through prepared statements inside large transactions (commit every
+// batch_rows rows, or as soon as the queue runs dry so data shows up
+// promptly) with the database in WAL mode and synchronous=NORMAL.
+//
+//   trades(ts_ns, sym, taker_id, maker_id, px, qty, taker_buy)
+//   book_levels(ts_ns, sym, side, level, px, qty, orders)   side 0 = bid, 1 = ask
+
+namespace io {
+
+struct SqliteConfig
+{
+    size_t queue_capacity{1 << 16};
+    size_t batch_rows{100'000};         // rows per transaction, at most
+    bool wal{true};
+    std::string synchronous{"NORMAL"};  // OFF, NORMAL, FULL or EXTRA; anything else throws
+    size_t snapshot_depth{64};          // levels per side snapshot() holds without allocating
+};
+
+class SqliteSink
+{
+    public:
+        explicit SqliteSink(const std::string& path, const SqliteConfig& cfg = {})
+            : cfg_{cfg}, q_{cfg.queue_capacity}
+        {
+            levels_.reserve(2 * cfg_.snapshot_depth);
+            // pasted into the PRAGMA below, so only the four documented levels
+            const std::string& sync = cfg_.synchronous;
+            if (sync != "OFF" && sync != "NORMAL" && sync != "FULL" && sync != "EXTRA")
+                throw std::invalid_argument("sqlite synchronous must be OFF, NORMAL, FULL or EXTRA, got " + sync);
+            if (sqlite3_open(path.c_str(), &db_) != SQLITE_OK) {
+                const std::string msg = db_ ? sqlite3_errmsg(db_) : "out of memory";
+                sqlite3_close(db_);
+                throw std::runtime_error("sqlite open " + path + ": " + msg);
+            }
+            try {
+                if (cfg_.wal) exec("PRAGMA journal_mode=WAL");
+                exec("PRAGMA synchronous=" + cfg_.synchronous);
+                exec("CREATE TABLE IF NOT EXISTS trades("
+                     "ts_ns INTEGER NOT NULL, sym INTEGER NOT NULL, taker_id INTEGER NOT NULL, "
+                     "maker_id INTEGER NOT NULL, px INTEGER NOT NULL, qty INTEGER NOT NULL, "
+                     "taker_buy INTEGER NOT NULL)");
+                exec("CREATE TABLE IF NOT EXISTS book_levels("
+                     "ts_ns INTEGER NOT NULL, sym INTEGER NOT NULL, side INTEGER NOT NULL, "
+                     "level INTEGER NOT NULL, px INTEGER NOT NULL, qty INTEGER NOT NULL, "
+                     "orders INTEGER NOT NULL)");
+                trade_stmt_ = prepare("INSERT INTO trades VALUES(?,?,?,?,?,?,?)");
+                level_stmt_ = prepare("INSERT INTO book_levels VALUES(?,?,?,?,?,?,?)");
+            } catch (...) {
+                sqlite3_finalize(trade_stmt_);
+                sqlite3_close(db_);
+                throw;
+            }
+            thread_ = std::thread([this] { run(); });
+        }
+
+        SqliteSink(const SqliteSink&) = delete;
+        SqliteSink& operator=(const SqliteSink&) = delete;
+
+        ~SqliteSink() { close(); }
+
+        // ---- producer side (any thread; never touches the database) ----
+
+        // False if the queue is full; nothing is written.
+        bool try_write(const Trade& t, uint32_t sym = 0)
+        {
+            Row r;
+            r.kind = Row::TradeRow;
+            r.sym = sym;
+            r.side = t.taker_is_buy ? 1 : 0;
+            r.ts_ns = t.ts_ns;
+            r.a = t.taker_id;
+            r.b = t.maker_id;
+            r.px = t.px;
+            r.qty = t.qty;
+            return push(r);
+        }
+
+        // Waits for queue space (not for the disk) if the writer is behind.
+        void write(const Trade& t, uint32_t sym = 0)
+        {
+            while (!try_write(t, sym)) stall();
+        }
+
+        // Every Trade event in the ring is queued; the ring is drained.
+        size_t write_trades(EventRing& events, uint32_t sym = 0)
+        {
+            size_t n = 0;
+            events.drain([&](const Event& e) {
+                if (e.type != EventType::Trade) return;
+                write(Trade{e.id, e.maker_id, e.px, e.qty, e.ts_ns, e.side == Side::Buy}, sym);
+                ++n;
+            });
+            return n;
+        }
+
+        // Top `depth` levels of each side as rows stamped ts_ns. The levels
+        // are copied into a sink-owned buffer first, so the book walk never
+        // waits on the queue and nothing is allocated up to snapshot_depth.
+        // Call it from the book's thread, one caller at a time.
+        template <class Book>
+        void snapshot(const Book& ob, size_t depth, int64_t ts_ns, uint32_t sym = 0)
+        {
+            if (depth == 0) return;
+            levels_.clear();
+            size_t bids = 0;
+            for (Side side : {Side::Buy, Side::Sell}) {
+                const size_t first = levels_.size();
+                ob.for_each_level(side, [&](const Level& l) {
+                    levels_.push_back(LevelView{l.px, l.total_qty(), l.count()});
+                    return levels_.size() - first < depth;
+                });
+                if (side == Side::Buy) bids = levels_.size();
+            }
+            for (size_t i = 0; i < levels_.size(); ++i) {
+                const bool ask = i >= bids;
+                write_level(ts_ns, sym, ask ? 1 : 0, ask ? i - bids : i, levels_[i]);
+            }
+        }
+
+        // Block until every row queued so far is committed (or the writer failed).
+        void flush()
+        {
+            const uint64_t target = pushed_.load(std::memory_order_acquire);
+            while (committed_.load(std::memory_order_acquire) < target && !failed_.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        // Drain, commit and close. Producers must have stopped writing.
+        void close()
+        {
+            if (!thread_.joinable()) return;
+            stop_.store(true, std::memory_order_release);
+            thread_.join();
+            sqlite3_finalize(trade_stmt_);
+            sqlite3_finalize(level_stmt_);
+            sqlite3_close(db_);
+            trade_stmt_ = level_stmt_ = nullptr;
+            db_ = nullptr;
+        }
+
+        // Rows accepted by write(), and rows the writer has finished with
+        // (committed, or discarded after a failure).
+        uint64_t queued() const { return pushed_.load(std::memory_order_relaxed); }
+        uint64_t committed() const { return committed_.load(std::memory_order_relaxed); }
+        uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+        // Set once the writer hits an SQLite error; later rows are discarded.
+        bool failed() const { return failed_.load(std::memory_order_acquire); }
+        const std::string& error() const { return error_; }
+
+    private:
+        struct Row
+        {
+            enum Kind : uint8_t { TradeRow, LevelRow };
+            Kind kind{};
+            uint8_t side{};
+            uint32_t sym{};
+            uint32_t level{};
+            uint32_t orders{};
+            int64_t ts_ns{};
+            uint64_t a{};       // taker id
+            uint64_t b{};       // maker id
+            int64_t px{};
+            int64_t qty{};
+        };
+
+        void write_level(int64_t ts_ns, uint32_t sym, uint8_t side, size_t i, const LevelView& l)
+        {
+            Row r;
+            r.kind = Row::LevelRow;
+            r.sym = sym;
+            r.side = side;
+            r.level = static_cast<uint32_t>(i);
+            r.orders = static_cast<uint32_t>(l.orders);
+            r.ts_ns = ts_ns;
+            r.px = l.px;
+            r.qty = l.qty;
+            while (!push(r)) stall();
+        }
+
+        bool push(const Row& r)
+        {
+            if (!q_.try_push(r)) return false;
+            pushed_.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        void stall()
+        {
+            stalls_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+
+        // ---- writer thread ----
+
+        void run()
+        {
+            Row r;
+            for (;;) {
+                if (!q_.try_pop(r)) {
+                    commit();
+                    // Stop is only honoured once the queue is seen empty after it was set.
+                    if (stop_.load(std::memory_order_acquire)) {
+                        if (!q_.try_pop(r)) break;
+                    } else {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        continue;
+                    }
+                }
+                insert(r);
+                if (pending_ >= cfg_.batch_rows) commit();
+            }
+            commit();
+        }
+
+        void insert(const Row& r)
+        {
+            if (failed_.load(std::memory_order_relaxed)) {
+                committed_.fetch_add(1, std::memory_order_release);
+                return;
+            }
+            if (!pending_ && !step("BEGIN")) {
+                committed_.fetch_add(1, std::memory_order_release);
+                return;
+            }
+
+            sqlite3_stmt* s = r.kind == Row::TradeRow ? trade_stmt_ : level_stmt_;
+            sqlite3_bind_int64(s, 1, r.ts_ns);
+            sqlite3_bind_int64(s, 2, r.sym);
+            if (r.kind == Row::TradeRow) {
+                sqlite3_bind_int64(s, 3, static_cast<sqlite3_int64>(r.a));
+                sqlite3_bind_int64(s, 4, static_cast<sqlite3_int64>(r.b));
+                sqlite3_bind_int64(s, 5, r.px);
+                sqlite3_bind_int64(s, 6, r.qty);
+                sqlite3_bind_int64(s, 7, r.side);
+            } else {
+                sqlite3_bind_int64(s, 3, r.side);
+                sqlite3_bind_int64(s, 4, r.level);
+                sqlite3_bind_int64(s, 5, r.px);
+                sqlite3_bind_int64(s, 6, r.qty);
+                sqlite3_bind_int64(s, 7, r.orders);
+            }
+            const int rc = sqlite3_step(s);
+            sqlite3_reset(s);
+            ++pending_;
+            if (rc != SQLITE_DONE) fail();
+        }
+
+        void commit()
+        {
+            if (!pending_) return;
+            if (!failed_.load(std::memory_order_relaxed)) step("COMMIT");
+            committed_.fetch_add(pending_, std::memory_order_release);
+            pending_ = 0;
+        }
+
+        bool step(const char* sql)
+        {
+            if (sqlite3_exec(db_, sql, nullptr, nullptr, nullptr) == SQLITE_OK) return true;
+            fail();
+            return false;
+        }
+
+        void fail()
+        {
+            if (failed_.load(std::memory_order_relaxed)) return;
+            error_ = sqlite3_errmsg(db_);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            failed_.store(true, std::memory_order_release);
+        }
+
+        // ---- setup ----
+
+        void exec(const std::string& sql)
+        {
+            char* err = nullptr;
+            if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+                const std::string msg = err ? err : "unknown error";
+                sqlite3_free(err);
+                throw std::runtime_error("sqlite: " + msg + " in: " + sql);
+            }
+        }
+
+        sqlite3_stmt* prepare(const char* sql)
+        {
+            sqlite3_stmt* s = nullptr;
+            if (sqlite3_prepare_v2(db_, sql, -1, &s, nullptr) != SQLITE_OK)
+                throw std::runtime_error(std::string("sqlite prepare: ") + sqlite3_errmsg(db_));
+            return s;
+        }
+
+        SqliteConfig cfg_;
+        MpscQueue<Row> q_;
+        std::vector<LevelView> levels_;     // snapshot(): one book's levels, bids then asks
+        sqlite3* db_{nullptr};
+        sqlite3_stmt* trade_stmt_{nullptr};
+        sqlite3_stmt* level_stmt_{nullptr};
+        std::thread thread_;
+        size_t pending_{0};                 // writer thread: rows in the open transaction
+
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> failed_{false};
+        std::string error_;
+        alignas(64) std::atomic<uint64_t> pushed_{0};
+        alignas(64) std::atomic<uint64_t> committed_{0};
+        std::atomic<uint64_t> stalls_{0};
+};
+
+} // namespace io
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Call-auction price determination. The uncross price is the one that
+// maximises executable volume; ties go, in order, to
+//   1) the smallest surplus |demand - supply| left over,
+//   2) market pressure: surplus on the buy side at every remaining price
+//      picks the highest of them, on the sell side at every one the lowest,
+//   3) otherwise the price nearest the reference (the last trade price, or
+//      the middle of the remaining range if there was none), lower on a tie.
+// Only levels inside the crossed region (bids at or above the best ask,
+// asks at or below the best bid) can be candidates, and only their prices:
+// between two of them demand and supply are constant. One merge over both
+// sides builds the cumulative curves and one pass over the candidates picks
+// the price, so the cost is linear in crossed levels.
+
+struct AuctionLevel
+{
+    int64_t px;
+    int64_t qty;
+};
+
+struct AuctionResult
+{
+    int64_t px{0};              // uncross price, 0 = book not crossed
+    int64_t qty{0};             // volume executed at px
+    int64_t imbalance{0};       // demand - supply at px (> 0: buyers left over)
+};
+
+// bids best (highest) first, asks best (lowest) first, both restricted to
+// the crossed region.
+inline AuctionResult equilibrium(std::span<const AuctionLevel> bids, std::span<const AuctionLevel> asks, int64_t ref_px)
+{
+    AuctionResult r;
+    if (bids.empty() || asks.empty()) return r;
+
+    struct Candidate { int64_t px, volume, surplus; };
+    std::vector<Candidate> c;
+    c.reserve(bids.size() + asks.size());
+
+    int64_t demand = 0;
+    for (const AuctionLevel& b : bids) demand += b.qty;
+
+    // Ascending over the union of prices: supply counts asks at or below p,
+    // demand loses the bids strictly below p.
+    constexpr int64_t none = std::numeric_limits<int64_t>::max();
+    size_t i = 0, j = bids.size();
+    int64_t supply = 0;
+    while (i < asks.size() || j > 0) {
+        const int64_t p = std::min(i < asks.size() ? asks[i].px : none, j > 0 ? bids[j - 1].px : none);
+        while (i < asks.size() && asks[i].px <= p) supply += asks[i++].qty;
+        c.push_back({p, std::min(demand, supply), demand - supply});
+        while (j > 0 && bids[j - 1].px <= p) demand -= bids[--j].qty;
+    }
+
+    // 1) volume, then 2) smallest surplus
+    int64_t volume = 0, surplus = none;
+    for (const Candidate& k : c) {
+        const int64_t s = k.surplus < 0 ? -k.surplus : k.surplus;
+        if (k.volume > volume || (k.volume == volume && s < surplus)) {
+            volume = k.volume;
+            surplus = s;
+        }
+    }
+    if (volume == 0) return r;
+
+    // 3) among the remaining prices: one-sided pressure, else the reference
+    bool buy_side = true, sell_side = true;
+    int64_t lo = none, hi = 0;
+    for (const Candidate& k : c) {
+        if (k.volume != volume || (k.surplus < 0 ? -k.surplus : k.surplus) != surplus) continue;
+        buy_side &= k.surplus > 0;
+        sell_side &= k.surplus < 0;
+        lo = std::min(lo, k.px);
+        hi = std::max(hi, k.px);
+    }
+    const int64_t target = buy_side ? hi : sell_side ? lo : ref_px ? ref_px : lo + (hi - lo) / 2;
+
+    int64_t dist = none;
+    for (const Candidate& k : c) {
+        if (k.volume != volume || (k.surplus < 0 ? -k.surplus : k.surplus) != surplus) continue;
+        const int64_t d = k.px > target ? k.px - target : target - k.px;
+        if (d < dist) {         // ascending, so a tie keeps the lower price
+            dist = d;
+            r.px = k.px;
+            r.imbalance = k.surplus;
+        }
+    }
+    r.qty = volume;
+    return r;
+}
@@ -1,52 +1,327 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
+#include "auction.hpp"
+#include "event.hpp"
+#include "expiry.hpp"
+#include "id_map.hpp"
+#include "impact.hpp"
+#include "ladder.hpp"
+#include "msg.hpp"
 #include "order.hpp"
+#include "policies.hpp"
 #include "price_level.hpp"
+#include "util.hpp"
 #include <cstdint>
+#include <limits>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <vector>
-#include <functional>
 
 
 struct LevelView{int64_t px; int64_t qty; size_t orders;};
 
+// One resting order as stored in a snapshot (side and price come from its level).
+struct RestingOrder
+{
+    uint64_t id;
+    int64_t qty;
+    int64_t ts_ns;
+    uint32_t account;
+    TIF tif;                    // resting lifetime: Day or GTC
+    uint8_t reserved[3];        // written as 0
+};
 
-class OrderBook 
+// Preallocated capacities. Exceeding them is allowed (the pools grow), but
+// sizing them to the working set keeps the steady state malloc-free.
+struct BookConfig
+{
+    LadderConfig ladder{};
+    size_t orders{4096};        // resting order nodes + id index slots
+    size_t events{4096};        // event ring capacity
+    size_t stops{256};          // pending stop nodes + stop / iceberg / GTD state
+    int64_t expiry_tick_ns{1'000'000};  // GTD timer wheel resolution (cost, not precision)
+};
+
+struct MemoryStats
+{
+    PoolStats orders;           // QueueEntry node pool
+    PoolStats index;            // id -> node table
+    PoolStats bid_levels;
+    PoolStats ask_levels;
+    PoolStats events;
+    PoolStats stops;            // pending stop node pool
+};
+
+
+// Ladder picks the price-level container for both sides (MapLadder or
+// ArrayLadder, see ladder.hpp); P bundles the event sink, self-trade hook and
+// validation level (policies.hpp). Use the OrderBook / ArrayOrderBook aliases
+// unless you need other policies.
+//
+// Matching is written once per side via SideTraits and once per order type /
+// TIF via add<Type, TIF>; the runtime add() only picks the instantiation.
+//
+// Stop and StopLimit orders wait off-book in two price-indexed trigger
+// ladders (buy stops lowest first, sell stops highest first) and are
+// released, in that order, once the last trade price reaches them: each
+// release pops the front of the best trigger level, so a cascade costs
+// O(stops triggered). Icebergs are limit orders with display_qty set: only
+// the peak rests in the level, and when it fills the same node is refilled
+// from the hidden quantity and moved to the back of its queue.
+//
+// Resting orders keep their lifetime: Day (also PostOnly), GTC or GTD. GTD
+// orders sit in a timing wheel (expiry.hpp) and leave the book when
+// advance_time() passes their expire_ns; nothing else ever expires on its
+// own. The book has no clock besides advance_time(), so a session is ended
+// by the caller: cancel_day() for the Day orders, or the per-side bulk
+// cancels, which drop whole levels at once.
+// Member definitions live in book_impl.hpp; the two default-policy books are
+// compiled once in book.cpp.
+template <template <Side> class Ladder, class P = DefaultPolicies>
+class BasicOrderBook
 {
     public:
-        OrderBook(std::string symbol, int64_t tick);
+        using Policy = P;
+        using Sink = typename P::Sink;
+        using Stp = typename P::Stp;
+        using Validation = typename P::Validation;
+        using Metrics = typename P::Metrics;
+        using Publisher = typename P::Publisher;
+
+        BasicOrderBook(std::string symbol, int64_t tick, const BookConfig& cfg = {});
 
+        // cancel() also takes pending stops; replace() only resting orders.
+        // For an iceberg, replace qty is the new total, shown plus hidden.
         bool add(const Order& o);
         bool cancel(uint64_t id, int64_t ts);
         bool replace(uint64_t id, int64_t new_px, int64_t new_qty, int64_t ts);
 
-        std::vector<LevelView> bids(int depth) const;
-        std::vector<LevelView> asks(int depth) const;
+        // Type and TIF fixed at compile time (o.type / o.tif are ignored), for
+        // callers that know them up front, e.g. an IOC-only taker feed. Same
+        // result as add() on an order with that type and TIF.
+        template <Type T, TIF F>
+        bool add(const Order& o);
+
+        // Batch entry points: apply msgs in order, writing one status per
+        // message (RejectReason::None = accepted) into the caller's array,
+        // which must be at least as long. Returns the number accepted.
+        size_t apply_batch(std::span<const OrderMsg> msgs, std::span<RejectReason> status);
+        size_t add_batch(std::span<const Order> orders, std::span<RejectReason> status);
+
+        // Why the most recent add/cancel/replace returned false.
+        RejectReason last_reject() const { return last_reject_; }
+
+        std::vector<LevelView> bids(int depth) const { return depth_view<Side::Buy>(depth); }
+        std::vector<LevelView> asks(int depth) const { return depth_view<Side::Sell>(depth); }
+
+        // Market impact of a hypothetical taker on `side`, book unchanged
+        // (impact.hpp): what qty would fill and at what cost, how much is
+        // available up to px, and the limit price that fills qty (0 = the
+        // book is too thin). depth_curve() snapshots one side, up to
+        // max_levels, for many such queries at once.
+        FillEstimate fill_estimate(Side side, int64_t qty) const;
+        int64_t qty_up_to(Side side, int64_t px) const;
+        int64_t px_to_fill(Side side, int64_t qty) const;
+        DepthCurve depth_curve(Side side, size_t max_levels = std::numeric_limits<size_t>::max()) const;
+
+        // Call auction (auction.hpp). After begin_auction(), limit orders
+        // rest without matching, so the book may cross, and market, IOC, FOK
+        // and stop orders are rejected (RejectReason::Auction). replace()
+        // and cancel() work as usual. auction_price() is the indicative
+        // uncross; uncross() executes it, every fill at that one price, and
+        // returns the book to continuous matching.
+        void begin_auction() { auction_ = true; }
+        bool in_auction() const { return auction_; }
+        AuctionResult auction_price() const;
+        AuctionResult uncross(int64_t ts_ns);
+
+        // Book time for GTD orders: expire every one whose expire_ns <=
+        // ts_ns (an Expire event each) and return how many went. A GTD
+        // add() must expire after the last ts_ns passed here.
+        size_t advance_time(int64_t ts_ns);
+        size_t expiry_count() const { return expiries_.size(); }
+
+        // Bulk cancels for session end; each returns the number of orders
+        // removed. Every order still gets its Cancel event, but whole levels
+        // are dropped from the ladder at once and the id index is swept
+        // rather than probed per order. cancel_beyond() takes every order on
+        // `side` at px or worse (bids at or below px, asks at or above).
+        // Pending stops are left alone.
+        size_t cancel_day(int64_t ts_ns);
+        size_t cancel_side(Side side, int64_t ts_ns);
+        size_t cancel_beyond(Side side, int64_t px, int64_t ts_ns);
+
+        // Everything that happened since the last drain (see event.hpp).
+        // Read in place with events().drain(f) -- no copies, no allocation.
+        EventRing& events() { return sink_.ring(); }
+        const EventRing& events() const { return sink_.ring(); }
+
+        // Convenience: drains the event stream and returns just the trades.
+        std::vector<Trade> pop_trade();
+
+        MemoryStats memory_stats() const;
+
+        // Counters and latency histograms (metrics.hpp); only for books
+        // built with an enabled Metrics policy, e.g. InstrumentedOrderBook.
+        const MetricsSnapshot& metrics() const requires Metrics::enabled { return metrics_.snapshot(); }
+        void reset_metrics() requires Metrics::enabled { metrics_.reset(); }
+
+        // Top-N quotes for other threads (top_of_book.hpp): any thread may
+        // call top_of_book().read() while this book is being mutated.
+        const Publisher& top_of_book() const requires Publisher::enabled { return publisher_; }
+
+        // Self-trade prevention policy and, for AccountStp, the per-account
+        // tallies: stp().account(id).
+        const Stp& stp() const { return stp_; }
+
+        const std::string& symbol() const { return symbol_; }
+        int64_t tick() const { return tick_; }
+        size_t order_count() const { return id_index_.size(); }
+        size_t stop_count() const { return stops_.size(); }
+        size_t iceberg_count() const { return icebergs_; }
+        int64_t last_trade_px() const { return last_px_; }      // 0 = no trade yet
+        size_t level_count(Side side) const { return side == Side::Buy ? bid_levels_.size() : ask_levels_.size(); }
 
-        std::vector<Trade> pop_trade() 
+        // Best-first walk of one side: f(const Level&) per level; each
+        // level's queue (head -> next) is in time priority. If f returns
+        // bool, false stops the walk.
+        template <class F>
+        void for_each_level(Side side, F&& f) const
         {
-            auto out = std::move(trades_);
-            trades_.clear();
-            return out;
+            auto visit = [&](const Level& l) {
+                if constexpr (std::is_same_v<std::invoke_result_t<F&, const Level&>, bool>) return f(l);
+                else { f(l); return true; }
+            };
+            if (side == Side::Buy) bid_levels_.for_each(visit);
+            else ask_levels_.for_each(visit);
         }
 
+        // Snapshot restore: append orders, in the given order, to the back of
+        // the level at px. No matching or events. Returns why the level was
+        // refused, leaving the book unchanged: BadPrice (px <= 0, off tick or
+        // past the ladder cap), WouldCross, BadQty, BadAccount or DuplicateId.
+        RejectReason load_level(Side side, int64_t px, std::span<const RestingOrder> fifo);
+        // Snapshot restore: the last trade price, which arms stops and is the
+        // auction's reference price. 0 = no trade yet.
+        void load_last_trade_px(int64_t px) { last_px_ = px; }
+
     private:
         std::string symbol_;
         int64_t tick_{1};
 
         //price ladder
 
-        std::map<int64_t, Level, std::greater<int64_t>> bid_levels_;
-        std::map<int64_t, Level> ask_levels_;
+        Ladder<Side::Buy> bid_levels_;
+        Ladder<Side::Sell> ask_levels_;
+
+        IdMap id_index_;
+
+        // Pending stops, keyed by stop price in trigger order.
+        MapLadder<Side::Sell> buy_stops_;
+        MapLadder<Side::Buy> sell_stops_;
+        IdMap stops_;
+        ObjectPool<OrderExt> ext_;
+        size_t icebergs_{0};
+        ExpiryWheel expiries_;
+        std::vector<QueueEntry*> dropped_;      // bulk cancels: nodes awaiting the index sweep
+        std::vector<Level*> emptied_;           // cancel_day: levels to erase once the walk is done
+        int64_t last_px_{0};
+        bool triggering_{false};
+        bool auction_{false};
+
+        Sink sink_;
+        [[no_unique_address]] Stp stp_;
+        [[no_unique_address]] Metrics metrics_;
+        [[no_unique_address]] Publisher publisher_;
+        RejectReason last_reject_{RejectReason::None};
+
+        template <Side S>
+        auto& levels()
+        {
+            if constexpr (S == Side::Buy) return bid_levels_;
+            else return ask_levels_;
+        }
+
+        template <Side S>
+        const auto& levels() const
+        {
+            if constexpr (S == Side::Buy) return bid_levels_;
+            else return ask_levels_;
+        }
+
+        // Whether an order could rest at px without growing the ladder past its cap.
+        bool fits(Side side, int64_t px) const
+        {
+            return side == Side::Buy ? bid_levels_.fits(px) : ask_levels_.fits(px);
+        }
+
+        // Republish top-of-book when the calling entry point returns.
+        auto publish_on_exit(int64_t ts_ns)
+        {
+            if constexpr (Publisher::enabled) return PublishGuard<Publisher, BasicOrderBook>{publisher_, *this, ts_ns};
+            else return 0;
+        }
 
-        struct Handle {Side side; int64_t px;};
-        std::unordered_map<uint64_t, Handle> id_index_;
-        
-        std::vector<Trade> trades_;
         //Some helpers
-        bool match_incoming(Order& in);
-        bool can_fully_fill(const Order& in) const;
-        bool would_cross_limit(const Order& in) const;
+        bool reject(uint64_t id, RejectReason why, int64_t ts_ns);
+        void accept(const Order& o);
+        void level_update(Side side, const Level& lvl, int64_t ts_ns);
+        void order_event(EventType type, const QueueEntry& e, int64_t px, int64_t qty, size_t pos, int64_t ts_ns);
+        void remove_resting(QueueEntry* e, int64_t ts_ns);
+        void erase_order(QueueEntry* e);
+        void release_ext(QueueEntry* e);
+        void drop_order(QueueEntry& e, int64_t px, size_t pos, int64_t ts_ns);
+        size_t flush_dropped();
+        template <Side S> size_t drop_levels(int64_t px, bool all, int64_t ts_ns);
+        template <Side S> void drop_day(int64_t ts_ns);
+        static constexpr TIF resting_tif(TIF f) { return f == TIF::GTC || f == TIF::GTD ? f : TIF::Day; }
+        void replenish(Level& lvl, QueueEntry& e, int64_t ts_ns);
+        template <Side S> bool auction_take(Level& lvl, QueueEntry& e, int64_t qty, int64_t ts_ns);
+        // A GTD order has an OrderExt too; only a non-zero peak makes an iceberg.
+        static bool is_iceberg(const QueueEntry& e) { return e.ext && e.ext->peak > 0; }
+        static int64_t hidden_qty(const QueueEntry& e) { return is_iceberg(e) ? e.ext->hidden : 0; }
+
+        bool add_stop(const Order& o, Type type);
+        void trigger_stops(int64_t ts_ns);
+        void release_stop(QueueEntry* e, int64_t ts_ns);
+        void drop_stop(QueueEntry* e);
+
+        template <class Fn> static bool dispatch(const Order& o, Fn&& f);
+        template <Type T, TIF F> bool place(const Order& o, bool announce);
+        template <Side S, Type T, TIF F> bool execute(const Order& o, bool announce);
+        template <Side S, Type T> void match(Order& in);
+        template <Side S> void rest(const Order& o, TIF life);
+        template <Side S> void reprice(Order& in);
+        template <Side S, Type T> bool can_fully_fill(const Order& in) const;
+        template <Side S> bool crosses_book(int64_t px) const;
+        template <Side S> std::vector<LevelView> depth_view(int depth) const;
 };
+
+#include "book_impl.hpp"
+
+extern template class BasicOrderBook<MapLadder>;
+extern template class BasicOrderBook<ArrayLadder>;
+
+using OrderBook = BasicOrderBook<MapLadder>;
+using ArrayOrderBook = BasicOrderBook<ArrayLadder>;
+
+// Publishes the market-by-order feed (OrderAdded / OrderReduced / OrderRemoved).
+using MboOrderBook = BasicOrderBook<MapLadder, Policies<MboSink>>;
+using MboArrayOrderBook = BasicOrderBook<ArrayLadder, Policies<MboSink>>;
+
+// Publishes the top N levels of each side for concurrent readers.
+template <size_t N = 5>
+using PublishingOrderBook = BasicOrderBook<MapLadder, Policies<RingSink, NoStp, FullValidation, NoMetrics, TopOfBook<N>>>;
+template <size_t N = 5>
+using PublishingArrayOrderBook = BasicOrderBook<ArrayLadder, Policies<RingSink, NoStp, FullValidation, NoMetrics, TopOfBook<N>>>;
+
+// Self-trade prevention by Order::account plus per-account tallies.
+template <StpAction A = StpAction::CancelIncoming>
+using StpOrderBook = BasicOrderBook<MapLadder, Policies<RingSink, AccountStp<A>>>;
+template <StpAction A = StpAction::CancelIncoming>
+using StpArrayOrderBook = BasicOrderBook<ArrayLadder, Policies<RingSink, AccountStp<A>>>;
+
+using InstrumentedPolicies = Policies<RingSink, NoStp, FullValidation, BookMetrics>;
+using InstrumentedOrderBook = BasicOrderBook<MapLadder, InstrumentedPolicies>;
+using InstrumentedArrayOrderBook = BasicOrderBook<ArrayLadder, InstrumentedPolicies>;
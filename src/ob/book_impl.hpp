@@ -0,0 +1,1053 @@
+#pragma once
+// BasicOrderBook member definitions. Included at the end of book.hpp; do not
+// include directly.
+#include <algorithm>
+#include <utility>
+
+template <template <Side> class Ladder, class P>
+BasicOrderBook<Ladder, P>::BasicOrderBook(std::string symbol, int64_t tick, const BookConfig& cfg)
+    : symbol_(std::move(symbol)), tick_{tick},
+      bid_levels_(tick, cfg.ladder), ask_levels_(tick, cfg.ladder),
+      id_index_(cfg.orders),
+      buy_stops_(tick, LadderConfig{.levels = cfg.stops}), sell_stops_(tick, LadderConfig{.levels = cfg.stops}),
+      stops_(cfg.stops), ext_(cfg.stops), expiries_(cfg.expiry_tick_ns), sink_(cfg.events)
+{
+    dropped_.reserve(cfg.orders);
+    emptied_.reserve(std::max(bid_levels_.pool_stats().capacity, ask_levels_.pool_stats().capacity));
+}
+
+// The only runtime look at type/TIF: call f.operator()<T, F>() for o's
+// market or limit instantiation. Stops are handled before this.
+template <template <Side> class Ladder, class P>
+template <class Fn>
+bool BasicOrderBook<Ladder, P>::dispatch(const Order& o, Fn&& f) {
+    if (o.type == Type::Market) {
+        switch (o.tif) {
+            case TIF::FOK:      return f.template operator()<Type::Market, TIF::FOK>();
+            case TIF::PostOnly: return f.template operator()<Type::Market, TIF::PostOnly>();
+            default:            return f.template operator()<Type::Market, TIF::IOC>();     // markets never rest (v1)
+        }
+    }
+    switch (o.tif) {
+        case TIF::IOC:      return f.template operator()<Type::Limit, TIF::IOC>();
+        case TIF::FOK:      return f.template operator()<Type::Limit, TIF::FOK>();
+        case TIF::PostOnly: return f.template operator()<Type::Limit, TIF::PostOnly>();
+        case TIF::GTC:      return f.template operator()<Type::Limit, TIF::GTC>();
+        case TIF::GTD:      return f.template operator()<Type::Limit, TIF::GTD>();
+        default:            return f.template operator()<Type::Limit, TIF::Day>();
+    }
+}
+
+template <template <Side> class Ladder, class P>
+bool BasicOrderBook<Ladder, P>::add(const Order& o) {
+    if (o.type == Type::Stop || o.type == Type::StopLimit) [[unlikely]] return add_stop(o, o.type);
+    return dispatch(o, [&]<Type T, TIF F>() { return add<T, F>(o); });
+}
+
+template <template <Side> class Ladder, class P>
+template <Type T, TIF F>
+bool BasicOrderBook<Ladder, P>::add(const Order& o) {
+    if constexpr (T == Type::Stop || T == Type::StopLimit) {
+        return add_stop(o, T);
+    } else {
+        [[maybe_unused]] const auto timer = metrics_.time(BookOp::Add);
+        [[maybe_unused]] const auto publish = publish_on_exit(o.ts_ns);
+        metrics_.on_add();
+        return place<T, F>(o, true);
+    }
+}
+
+// Validate and execute a market or limit order. A released stop comes in with
+// announce = false: it was counted and accepted when it was parked.
+template <template <Side> class Ladder, class P>
+template <Type T, TIF F>
+bool BasicOrderBook<Ladder, P>::place(const Order& o, bool announce) {
+    // qty must be positive (and an iceberg peak not negative)
+    if constexpr (Validation::qty)
+        if (o.qty <= 0 || o.display_qty < 0) return reject(o.id, RejectReason::BadQty, o.ts_ns);
+
+    // the Stp policy's per-account tables are bounded
+    if constexpr (Stp::enabled)
+        if (!stp_.admits(o.account)) return reject(o.id, RejectReason::BadAccount, o.ts_ns);
+
+    // Reject duplicate IDs (replace() owns updates); a released stop has
+    // already left stops_
+    if constexpr (Validation::duplicate_id)
+        if (id_index_.contains(o.id) || (stops_.size() && stops_.contains(o.id)))
+            return reject(o.id, RejectReason::DuplicateId, o.ts_ns);
+
+    // LIMIT-specific validations (MARKET has no price/tick check)
+    if constexpr (T == Type::Limit && Validation::price)
+        if (o.px <= 0 || (o.px % tick_) != 0) return reject(o.id, RejectReason::BadPrice, o.ts_ns);
+
+    if constexpr (T == Type::Limit && F == TIF::GTD)
+        if (o.expire_ns <= expiries_.now_ns()) return reject(o.id, RejectReason::BadExpiry, o.ts_ns);
+
+    // orders that may rest must fit the ladder (an ArrayLadder window is capped)
+    if constexpr (T == Type::Limit && F != TIF::IOC && F != TIF::FOK)
+        if (!fits(o.side, o.px)) return reject(o.id, RejectReason::BadPrice, o.ts_ns);
+
+    if (auction_) [[unlikely]] {
+        if constexpr (T != Type::Limit || F == TIF::IOC || F == TIF::FOK) {
+            return reject(o.id, RejectReason::Auction, o.ts_ns);
+        } else {
+            if (announce) accept(o);
+            if (o.side == Side::Buy) rest<Side::Buy>(o, resting_tif(F));
+            else rest<Side::Sell>(o, resting_tif(F));
+            return true;
+        }
+    }
+
+    const bool ok = o.side == Side::Buy ? execute<Side::Buy, T, F>(o, announce)
+                                        : execute<Side::Sell, T, F>(o, announce);
+    if (stops_.size()) [[unlikely]] trigger_stops(o.ts_ns);
+    return ok;
+}
+
+// Validate and park a stop; it goes straight through trigger_stops(), so one
+// that the last trade has already reached is released at once.
+template <template <Side> class Ladder, class P>
+bool BasicOrderBook<Ladder, P>::add_stop(const Order& o, Type type) {
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Add);
+    [[maybe_unused]] const auto publish = publish_on_exit(o.ts_ns);
+    metrics_.on_add();
+
+    if constexpr (Validation::qty)
+        if (o.qty <= 0 || o.display_qty < 0) return reject(o.id, RejectReason::BadQty, o.ts_ns);
+
+    if constexpr (Stp::enabled)
+        if (!stp_.admits(o.account)) return reject(o.id, RejectReason::BadAccount, o.ts_ns);
+
+    if constexpr (Validation::duplicate_id)
+        if (id_index_.contains(o.id) || stops_.contains(o.id)) return reject(o.id, RejectReason::DuplicateId, o.ts_ns);
+
+    if (auction_) return reject(o.id, RejectReason::Auction, o.ts_ns);
+
+    // stop price always; limit price only for StopLimit
+    if constexpr (Validation::price) {
+        if (o.stop_px <= 0 || (o.stop_px % tick_) != 0) return reject(o.id, RejectReason::BadPrice, o.ts_ns);
+        if (type == Type::StopLimit && (o.px <= 0 || (o.px % tick_) != 0))
+            return reject(o.id, RejectReason::BadPrice, o.ts_ns);
+    }
+
+    // a GTD stop-limit keeps its expiry for the limit it becomes; the stop
+    // itself does not expire while pending
+    if (type == Type::StopLimit && o.tif == TIF::GTD && o.expire_ns <= expiries_.now_ns())
+        return reject(o.id, RejectReason::BadExpiry, o.ts_ns);
+
+    accept(o);
+    QueueEntry* e = stops_.emplace(o.id, o.side, o.qty, o.ts_ns);
+    e->account = o.account;
+    e->ext = ext_.create(OrderExt{o.display_qty, 0, o.px, type, o.tif});
+    e->ext->expire_ns = o.expire_ns;
+    if (o.side == Side::Buy) buy_stops_.get_or_create(o.stop_px).push_back(e);
+    else sell_stops_.get_or_create(o.stop_px).push_back(e);
+    trigger_stops(o.ts_ns);
+    return true;
+}
+
+// Release every stop the last trade price has reached. Released orders trade
+// and may move the price further; the loop picks those up too, so a cascade
+// is handled here iteratively rather than by recursing through add().
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::trigger_stops(int64_t ts_ns)
+{
+    if (triggering_ || last_px_ == 0) return;
+    triggering_ = true;
+    for (;;) {
+        const Level* b = buy_stops_.best();
+        const Level* s = sell_stops_.best();
+        if (b && last_px_ >= b->px) release_stop(b->front(), ts_ns);
+        else if (s && last_px_ <= s->px) release_stop(s->front(), ts_ns);
+        else break;
+    }
+    triggering_ = false;
+}
+
+// A triggered stop becomes a market (Stop) or limit (StopLimit) order with
+// its own TIF, timestamped at the trigger, and goes through the same typed
+// body as add<T, F>() minus a second Accept, add count and Add timer.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::release_stop(QueueEntry* e, int64_t ts_ns)
+{
+    const OrderExt& x = *e->ext;
+    Order o;
+    o.id          = e->id;
+    o.side        = e->side;
+    o.type        = x.type == Type::StopLimit ? Type::Limit : Type::Market;
+    o.tif         = x.tif;
+    o.px          = x.px;
+    o.qty         = e->qty;
+    o.ts_ns       = ts_ns;
+    o.display_qty = x.peak;
+    o.account     = e->account;
+    o.expire_ns   = x.expire_ns;
+
+    Event ev;
+    ev.type  = EventType::StopTriggered;
+    ev.id    = e->id;
+    ev.side  = e->side;
+    ev.px    = e->level->px;
+    ev.qty   = e->qty;
+    ev.ts_ns = ts_ns;
+    sink_.push(ev);
+
+    drop_stop(e);
+    dispatch(o, [&]<Type T, TIF F>() { return place<T, F>(o, false); });
+}
+
+// Unlink a pending stop from its trigger level and recycle it.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::drop_stop(QueueEntry* e)
+{
+    Level* lvl = e->level;
+    lvl->unlink(e);
+    if (lvl->empty()) {
+        if (e->side == Side::Buy) buy_stops_.erase(lvl);
+        else sell_stops_.erase(lvl);
+    }
+    ext_.destroy(e->ext);
+    stops_.erase(e);
+}
+
+template <template <Side> class Ladder, class P>
+template <Side S, Type T, TIF F>
+bool BasicOrderBook<Ladder, P>::execute(const Order& o, bool announce) {
+    // POST-ONLY: reject if it would cross (always, for a market); else rest without matching
+    if constexpr (F == TIF::PostOnly) {
+        if constexpr (T == Type::Market) {
+            return reject(o.id, RejectReason::WouldCross, o.ts_ns);
+        } else {
+            if (crosses_book<S>(o.px)) return reject(o.id, RejectReason::WouldCross, o.ts_ns);
+            if (announce) accept(o);
+            rest<S>(o, TIF::Day);
+            return true;
+        }
+    } else {
+        // FOK: must be fully fillable upfront; if not, reject
+        if constexpr (F == TIF::FOK)
+            if (!can_fully_fill<S, T>(o)) return reject(o.id, RejectReason::CannotFill, o.ts_ns);
+
+        if (announce) accept(o);
+        Order in = o;
+        match<S, T>(in);
+
+        if constexpr (F == TIF::FOK) return in.qty == 0;       // by design should be fully filled
+
+        // Rest any remainder FIFO at its price level; markets and IOC never rest.
+        if constexpr (T == Type::Limit && F != TIF::IOC)
+            if (in.qty > 0) rest<S>(in, resting_tif(F));
+        return true;
+    }
+}
+
+template <template <Side> class Ladder, class P>
+bool BasicOrderBook<Ladder, P>::cancel(uint64_t id, int64_t ts) {
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Cancel);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts);
+    QueueEntry* e = id_index_.find(id);
+    const bool stop = !e && stops_.size() && (e = stops_.find(id));
+    if (!e) return reject(id, RejectReason::UnknownId, ts);
+
+    Event ev;
+    ev.type  = EventType::Cancel;
+    ev.id    = id;
+    ev.side  = e->side;
+    ev.px    = e->level->px;            // stop price for a pending stop
+    ev.qty   = e->qty + (stop ? 0 : hidden_qty(*e));
+    ev.ts_ns = ts;
+    sink_.push(ev);
+
+    if (stop) drop_stop(e);
+    else remove_resting(e, ts);
+    metrics_.on_cancel();
+    return true;
+}
+
+template <template <Side> class Ladder, class P>
+bool BasicOrderBook<Ladder, P>::replace(uint64_t id, int64_t new_px, int64_t new_qty, int64_t ts_ns) {
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Replace);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+
+    // sanity
+    if constexpr (Validation::qty)
+        if (new_qty <= 0) return reject(id, RejectReason::BadQty, ts_ns);
+
+    // locate by id
+    QueueEntry* e = id_index_.find(id);
+    if (!e) return reject(id, RejectReason::UnknownId, ts_ns);
+
+    const Side side = e->side;
+    const bool price_change = (new_px != e->level->px);
+
+    // tick check for price changes; the new level must also fit the ladder
+    if constexpr (Validation::price)
+        if (price_change && (new_px <= 0 || (new_px % tick_) != 0))
+            return reject(id, RejectReason::BadPrice, ts_ns);
+    if (price_change && !fits(side, new_px)) return reject(id, RejectReason::BadPrice, ts_ns);
+
+    Event ev;
+    ev.type  = EventType::Replace;
+    ev.id    = id;
+    ev.side  = side;
+    ev.px    = new_px;
+    ev.qty   = new_qty;
+    ev.ts_ns = ts_ns;
+    sink_.push(ev);
+    metrics_.on_replace();
+
+    if (price_change) {
+        // same owner, iceberg peak and lifetime
+        Order in;
+        in.id          = id;
+        in.side        = side;
+        in.type        = Type::Limit;
+        in.tif         = e->tif;
+        in.expire_ns   = e->ext ? e->ext->expire_ns : 0;
+        in.px          = new_px;
+        in.qty         = new_qty;
+        in.ts_ns       = ts_ns;
+        in.display_qty = e->ext ? e->ext->peak : 0;
+        in.account     = e->account;
+        remove_resting(e, ts_ns);
+        if (side == Side::Buy) reprice<Side::Buy>(in);
+        else reprice<Side::Sell>(in);
+        if (stops_.size()) trigger_stops(ts_ns);
+        return true;
+    }
+
+    // price unchanged; an iceberg's qty is its total, shown plus hidden
+    const int64_t total = e->qty + hidden_qty(*e);
+    if (new_qty == total) return true; // nothing to do
+    stp_.on_open(e->account, side, new_qty - total);
+
+    Level& lvl = *e->level;
+    if (new_qty < total) {
+        // shrink in place: keep FIFO position, hidden quantity goes first
+        const int64_t show = std::min(e->qty, new_qty);
+        if (is_iceberg(*e)) e->ext->hidden = new_qty - show;
+        if (show == e->qty) return true;
+        lvl.resize(e, show);
+        if constexpr (Sink::order_events)
+            order_event(EventType::OrderReduced, *e, lvl.px, show, lvl.position(e), ts_ns);
+    } else {
+        // increase: reset time (move to back)
+        const bool iceberg = is_iceberg(*e);
+        const int64_t show = iceberg ? std::min(e->ext->peak, new_qty) : new_qty;
+        if (iceberg) e->ext->hidden = new_qty - show;
+        if constexpr (Sink::order_events)
+            order_event(EventType::OrderRemoved, *e, lvl.px, e->qty, lvl.position(e), ts_ns);
+        lvl.resize(e, show);
+        e->ts_ns = ts_ns;
+        lvl.move_to_back(e);
+        if constexpr (Sink::order_events)
+            order_event(EventType::OrderAdded, *e, lvl.px, show, lvl.count() - 1, ts_ns);
+    }
+    level_update(side, lvl, ts_ns);
+    return true;
+}
+
+// A repriced order is a fresh limit with its old lifetime: it may trade
+// immediately (not in an auction), then rests.
+template <template <Side> class Ladder, class P>
+template <Side S>
+void BasicOrderBook<Ladder, P>::reprice(Order& in)
+{
+    if (!auction_) match<S, Type::Limit>(in);
+    if (in.qty > 0) rest<S>(in, in.tif);
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::apply_batch(std::span<const OrderMsg> msgs, std::span<RejectReason> status)
+{
+    size_t accepted = 0;
+    const size_t n = std::min(msgs.size(), status.size());
+    for (size_t i = 0; i < n; ++i) {
+        const OrderMsg& m = msgs[i];
+        bool ok;
+        switch (static_cast<MsgKind>(m.kind)) {
+            case MsgKind::Add:
+                ok = valid_add(m) ? add(to_order(m)) : reject(m.id, RejectReason::BadMessage, m.ts_ns);
+                break;
+            case MsgKind::Cancel:  ok = cancel(m.id, m.ts_ns); break;
+            case MsgKind::Replace: ok = replace(m.id, m.px, m.qty, m.ts_ns); break;
+            default:               ok = reject(m.id, RejectReason::BadMessage, m.ts_ns); break;
+        }
+        status[i] = ok ? RejectReason::None : last_reject_;
+        accepted += ok;
+    }
+    return accepted;
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::add_batch(std::span<const Order> orders, std::span<RejectReason> status)
+{
+    size_t accepted = 0;
+    const size_t n = std::min(orders.size(), status.size());
+    for (size_t i = 0; i < n; ++i) {
+        const bool ok = add(orders[i]);
+        status[i] = ok ? RejectReason::None : last_reject_;
+        accepted += ok;
+    }
+    return accepted;
+}
+
+// Cross `in` against the opposite side, best level first, FIFO within a level.
+// Trades print at the resting price. One body for both sides: SideTraits<S>
+// supplies the price comparison, levels<>() the ladder.
+template <template <Side> class Ladder, class P>
+template <Side S, Type T>
+void BasicOrderBook<Ladder, P>::match(Order& in) {
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Match);
+    constexpr Side opp_side = SideTraits<S>::opposite;
+    auto& opp = levels<opp_side>();
+    size_t swept = 0;
+    [[maybe_unused]] const bool screen = Stp::enabled && stp_.active(in);
+
+    while (in.qty > 0 && !opp.empty()) {
+        Level& lvl = *opp.best();
+        if constexpr (T == Type::Limit)
+            if (!SideTraits<S>::crosses(in.px, lvl.px)) break;
+        ++swept;
+
+        while (in.qty > 0 && !lvl.empty()) {
+            QueueEntry& maker = *lvl.front();
+            const int64_t exec = std::min(in.qty, maker.qty);
+            bool fill = true;
+
+            if constexpr (Stp::enabled) {
+                const StpAction act = screen ? stp_.check(in, maker) : StpAction::Trade;
+                if (act == StpAction::Decrement) {
+                    // both sides shrink by exec, nothing prints
+                    Event ev;
+                    ev.type     = EventType::SelfTradePrevented;
+                    ev.id       = in.id;
+                    ev.maker_id = maker.id;
+                    ev.px       = lvl.px;
+                    ev.qty      = exec;
+                    ev.ts_ns    = in.ts_ns;
+                    ev.side     = S;
+                    sink_.push(ev);
+                    stp_.on_open(maker.account, opp_side, -exec);
+                    fill = false;
+                } else if (act != StpAction::Trade) {
+                    if (act == StpAction::CancelResting || act == StpAction::CancelBoth) {
+                        Event ev;
+                        ev.type  = EventType::Cancel;
+                        ev.id    = maker.id;
+                        ev.side  = opp_side;
+                        ev.px    = lvl.px;
+                        ev.qty   = maker.qty + hidden_qty(maker);
+                        ev.ts_ns = in.ts_ns;
+                        sink_.push(ev);
+                        stp_.on_open(maker.account, opp_side, -ev.qty);
+                        if constexpr (Sink::order_events)
+                            order_event(EventType::OrderRemoved, maker, lvl.px, maker.qty, 0, in.ts_ns);
+                        lvl.unlink(&maker);
+                        erase_order(&maker);
+                    }
+                    if (act == StpAction::CancelIncoming || act == StpAction::CancelBoth) {
+                        Event ev;
+                        ev.type  = EventType::Cancel;
+                        ev.id    = in.id;
+                        ev.side  = S;
+                        ev.px    = in.px;
+                        ev.qty   = in.qty;
+                        ev.ts_ns = in.ts_ns;
+                        sink_.push(ev);
+                        in.qty = 0;
+                    }
+                    continue;
+                }
+            }
+
+            if (fill) {
+                Event tr;
+                tr.type     = EventType::Trade;
+                tr.id       = in.id;
+                tr.maker_id = maker.id;
+                tr.px       = lvl.px;
+                tr.qty      = exec;
+                tr.ts_ns    = in.ts_ns;              // good enough for v1
+                tr.side     = S;
+                sink_.push(tr);
+                last_px_ = lvl.px;
+                metrics_.on_fill(exec);
+                stp_.on_fill(in.account, maker.account, S, exec);
+            }
+
+            // apply fill (or decrement)
+            in.qty -= exec;
+            lvl.reduce(&maker, exec);
+
+            if (maker.qty == 0) {
+                // iceberg with more in reserve: refill the peak at the back
+                if (is_iceberg(maker) && maker.ext->hidden > 0) [[unlikely]] {
+                    replenish(lvl, maker, in.ts_ns);
+                    continue;
+                }
+                if constexpr (Sink::order_events)
+                    order_event(EventType::OrderRemoved, maker, lvl.px, 0, 0, in.ts_ns);
+                lvl.unlink(&maker);
+                erase_order(&maker);
+            } else {
+                // partial at front; taker is done
+                if constexpr (Sink::order_events)
+                    order_event(EventType::OrderReduced, maker, lvl.px, maker.qty, 0, in.ts_ns);
+                break;
+            }
+        }
+        // The level always changed: something traded or was self-trade cancelled / decremented.
+        level_update(opp_side, lvl, in.ts_ns);
+        metrics_.on_level_destroyed(lvl.empty());
+        if (lvl.empty()) opp.erase(&lvl);
+    }
+    metrics_.on_sweep(swept);
+}
+
+template <template <Side> class Ladder, class P>
+template <Side S>
+bool BasicOrderBook<Ladder, P>::crosses_book(int64_t px) const
+{
+    const auto& opp = levels<SideTraits<S>::opposite>();
+    return !opp.empty() && SideTraits<S>::crosses(px, opp.best()->px);
+}
+
+template <template <Side> class Ladder, class P>
+template <Side S, Type T>
+bool BasicOrderBook<Ladder, P>::can_fully_fill(const Order& in) const
+{
+    int64_t need = in.qty;
+    if(need <= 0) return true;
+
+    // Under self-trade prevention walk the orders in match order: liquidity
+    // the taker may not trade with doesn't count, and any action that ends
+    // or shrinks the taker before it is filled means it cannot fill.
+    if constexpr (Stp::enabled) {
+        if (stp_.active(in)) {
+            bool stopped = false;
+            levels<SideTraits<S>::opposite>().for_each([&](const Level& lvl) {
+                if constexpr (T == Type::Limit)
+                    if (!SideTraits<S>::crosses(in.px, lvl.px)) return false;
+                for (const QueueEntry* e = lvl.front(); e && need > 0; e = e->next) {
+                    const StpAction act = stp_.check(in, *e);
+                    if (act == StpAction::Trade) need -= e->qty;
+                    else if (act != StpAction::CancelResting) stopped = true;
+                    if (stopped) return false;
+                }
+                return need > 0;
+            });
+            return !stopped && need <= 0;
+        }
+    }
+
+    // Level aggregates: one subtraction per price level, not per resting order.
+    levels<SideTraits<S>::opposite>().for_each([&](const Level& lvl) {
+        if constexpr (T == Type::Limit)
+            if (!SideTraits<S>::crosses(in.px, lvl.px)) return false; // don't cross past limit
+        need -= lvl.total_qty();
+        return need > 0;
+    });
+    return need <= 0;
+}
+
+template <template <Side> class Ladder, class P>
+template <Side S>
+void BasicOrderBook<Ladder, P>::rest(const Order& o, TIF life)
+{
+    QueueEntry* e = id_index_.emplace(o.id, S, o.qty, o.ts_ns);
+    e->account = o.account;
+    e->tif = life;
+    const bool iceberg = o.display_qty > 0 && o.display_qty < o.qty;
+    if (iceberg || life == TIF::GTD) [[unlikely]] {
+        e->ext = iceberg ? ext_.create(OrderExt{o.display_qty, o.qty - o.display_qty}) : ext_.create(OrderExt{});
+        if (iceberg) {
+            e->qty = o.display_qty;
+            ++icebergs_;
+        }
+        if (life == TIF::GTD) {
+            e->ext->expire_ns = o.expire_ns;
+            expiries_.insert(e);
+        }
+    }
+    stp_.on_open(o.account, S, o.qty);
+    auto& side = levels<S>();
+    const size_t before = side.size();
+    Level& lvl = side.get_or_create(o.px);
+    metrics_.on_level_created(side.size() != before);
+    lvl.push_back(e);
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderAdded, *e, o.px, e->qty, lvl.count() - 1, o.ts_ns);
+    level_update(S, lvl, o.ts_ns);
+}
+
+template <template <Side> class Ladder, class P>
+RejectReason BasicOrderBook<Ladder, P>::load_level(Side side, int64_t px, std::span<const RestingOrder> fifo)
+{
+    if (fifo.empty()) return RejectReason::None;
+    if (px <= 0 || (px % tick_) != 0 || !fits(side, px)) return RejectReason::BadPrice;
+    if (side == Side::Buy ? crosses_book<Side::Buy>(px) : crosses_book<Side::Sell>(px)) return RejectReason::WouldCross;
+    for (const RestingOrder& r : fifo) {
+        if (r.qty <= 0) return RejectReason::BadQty;
+        if (!stp_.admits(r.account)) return RejectReason::BadAccount;
+    }
+
+    const size_t before = level_count(side);
+    Level& lvl = (side == Side::Buy) ? bid_levels_.get_or_create(px) : ask_levels_.get_or_create(px);
+    QueueEntry* const last_kept = lvl.tail;
+    for (const RestingOrder& r : fifo) {
+        // checked as we go so a repeat inside fifo is caught too; on one,
+        // take back what this call linked
+        if (id_index_.contains(r.id) || (stops_.size() && stops_.contains(r.id))) {
+            while (lvl.tail != last_kept) {
+                QueueEntry* e = lvl.tail;
+                stp_.on_open(e->account, side, -e->qty);
+                lvl.unlink(e);
+                id_index_.erase(e);
+            }
+            if (lvl.empty()) {
+                if (side == Side::Buy) bid_levels_.erase(&lvl);
+                else ask_levels_.erase(&lvl);
+            }
+            return RejectReason::DuplicateId;
+        }
+        QueueEntry* e = id_index_.emplace(r.id, side, r.qty, r.ts_ns);
+        e->account = r.account;
+        e->tif = r.tif;
+        lvl.push_back(e);
+        stp_.on_open(r.account, side, r.qty);
+    }
+    metrics_.on_level_created(level_count(side) != before);
+    if constexpr (Publisher::enabled) {
+        publisher_.invalidate();
+        publisher_.publish(*this, fifo.back().ts_ns);
+    }
+    return RejectReason::None;
+}
+
+// Unlink a resting order, drop its level if that emptied it, recycle the node.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::remove_resting(QueueEntry* e, int64_t ts_ns)
+{
+    Level* lvl = e->level;
+    stp_.on_open(e->account, e->side, -(e->qty + hidden_qty(*e)));
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderRemoved, *e, lvl->px, e->qty, lvl->position(e), ts_ns);
+    lvl->unlink(e);
+    level_update(e->side, *lvl, ts_ns);
+    metrics_.on_level_destroyed(lvl->empty());
+    if (lvl->empty()) {
+        if (e->side == Side::Buy) bid_levels_.erase(lvl);
+        else ask_levels_.erase(lvl);
+    }
+    erase_order(e);
+}
+
+// Recycle an unlinked resting order and its iceberg / GTD state, if any.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::erase_order(QueueEntry* e)
+{
+    release_ext(e);
+    id_index_.erase(e);
+}
+
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::release_ext(QueueEntry* e)
+{
+    if (!e->ext) return;
+    if (e->tif == TIF::GTD) expiries_.remove(e);
+    if (is_iceberg(*e)) --icebergs_;
+    ext_.destroy(e->ext);
+    e->ext = nullptr;
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::advance_time(int64_t ts_ns)
+{
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+    return expiries_.advance(ts_ns, [&](QueueEntry* e) {
+        Event ev;
+        ev.type  = EventType::Expire;
+        ev.id    = e->id;
+        ev.side  = e->side;
+        ev.px    = e->level->px;
+        ev.qty   = e->qty + hidden_qty(*e);
+        ev.ts_ns = ts_ns;
+        sink_.push(ev);
+        remove_resting(e, ts_ns);
+    });
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::cancel_day(int64_t ts_ns)
+{
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Cancel);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+    drop_day<Side::Buy>(ts_ns);
+    drop_day<Side::Sell>(ts_ns);
+    return flush_dropped();
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::cancel_side(Side side, int64_t ts_ns)
+{
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Cancel);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+    if (side == Side::Buy) drop_levels<Side::Buy>(0, true, ts_ns);
+    else drop_levels<Side::Sell>(0, true, ts_ns);
+    return flush_dropped();
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::cancel_beyond(Side side, int64_t px, int64_t ts_ns)
+{
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Cancel);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+    if (side == Side::Buy) drop_levels<Side::Buy>(px, false, ts_ns);
+    else drop_levels<Side::Sell>(px, false, ts_ns);
+    return flush_dropped();
+}
+
+// Every level at px or worse (all of them if `all`) goes: its orders are
+// reported and recycled in queue order, the level is reported gone, and the
+// ladder drops the lot in one call. Nothing is unlinked one by one.
+template <template <Side> class Ladder, class P>
+template <Side S>
+size_t BasicOrderBook<Ladder, P>::drop_levels(int64_t px, bool all, int64_t ts_ns)
+{
+    auto& side = levels<S>();
+    size_t dropped = 0;
+    side.for_each([&](Level& lvl) {
+        if (!all && (S == Side::Buy ? lvl.px > px : lvl.px < px)) return true;
+        for (QueueEntry* e = lvl.head; e; e = e->next) {
+            drop_order(*e, lvl.px, 0, ts_ns);
+            e->level = nullptr;
+        }
+        level_update(S, Level{lvl.px}, ts_ns);
+        metrics_.on_level_destroyed(true);
+        ++dropped;
+        return true;
+    });
+    if (all) side.clear();
+    else if (dropped) side.erase_from(px);
+    return dropped;
+}
+
+// Day orders are spread through every level, so each one is unlinked, but a
+// level is reported once and the index is still swept in bulk.
+template <template <Side> class Ladder, class P>
+template <Side S>
+void BasicOrderBook<Ladder, P>::drop_day(int64_t ts_ns)
+{
+    auto& side = levels<S>();
+    side.for_each([&](Level& lvl) {
+        size_t pos = 0;
+        bool touched = false;
+        for (QueueEntry* e = lvl.head; e;) {
+            QueueEntry* next = e->next;
+            if (e->tif == TIF::Day) {
+                drop_order(*e, lvl.px, pos, ts_ns);
+                lvl.unlink(e);
+                touched = true;
+            } else {
+                ++pos;
+            }
+            e = next;
+        }
+        if (touched) {
+            level_update(S, lvl, ts_ns);
+            if (lvl.empty()) emptied_.push_back(&lvl);
+        }
+        return true;
+    });
+    for (Level* lvl : emptied_) {
+        metrics_.on_level_destroyed(true);
+        side.erase(lvl);
+    }
+    emptied_.clear();
+}
+
+// One order of a bulk cancel: events, tallies and side state. The caller
+// unlinks it (or drops its whole level); flush_dropped() frees the node.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::drop_order(QueueEntry& e, int64_t px, size_t pos, int64_t ts_ns)
+{
+    Event ev;
+    ev.type  = EventType::Cancel;
+    ev.id    = e.id;
+    ev.side  = e.side;
+    ev.px    = px;
+    ev.qty   = e.qty + hidden_qty(e);
+    ev.ts_ns = ts_ns;
+    sink_.push(ev);
+    stp_.on_open(e.account, e.side, -ev.qty);
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderRemoved, e, px, e.qty, pos, ts_ns);
+    metrics_.on_cancel();
+    release_ext(&e);
+    dropped_.push_back(&e);
+}
+
+template <template <Side> class Ladder, class P>
+size_t BasicOrderBook<Ladder, P>::flush_dropped()
+{
+    const size_t n = dropped_.size();
+    id_index_.erase(std::span<QueueEntry* const>(dropped_));
+    dropped_.clear();
+    return n;
+}
+
+// An iceberg's shown slice just filled: show the next one from the same node
+// and send it to the back of the queue. No allocation, no index change.
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::replenish(Level& lvl, QueueEntry& e, int64_t ts_ns)
+{
+    OrderExt& x = *e.ext;
+    const int64_t show = std::min(x.peak, x.hidden);
+    x.hidden -= show;
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderRemoved, e, lvl.px, 0, lvl.position(&e), ts_ns);
+    lvl.resize(&e, show);
+    e.ts_ns = ts_ns;
+    lvl.move_to_back(&e);
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderAdded, e, lvl.px, show, lvl.count() - 1, ts_ns);
+}
+
+template <template <Side> class Ladder, class P>
+template <Side S>
+std::vector<LevelView> BasicOrderBook<Ladder, P>::depth_view(int depth) const
+{
+    std::vector<LevelView> out;
+    if (depth <= 0) return out;
+    out.reserve(depth);
+    levels<S>().for_each([&](const Level& lvl) {
+        out.push_back(LevelView{lvl.px, lvl.total_qty(), lvl.count()});
+        return static_cast<int>(out.size()) < depth;
+    });
+    return out;
+}
+
+template <template <Side> class Ladder, class P>
+FillEstimate BasicOrderBook<Ladder, P>::fill_estimate(Side side, int64_t qty) const
+{
+    FillEstimate f;
+    if (qty <= 0) return f;
+    for_each_level(opposite(side), [&](const Level& lvl) {
+        const int64_t take = std::min(qty - f.qty, lvl.total_qty());
+        f.qty += take;
+        f.notional += static_cast<double>(lvl.px) * static_cast<double>(take);
+        f.worst_px = lvl.px;
+        ++f.levels;
+        return f.qty < qty;
+    });
+    return f;
+}
+
+template <template <Side> class Ladder, class P>
+int64_t BasicOrderBook<Ladder, P>::qty_up_to(Side side, int64_t px) const
+{
+    int64_t qty = 0;
+    for_each_level(opposite(side), [&](const Level& lvl) {
+        if (side == Side::Buy ? lvl.px > px : lvl.px < px) return false;
+        qty += lvl.total_qty();
+        return true;
+    });
+    return qty;
+}
+
+template <template <Side> class Ladder, class P>
+int64_t BasicOrderBook<Ladder, P>::px_to_fill(Side side, int64_t qty) const
+{
+    const FillEstimate f = fill_estimate(side, qty);
+    return f.qty == qty ? f.worst_px : 0;
+}
+
+template <template <Side> class Ladder, class P>
+DepthCurve BasicOrderBook<Ladder, P>::depth_curve(Side side, size_t max_levels) const
+{
+    DepthCurve c(side);
+    if (max_levels == 0) return c;
+    c.reserve(std::min(max_levels, level_count(opposite(side))));
+    for_each_level(opposite(side), [&](const Level& lvl) {
+        c.push(lvl.px, lvl.total_qty());
+        return c.levels() < max_levels;
+    });
+    return c;
+}
+
+// Gathers the crossed region of both sides and hands it to equilibrium().
+template <template <Side> class Ladder, class P>
+AuctionResult BasicOrderBook<Ladder, P>::auction_price() const
+{
+    const Level* bid = bid_levels_.best();
+    const Level* ask = ask_levels_.best();
+    if (!bid || !ask || bid->px < ask->px) return {};
+
+    std::vector<AuctionLevel> bids, asks;
+    bid_levels_.for_each([&](const Level& lvl) {
+        if (lvl.px < ask->px) return false;
+        bids.push_back({lvl.px, lvl.total_qty()});
+        return true;
+    });
+    ask_levels_.for_each([&](const Level& lvl) {
+        if (lvl.px > bid->px) return false;
+        asks.push_back({lvl.px, lvl.total_qty()});
+        return true;
+    });
+    return equilibrium(bids, asks, last_px_);
+}
+
+// Executes the uncross: best bid front against best ask front, price then
+// time priority on both sides, until the auction volume is done. Each fill
+// is a Trade at the uncross price with the buy order as id and the sell
+// order as maker_id (side = Buy); a LevelUpdate follows per level touched.
+// Self-trade prevention does not apply to the uncross.
+template <template <Side> class Ladder, class P>
+AuctionResult BasicOrderBook<Ladder, P>::uncross(int64_t ts_ns)
+{
+    [[maybe_unused]] const auto timer = metrics_.time(BookOp::Match);
+    [[maybe_unused]] const auto publish = publish_on_exit(ts_ns);
+    const AuctionResult r = auction_price();
+    auction_ = false;
+
+    Level* touched[2]{};
+    for (int64_t left = r.qty; left > 0;) {
+        Level& b = *bid_levels_.best();
+        Level& a = *ask_levels_.best();
+        QueueEntry& buy = *b.front();
+        QueueEntry& sell = *a.front();
+        const int64_t exec = std::min({left, buy.qty, sell.qty});
+
+        Event tr;
+        tr.type     = EventType::Trade;
+        tr.id       = buy.id;
+        tr.maker_id = sell.id;
+        tr.px       = r.px;
+        tr.qty      = exec;
+        tr.ts_ns    = ts_ns;
+        tr.side     = Side::Buy;
+        sink_.push(tr);
+        metrics_.on_fill(exec);
+        stp_.on_open(buy.account, Side::Buy, -exec);
+        stp_.on_fill(buy.account, sell.account, Side::Buy, exec);
+        left -= exec;
+
+        touched[0] = auction_take<Side::Buy>(b, buy, exec, ts_ns) ? nullptr : &b;
+        touched[1] = auction_take<Side::Sell>(a, sell, exec, ts_ns) ? nullptr : &a;
+    }
+    if (touched[0]) level_update(Side::Buy, *touched[0], ts_ns);
+    if (touched[1]) level_update(Side::Sell, *touched[1], ts_ns);
+
+    if (r.qty) last_px_ = r.px;
+    if (stops_.size()) trigger_stops(ts_ns);
+    return r;
+}
+
+// One side of an uncross fill on the front order of lvl. Returns true if
+// that emptied the level, which is then reported and erased.
+template <template <Side> class Ladder, class P>
+template <Side S>
+bool BasicOrderBook<Ladder, P>::auction_take(Level& lvl, QueueEntry& e, int64_t qty, int64_t ts_ns)
+{
+    lvl.reduce(&e, qty);
+    if (e.qty > 0) {
+        if constexpr (Sink::order_events)
+            order_event(EventType::OrderReduced, e, lvl.px, e.qty, 0, ts_ns);
+        return false;
+    }
+    if (is_iceberg(e) && e.ext->hidden > 0) [[unlikely]] {
+        replenish(lvl, e, ts_ns);
+        return false;
+    }
+    if constexpr (Sink::order_events)
+        order_event(EventType::OrderRemoved, e, lvl.px, 0, 0, ts_ns);
+    lvl.unlink(&e);
+    erase_order(&e);
+    if (!lvl.empty()) return false;
+    level_update(S, lvl, ts_ns);
+    metrics_.on_level_destroyed(true);
+    levels<S>().erase(&lvl);
+    return true;
+}
+
+template <template <Side> class Ladder, class P>
+MemoryStats BasicOrderBook<Ladder, P>::memory_stats() const
+{
+    MemoryStats s;
+    s.orders     = id_index_.node_stats();
+    s.index      = id_index_.index_stats();
+    s.bid_levels = bid_levels_.pool_stats();
+    s.ask_levels = ask_levels_.pool_stats();
+    s.events     = sink_.stats();
+    s.stops      = stops_.node_stats();
+    return s;
+}
+
+template <template <Side> class Ladder, class P>
+std::vector<Trade> BasicOrderBook<Ladder, P>::pop_trade()
+{
+    std::vector<Trade> out;
+    sink_.ring().drain([&](const Event& e) {
+        if (e.type == EventType::Trade)
+            out.push_back(Trade{e.id, e.maker_id, e.px, e.qty, e.ts_ns, e.side == Side::Buy});
+    });
+    return out;
+}
+
+template <template <Side> class Ladder, class P>
+bool BasicOrderBook<Ladder, P>::reject(uint64_t id, RejectReason why, int64_t ts_ns)
+{
+    Event ev;
+    ev.type   = EventType::Reject;
+    ev.id     = id;
+    ev.reason = why;
+    ev.ts_ns  = ts_ns;
+    sink_.push(ev);
+    metrics_.on_reject(why);
+    last_reject_ = why;
+    return false;
+}
+
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::accept(const Order& o)
+{
+    Event ev;
+    ev.type  = EventType::Accept;
+    ev.id    = o.id;
+    ev.side  = o.side;
+    ev.px    = o.px;
+    ev.qty   = o.qty;
+    ev.ts_ns = o.ts_ns;
+    sink_.push(ev);
+    metrics_.on_accept();
+}
+
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::level_update(Side side, const Level& lvl, int64_t ts_ns)
+{
+    Event ev;
+    ev.type   = EventType::LevelUpdate;
+    ev.side   = side;
+    ev.px     = lvl.px;
+    ev.qty    = lvl.total_qty();
+    ev.orders = static_cast<uint32_t>(lvl.count());
+    ev.ts_ns  = ts_ns;
+    sink_.push(ev);
+    publisher_.touch(side, lvl.px);
+}
+
+template <template <Side> class Ladder, class P>
+void BasicOrderBook<Ladder, P>::order_event(EventType type, const QueueEntry& e, int64_t px, int64_t qty,
+                                            size_t pos, int64_t ts_ns)
+{
+    Event ev;
+    ev.type   = type;
+    ev.id     = e.id;
+    ev.side   = e.side;
+    ev.px     = px;
+    ev.qty    = qty;
+    ev.orders = static_cast<uint32_t>(pos);
+    ev.ts_ns  = ts_ns;
+    sink_.push(ev);
+}
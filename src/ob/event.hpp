@@ -0,0 +1,130 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "order.hpp"
+#include "util.hpp"
+
+// Book event stream. Every mutation of an OrderBook appends plain-data
+// Events to the book's EventRing; consumers drain it in place. Order of
+// events for one call: Accept/Replace/Cancel (or Reject) first, then any
+// Trades, with a LevelUpdate after each price level that changed. Stops
+// triggered by those trades follow once the call's own matching is done,
+// each as StopTriggered and then the events of the order it became (no
+// second Accept: a stop is accepted once, when it is parked).
+//
+// Books whose sink asks for order events (MboSink, see policies.hpp) also
+// publish a market-by-order feed: every change to a resting order emits an
+// OrderAdded / OrderReduced / OrderRemoved carrying its queue position, just
+// before the LevelUpdate of its level. Together with LevelUpdate that is
+// enough to keep a full L3 mirror of the book without ever polling it.
+
+enum class EventType : uint8_t
+{
+    Accept,         // add() accepted: id, side, px, qty (as submitted)
+    Reject,         // add/cancel/replace refused: id, reason
+    Trade,          // one fill: id = taker, maker_id, px, qty, side = taker side
+    Cancel,         // resting order removed by cancel() or a bulk cancel: id, side, px, qty left
+    Replace,        // replace() accepted: id, side, new px, new qty
+    LevelUpdate,    // L2 delta: side, px, new total qty, orders (0/0 = level gone)
+
+    // Market-by-order (L3), only with an order-event sink. orders = the
+    // order's 0-based queue position at its level when the event happened.
+    OrderAdded,     // joined the back of a level: id, side, px, qty
+    OrderReduced,   // traded or shrunk in place: id, side, px, qty now resting
+    OrderRemoved,   // left the level (filled, cancelled, repriced, grown): id, side, px, qty it still had
+
+    StopTriggered,  // pending stop released by a trade: id, side, px = stop price, qty;
+                    // its Trades, rest or Reject then follow as a market / limit, without an Accept
+    SelfTradePrevented, // AccountStp<StpAction::Decrement> instead of a Trade: id = taker,
+                        // maker_id, px, qty taken off both, side = taker side
+    Expire,         // GTD order removed by advance_time(): id, side, px, qty left
+};
+
+enum class RejectReason : uint8_t
+{
+    None,
+    BadQty,         // qty <= 0
+    BadPrice,       // px <= 0, off the tick grid or beyond what the ladder can hold
+    DuplicateId,    // add() with an id that is already resting or a pending stop
+    UnknownId,      // cancel() of an unknown id, replace() of one that is not resting
+    WouldCross,     // PostOnly that would take liquidity (or is a market order)
+    CannotFill,     // FOK without enough opposite liquidity
+    BadMessage,     // batch message with an unknown kind, or an Add with an unknown side/type/tif
+    Auction,        // market, IOC, FOK or stop order during a call auction
+    BadExpiry,      // GTD whose expire_ns is not after the book's advance_time()
+    BadAccount,     // account id beyond what the Stp policy tracks
+};
+
+struct Event
+{
+    uint64_t id{};
+    uint64_t maker_id{};
+    int64_t px{};
+    int64_t qty{};
+    int64_t ts_ns{};
+    uint32_t orders{};          // LevelUpdate: orders at the level; Order*: queue position
+    EventType type{};
+    RejectReason reason{RejectReason::None};
+    Side side{};
+};
+
+// Single-producer ring of Events, power-of-two capacity. The book pushes,
+// the owner reads in place with drain()/operator[] and then clears, so
+// delivery costs a 48-byte store per event and no allocation. If a consumer
+// falls behind the ring doubles rather than dropping events; the grow count
+// shows up in stats() so capacity can be sized to avoid it.
+class EventRing
+{
+    public:
+        explicit EventRing(size_t capacity = 4096)
+            : buf_(std::bit_ceil(capacity < 16 ? size_t{16} : capacity)), mask_{buf_.size() - 1} {}
+
+        void push(const Event& e)
+        {
+            if (tail_ - head_ == buf_.size()) grow();
+            buf_[tail_++ & mask_] = e;
+            if (tail_ - head_ > high_water_) high_water_ = tail_ - head_;
+        }
+
+        bool empty() const { return head_ == tail_; }
+        size_t size() const { return static_cast<size_t>(tail_ - head_); }
+        size_t capacity() const { return buf_.size(); }
+
+        // i-th oldest pending event.
+        const Event& operator[](size_t i) const { return buf_[(head_ + i) & mask_]; }
+
+        // Visit every pending event oldest-first, then consume them.
+        template <class F>
+        size_t drain(F&& f)
+        {
+            const size_t n = size();
+            for (; head_ != tail_; ++head_) f(buf_[head_ & mask_]);
+            return n;
+        }
+
+        void clear() { head_ = tail_; }
+
+        PoolStats stats() const { return PoolStats{buf_.size(), size(), high_water_, grows_}; }
+
+    private:
+        void grow()
+        {
+            std::vector<Event> next(buf_.size() * 2);
+            const size_t n = size();
+            for (size_t i = 0; i < n; ++i) next[i] = (*this)[i];
+            buf_.swap(next);
+            mask_ = buf_.size() - 1;
+            head_ = 0;
+            tail_ = n;
+            ++grows_;
+        }
+
+        std::vector<Event> buf_;
+        size_t mask_;
+        uint64_t head_{0};
+        uint64_t tail_{0};
+        size_t high_water_{0};
+        size_t grows_{0};
+};
@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "price_level.hpp"
+
+// GTD expiries: a hierarchical timing wheel over resting orders whose
+// OrderExt carries expire_ns. Time is counted in ticks of tick_ns; four
+// levels of 64 slots cover 64^4 ticks ahead of the current one (4.6 hours
+// at the default 1 ms), anything further out waits on a far list that is
+// re-sorted each time the top level wraps. An order sits at the level of
+// the highest 6-bit group in which its expiry tick differs from the current
+// tick, and moves down one or more levels when the wheel reaches its slot,
+// so it is touched at most five times before it fires.
+//
+// advance() jumps straight to the next occupied slot of any level (one bit
+// scan per level), so its cost is the number of orders expired plus the
+// cascades on the way, never the number of ticks elapsed. Orders due within
+// the same tick fire in no particular order, but the same run always fires
+// them in the same order. Insert and remove are O(1): the slot lists are
+// intrusive through OrderExt (wprev / wnext / wslot).
+class ExpiryWheel
+{
+    public:
+        explicit ExpiryWheel(int64_t tick_ns = 1'000'000) : tick_ns_{std::max<int64_t>(tick_ns, 1)} {}
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        // The ts_ns of the last advance(); orders must expire after it.
+        int64_t now_ns() const { return now_ns_; }
+
+        void insert(QueueEntry* e)
+        {
+            assert(e->ext && e->ext->expire_ns > now_ns_);
+            link(e, slot_for(tick_of(e->ext->expire_ns)));
+            ++size_;
+        }
+
+        void remove(QueueEntry* e)
+        {
+            unlink(e);
+            --size_;
+        }
+
+        // Fire every order with expire_ns <= ts_ns: expire(e) is called once
+        // for each and must take it out of the wheel (remove()). Returns how
+        // many fired; a ts_ns not after now_ns() fires nothing.
+        template <class F>
+        size_t advance(int64_t ts_ns, F&& expire)
+        {
+            if (ts_ns <= now_ns_) return 0;
+            now_ns_ = ts_ns;
+            const uint64_t target = tick_of(ts_ns);
+            size_t fired = 0;
+            for (;;) {
+                // Only the target tick can hold orders due later than ts_ns.
+                QueueEntry* e = head_[cur_ & kMask];
+                while (e) {
+                    QueueEntry* next = e->ext->wnext;
+                    if (e->ext->expire_ns <= ts_ns) {
+                        expire(e);
+                        ++fired;
+                    }
+                    e = next;
+                }
+                if (cur_ >= target) return fired;
+                cur_ = std::min(next_due(), target);
+                cascade();
+            }
+        }
+
+    private:
+        static constexpr int kBits = 6;
+        static constexpr uint64_t kSlots = uint64_t{1} << kBits;
+        static constexpr uint64_t kMask = kSlots - 1;
+        static constexpr int kLevels = 4;
+        static constexpr uint32_t kFar = kLevels * kSlots;     // slot index of the far list
+
+        uint64_t tick_of(int64_t ns) const { return ns <= 0 ? 0 : static_cast<uint64_t>(ns / tick_ns_); }
+
+        uint32_t slot_for(uint64_t at) const
+        {
+            at = std::max(at, cur_);
+            const uint64_t diff = at ^ cur_;
+            const int level = diff ? (63 - std::countl_zero(diff)) / kBits : 0;
+            if (level >= kLevels) return kFar;
+            return static_cast<uint32_t>(level * kSlots + ((at >> (level * kBits)) & kMask));
+        }
+
+        void link(QueueEntry* e, uint32_t slot)
+        {
+            OrderExt& x = *e->ext;
+            x.wslot = slot;
+            x.wprev = nullptr;
+            x.wnext = head_[slot];
+            if (x.wnext) x.wnext->ext->wprev = e;
+            head_[slot] = e;
+            if (slot != kFar) occ_[slot / kSlots] |= uint64_t{1} << (slot & kMask);
+        }
+
+        void unlink(QueueEntry* e)
+        {
+            OrderExt& x = *e->ext;
+            if (x.wprev) x.wprev->ext->wnext = x.wnext;
+            else head_[x.wslot] = x.wnext;
+            if (x.wnext) x.wnext->ext->wprev = x.wprev;
+            if (!head_[x.wslot] && x.wslot != kFar) occ_[x.wslot / kSlots] &= ~(uint64_t{1} << (x.wslot & kMask));
+            x.wprev = x.wnext = nullptr;
+        }
+
+        // First tick after cur_ at which a slot comes due or the far list
+        // must be re-sorted.
+        uint64_t next_due() const
+        {
+            uint64_t due = std::numeric_limits<uint64_t>::max();
+            for (int l = 0; l < kLevels; ++l) {
+                const int shift = l * kBits;
+                const uint64_t idx = (cur_ >> shift) & kMask;
+                const uint64_t later = idx == kMask ? 0 : occ_[l] & (~uint64_t{0} << (idx + 1));
+                if (!later) continue;
+                const uint64_t base = (cur_ >> (shift + kBits)) << (shift + kBits);
+                due = std::min(due, base | (static_cast<uint64_t>(std::countr_zero(later)) << shift));
+            }
+            if (head_[kFar]) {
+                constexpr int span = kLevels * kBits;
+                due = std::min(due, ((cur_ >> span) + 1) << span);
+            }
+            return due;
+        }
+
+        // cur_ just reached a slot boundary: spread the slots that start here
+        // over the levels below, highest first.
+        void cascade()
+        {
+            if ((cur_ & ((uint64_t{1} << (kLevels * kBits)) - 1)) == 0) respread(kFar);
+            for (int l = kLevels - 1; l > 0; --l) {
+                const int shift = l * kBits;
+                if (cur_ & ((uint64_t{1} << shift) - 1)) continue;
+                respread(static_cast<uint32_t>(l * kSlots + ((cur_ >> shift) & kMask)));
+            }
+        }
+
+        void respread(uint32_t slot)
+        {
+            QueueEntry* e = head_[slot];
+            if (!e) return;
+            head_[slot] = nullptr;
+            if (slot != kFar) occ_[slot / kSlots] &= ~(uint64_t{1} << (slot & kMask));
+            while (e) {
+                QueueEntry* next = e->ext->wnext;
+                link(e, slot_for(tick_of(e->ext->expire_ns)));
+                e = next;
+            }
+        }
+
+        int64_t tick_ns_;
+        int64_t now_ns_{0};
+        uint64_t cur_{0};                           // current tick; earlier slots are empty
+        std::array<QueueEntry*, kFar + 1> head_{};
+        std::array<uint64_t, kLevels> occ_{};       // occupied slots per level
+        size_t size_{0};
+};
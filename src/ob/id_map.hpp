@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "price_level.hpp"
+#include "util.hpp"
+
+// Order id -> resting QueueEntry. The map also owns the nodes: they come
+// from a per-book ObjectPool, so a cancel is one probe plus an O(1) unlink
+// from the level. The index is an open-addressing table (linear probing,
+// backward-shift delete) sized up front, so inserts do not allocate until
+// the book outgrows the configured capacity.
+class IdMap
+{
+    public:
+        explicit IdMap(size_t reserve_orders = 4096)
+            : nodes_{reserve_orders}
+        {
+            size_t cap = 16;
+            while (cap < 2 * reserve_orders) cap *= 2;
+            slots_.assign(cap, Slot{});
+            mask_ = cap - 1;
+        }
+
+        QueueEntry* find(uint64_t id) const
+        {
+            for (size_t i = home(id);; i = (i + 1) & mask_) {
+                const Slot& s = slots_[i];
+                if (!s.node) return nullptr;
+                if (s.id == id) return s.node;
+            }
+        }
+
+        bool contains(uint64_t id) const { return find(id) != nullptr; }
+
+        // Allocate a node for a new resting order. Caller links it into a Level.
+        QueueEntry* emplace(uint64_t id, Side side, int64_t qty, int64_t ts_ns)
+        {
+            if (2 * (size_ + 1) > slots_.size()) rehash(slots_.size() * 2);
+
+            QueueEntry* e = nodes_.create();
+            e->id = id;
+            e->side = side;
+            e->qty = qty;
+            e->ts_ns = ts_ns;
+
+            size_t i = home(id);
+            while (slots_[i].node) i = (i + 1) & mask_;
+            slots_[i] = Slot{id, e};
+            if (++size_ > high_water_) high_water_ = size_;
+            return e;
+        }
+
+        // Drop the id and recycle the node (must already be unlinked).
+        void erase(QueueEntry* e)
+        {
+            size_t i = home(e->id);
+            while (slots_[i].node != e) i = (i + 1) & mask_;
+
+            // Backward-shift: pull later members of the probe run into the hole.
+            for (size_t j = (i + 1) & mask_; slots_[j].node; j = (j + 1) & mask_) {
+                const size_t h = home(slots_[j].id);
+                if (((j - h) & mask_) >= ((j - i) & mask_)) {
+                    slots_[i] = slots_[j];
+                    i = j;
+                }
+            }
+            slots_[i] = Slot{};
+            --size_;
+            nodes_.destroy(e);
+        }
+
+        // Drop many ids at once, e.g. every order of a side at session end.
+        // The nodes must already be unlinked (level == nullptr), and every
+        // other node in the map linked. A few are erased one by one; past an
+        // eighth of the map it is cheaper to sweep the table once, freeing
+        // the dead slots, and then re-seat the survivors in probe order.
+        void erase(std::span<QueueEntry* const> dead)
+        {
+            if (dead.size() * 8 < size_) {
+                for (QueueEntry* e : dead) erase(e);
+                return;
+            }
+            // Nodes are scattered: prefetch a few slots ahead so the misses overlap.
+            constexpr size_t kAhead = 16;
+            for (size_t i = 0; i < slots_.size(); ++i) {
+                if (i + kAhead < slots_.size() && slots_[i + kAhead].node) __builtin_prefetch(slots_[i + kAhead].node, 1);
+                Slot& s = slots_[i];
+                if (!s.node || s.node->level) continue;
+                nodes_.destroy(s.node);
+                s = Slot{};
+                --size_;
+            }
+            // Start just past an empty slot so no probe run wraps unseen;
+            // each survivor can only move back towards its home.
+            size_t z = 0;
+            while (slots_[z].node) ++z;
+            for (size_t k = 1; k <= mask_; ++k) {
+                const size_t i = (z + k) & mask_;
+                if (!slots_[i].node) continue;
+                const Slot s = slots_[i];
+                slots_[i] = Slot{};
+                size_t j = home(s.id);
+                while (slots_[j].node) j = (j + 1) & mask_;
+                slots_[j] = s;
+            }
+        }
+
+        size_t size() const { return size_; }
+
+        PoolStats node_stats() const { return nodes_.stats(); }
+        PoolStats index_stats() const { return PoolStats{slots_.size() / 2, size_, high_water_, grows_}; }
+
+    private:
+        struct Slot { uint64_t id{0}; QueueEntry* node{nullptr}; };
+
+        size_t home(uint64_t id) const
+        {
+            return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+        }
+
+        void rehash(size_t cap)
+        {
+            std::vector<Slot> old(cap, Slot{});
+            old.swap(slots_);
+            mask_ = cap - 1;
+            for (const Slot& s : old) {
+                if (!s.node) continue;
+                size_t i = home(s.id);
+                while (slots_[i].node) i = (i + 1) & mask_;
+                slots_[i] = s;
+            }
+            ++grows_;
+        }
+
+        ObjectPool<QueueEntry> nodes_;
+        std::vector<Slot> slots_;
+        size_t mask_{0};
+        size_t size_{0};
+        size_t high_water_{0};
+        size_t grows_{0};
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "order.hpp"
+
+// Market-impact estimates against the displayed book, without touching it:
+// what a marketable order of a given size would fill, at what prices. Side
+// is always the taker's (a Buy walks the asks). Only displayed quantity
+// counts, the same liquidity can_fully_fill() and bids()/asks() see;
+// iceberg reserves are not visible and not included.
+//
+// One-off questions go to the book directly (fill_estimate, qty_up_to,
+// px_to_fill); each walks the ladder best first and stops as soon as it
+// has the answer. Many questions against the same book state go through a
+// DepthCurve: one walk copies the side into contiguous price / running
+// qty / running notional arrays, after which every query is a binary
+// search over them.
+
+struct FillEstimate
+{
+    int64_t qty{0};             // fillable qty, at most what was asked for
+    double notional{0.0};       // sum of px * qty over the fills
+    int64_t worst_px{0};        // price of the last level touched, 0 = nothing to fill
+    size_t levels{0};           // levels touched, the last one possibly in part
+
+    double vwap() const { return qty ? notional / static_cast<double>(qty) : std::numeric_limits<double>::quiet_NaN(); }
+};
+
+class DepthCurve
+{
+    public:
+        explicit DepthCurve(Side taker = Side::Buy) : taker_{taker} {}
+
+        Side taker() const { return taker_; }
+        size_t levels() const { return px_.size(); }
+        int64_t total_qty() const { return cum_qty_.empty() ? 0 : cum_qty_.back(); }
+
+        void clear() { px_.clear(); cum_qty_.clear(); cum_notional_.clear(); }
+        void reserve(size_t n) { px_.reserve(n); cum_qty_.reserve(n); cum_notional_.reserve(n); }
+
+        // Next level, best first.
+        void push(int64_t px, int64_t qty)
+        {
+            px_.push_back(px);
+            cum_qty_.push_back(total_qty() + qty);
+            cum_notional_.push_back((cum_notional_.empty() ? 0.0 : cum_notional_.back())
+                                    + static_cast<double>(px) * static_cast<double>(qty));
+        }
+
+        // Taking qty: the fill a market order of that size would get.
+        FillEstimate fill(int64_t qty) const
+        {
+            FillEstimate f;
+            if (qty <= 0 || px_.empty()) return f;
+            const size_t k = level_filling(qty);
+            if (k == px_.size()) {
+                f.qty = total_qty();
+                f.notional = cum_notional_.back();
+                f.worst_px = px_.back();
+                f.levels = k;
+                return f;
+            }
+            const int64_t before = k ? cum_qty_[k - 1] : 0;
+            f.qty = qty;
+            f.notional = (k ? cum_notional_[k - 1] : 0.0) + static_cast<double>(px_[k]) * static_cast<double>(qty - before);
+            f.worst_px = px_[k];
+            f.levels = k + 1;
+            return f;
+        }
+
+        // Displayed qty a limit order at px could take.
+        int64_t qty_up_to(int64_t px) const
+        {
+            const auto end = std::partition_point(px_.begin(), px_.end(), [&](int64_t maker) {
+                return taker_ == Side::Buy ? maker <= px : maker >= px;
+            });
+            const auto k = static_cast<size_t>(end - px_.begin());
+            return k ? cum_qty_[k - 1] : 0;
+        }
+
+        // Limit price that fills qty completely; 0 if the side is too thin.
+        int64_t px_to_fill(int64_t qty) const
+        {
+            if (qty <= 0) return 0;
+            const size_t k = level_filling(qty);
+            return k < px_.size() ? px_[k] : 0;
+        }
+
+    private:
+        // First level at which the running qty reaches qty (levels() if never).
+        size_t level_filling(int64_t qty) const
+        {
+            return static_cast<size_t>(std::lower_bound(cum_qty_.begin(), cum_qty_.end(), qty) - cum_qty_.begin());
+        }
+
+        Side taker_;
+        std::vector<int64_t> px_;
+        std::vector<int64_t> cum_qty_;
+        std::vector<double> cum_notional_;
+};
@@ -0,0 +1,325 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "order.hpp"
+#include "price_level.hpp"
+#include "util.hpp"
+
+// Price ladders: the set of non-empty Levels on one side of the book,
+// visited best price first (highest bid / lowest ask). Both ladders expose
+// the same small interface so OrderBook can be instantiated over either:
+//
+//   best()            best Level or nullptr
+//   find(px)          Level at px or nullptr
+//   fits(px)          whether get_or_create(px) stays within the size cap
+//   get_or_create(px) Level at px, created empty if missing; px must fit
+//   erase(lvl)        drop an emptied Level
+//   erase_from(px)    drop the Level at px and every worse one, orders and all
+//   clear()           drop every Level
+//   for_each(f)       best-first walk; f(Level&) returns false to stop
+//
+// erase_from / clear do not touch the orders queued on the dropped Levels:
+// the book recycles those itself before it calls them.
+//   pool_stats()      level storage capacity / high-water mark
+
+struct LadderConfig
+{
+    int64_t base_px{0};     // ArrayLadder: initial window centre (0 = first price seen)
+    size_t ticks{4096};     // ArrayLadder: initial window width in ticks
+    size_t levels{1024};    // MapLadder: tree nodes preallocated per side
+    size_t max_ticks{size_t{1} << 20};  // ArrayLadder: widest the window may grow (40 MiB of Levels)
+};
+
+// Red-black tree ladder. No price band assumptions. Tree nodes come from
+// the ladder's own BlockPool rather than the global heap.
+template <Side S>
+class MapLadder
+{
+    public:
+        using Cmp = std::conditional_t<S == Side::Buy, std::greater<int64_t>, std::less<int64_t>>;
+        using Alloc = PoolAllocator<std::pair<const int64_t, Level>>;
+
+        // Room for the value plus the red-black node header (colour + 3 links).
+        static constexpr size_t kNodeBytes = sizeof(std::pair<const int64_t, Level>) + 4 * sizeof(void*);
+
+        MapLadder(int64_t /*tick*/, const LadderConfig& cfg)
+            : pool_{std::make_unique<BlockPool>(kNodeBytes, cfg.levels, 256)},
+              levels_{Cmp{}, Alloc{pool_.get()}} {}
+
+        bool empty() const { return levels_.empty(); }
+        size_t size() const { return levels_.size(); }
+        static constexpr bool fits(int64_t) { return true; }
+
+        Level* best() { return levels_.empty() ? nullptr : &levels_.begin()->second; }
+        const Level* best() const { return levels_.empty() ? nullptr : &levels_.begin()->second; }
+
+        Level* find(int64_t px)
+        {
+            auto it = levels_.find(px);
+            return it == levels_.end() ? nullptr : &it->second;
+        }
+
+        Level& get_or_create(int64_t px)
+        {
+            return levels_.try_emplace(px, Level{px}).first->second;
+        }
+
+        void erase(Level* lvl) { levels_.erase(lvl->px); }
+
+        // lower_bound under Cmp: the first level that is not better than px.
+        void erase_from(int64_t px) { levels_.erase(levels_.lower_bound(px), levels_.end()); }
+
+        void clear() { levels_.clear(); }
+
+        template <class F>
+        void for_each(F&& f) const
+        {
+            for (const auto& kv : levels_) if (!f(kv.second)) return;
+        }
+
+        template <class F>
+        void for_each(F&& f)
+        {
+            for (auto& kv : levels_) if (!f(kv.second)) return;
+        }
+
+        PoolStats pool_stats() const { return pool_->stats(); }
+
+    private:
+        std::unique_ptr<BlockPool> pool_;   // heap-held so the ladder stays movable
+        std::map<int64_t, Level, Cmp, Alloc> levels_;
+};
+
+// Dense ladder: a contiguous window of Levels indexed by (px - base) / tick,
+// a bitmap of occupied slots, and a cursor on the best slot. Best-price
+// lookup is one load; finding the next level after the best one empties is
+// a word-at-a-time bitmap scan. Prices outside the window trigger a recenter
+// (and a grow if the occupied span no longer fits). The window never grows
+// past max_ticks: fits() refuses a price that would need it to, and the book
+// rejects such orders.
+template <Side S>
+class ArrayLadder
+{
+    public:
+        ArrayLadder(int64_t tick, const LadderConfig& cfg)
+            : tick_{tick}, width_{std::bit_ceil(cfg.ticks < 64 ? size_t{64} : cfg.ticks)},
+              max_width_{std::bit_floor(std::max(cfg.max_ticks, width_))}
+        {
+            slots_.resize(width_);
+            bits_.assign(width_ / 64, 0);
+            if (cfg.base_px > 0) rebase_around(cfg.base_px);
+        }
+
+        bool empty() const { return count_ == 0; }
+        size_t size() const { return count_; }
+
+        Level* best() { return count_ ? &slots_[best_] : nullptr; }
+        const Level* best() const { return count_ ? &slots_[best_] : nullptr; }
+
+        Level* find(int64_t px)
+        {
+            if (!in_window(px)) return nullptr;
+            const size_t i = slot_of(px);
+            return test(i) ? &slots_[i] : nullptr;
+        }
+
+        // The recentered window must be at least twice the occupied span
+        // including px (see recenter()).
+        bool fits(int64_t px) const
+        {
+            if (count_ == 0 || in_window(px)) return true;
+            const int64_t worst_px = slots_[worst()].px;
+            const int64_t lo = std::min({px, slots_[best_].px, worst_px});
+            const int64_t hi = std::max({px, slots_[best_].px, worst_px});
+            return (static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo)) / static_cast<uint64_t>(tick_) < max_width_ / 2;
+        }
+
+        Level& get_or_create(int64_t px)
+        {
+            if (!in_window(px)) recenter(px);
+            const size_t i = slot_of(px);
+            if (!test(i)) {
+                slots_[i] = Level{px};
+                set(i);
+                if (count_++ == 0 || better(i, best_)) best_ = i;
+                if (count_ > high_water_) high_water_ = count_;
+            }
+            return slots_[i];
+        }
+
+        void erase(Level* lvl)
+        {
+            const size_t i = static_cast<size_t>(lvl - slots_.data());
+            clear(i);
+            if (--count_ == 0) return;
+            if (i == best_) best_ = next_from(i);
+        }
+
+        // Clears the occupancy bits of every slot at px or worse, a word at
+        // a time; the best slot survives unless the whole side goes.
+        void erase_from(int64_t px)
+        {
+            if (!count_) return;
+            size_t lo = 0, hi = width_ - 1;
+            if constexpr (S == Side::Buy) {
+                if (px < base_) return;
+                if (in_window(px)) hi = slot_of(px);
+            } else {
+                if (px > base_ && !in_window(px)) return;
+                if (px > base_) lo = static_cast<size_t>((px - base_ + tick_ - 1) / tick_);
+                if (lo >= width_) return;
+            }
+            size_t dropped = 0;
+            for (size_t w = lo >> 6; w <= hi >> 6; ++w) {
+                uint64_t m = ~uint64_t{0};
+                if (w == lo >> 6) m &= ~uint64_t{0} << (lo & 63);
+                if (w == hi >> 6) m &= ~uint64_t{0} >> (63 - (hi & 63));
+                dropped += static_cast<size_t>(std::popcount(bits_[w] & m));
+                bits_[w] &= ~m;
+            }
+            count_ -= dropped;
+        }
+
+        void clear()
+        {
+            std::fill(bits_.begin(), bits_.end(), 0);
+            count_ = 0;
+        }
+
+        template <class F>
+        void for_each(F&& f) const { walk(*this, f); }
+
+        template <class F>
+        void for_each(F&& f) { walk(*this, f); }
+
+        int64_t base_px() const { return base_; }
+        size_t width() const { return width_; }
+
+        PoolStats pool_stats() const { return PoolStats{width_, count_, high_water_, grows_}; }
+
+    private:
+        bool in_window(int64_t px) const
+        {
+            return base_set_ && px >= base_ && (px - base_) / tick_ < static_cast<int64_t>(width_);
+        }
+        size_t slot_of(int64_t px) const { return static_cast<size_t>((px - base_) / tick_); }
+
+        bool test(size_t i) const { return (bits_[i >> 6] >> (i & 63)) & 1u; }
+        void set(size_t i) { bits_[i >> 6] |= uint64_t{1} << (i & 63); }
+        void clear(size_t i) { bits_[i >> 6] &= ~(uint64_t{1} << (i & 63)); }
+
+        // Bids are best at the high end of the window, asks at the low end.
+        static bool better(size_t a, size_t b) { return S == Side::Buy ? a > b : a < b; }
+
+        template <class Self, class F>
+        static void walk(Self& self, F& f)
+        {
+            if (!self.count_) return;
+            size_t i = self.best_;
+            for (size_t seen = 0; seen < self.count_; ++seen) {
+                if (!f(self.slots_[i])) return;
+                if (seen + 1 < self.count_) i = self.next_from(i);
+            }
+        }
+
+        // Worst occupied slot (caller guarantees one exists).
+        size_t worst() const
+        {
+            if constexpr (S == Side::Buy) {
+                size_t w = 0;
+                while (!bits_[w]) ++w;
+                return (w << 6) + static_cast<size_t>(std::countr_zero(bits_[w]));
+            } else {
+                size_t w = bits_.size() - 1;
+                while (!bits_[w]) --w;
+                return (w << 6) + 63 - static_cast<size_t>(std::countl_zero(bits_[w]));
+            }
+        }
+
+        // Next occupied slot strictly worse than i (caller guarantees one exists).
+        size_t next_from(size_t i) const
+        {
+            if constexpr (S == Side::Buy) {
+                size_t w = i >> 6;
+                uint64_t word = (i & 63) ? bits_[w] & ((uint64_t{1} << (i & 63)) - 1) : 0;
+                while (!word) word = bits_[--w];
+                return (w << 6) + 63 - static_cast<size_t>(std::countl_zero(word));
+            } else {
+                size_t w = i >> 6;
+                uint64_t word = (i & 63) == 63 ? 0 : bits_[w] & (~uint64_t{0} << ((i & 63) + 1));
+                while (!word) word = bits_[++w];
+                return (w << 6) + static_cast<size_t>(std::countr_zero(word));
+            }
+        }
+
+        void rebase_around(int64_t px)
+        {
+            const int64_t half = static_cast<int64_t>(width_ / 2) * tick_;
+            base_ = px - half;
+            base_ -= ((base_ % tick_) + tick_) % tick_;   // keep base on the tick grid
+            base_set_ = true;
+        }
+
+        // Move the window so px fits, growing it if the occupied span plus px
+        // is wider than the current window. Rare; O(width + resting orders).
+        void recenter(int64_t px)
+        {
+            if (count_ == 0) {
+                rebase_around(px);
+                return;
+            }
+
+            int64_t lo = px, hi = px;
+            std::vector<Level> old;
+            old.swap(slots_);
+            for (size_t i = 0; i < width_; ++i) {
+                if (!test(i)) continue;
+                lo = std::min(lo, old[i].px);
+                hi = std::max(hi, old[i].px);
+            }
+
+            const size_t span = static_cast<size_t>((hi - lo) / tick_) + 1;
+            size_t width = width_;
+            while (width < 2 * span) width *= 2;
+            if (width != width_) ++grows_;
+
+            std::vector<uint64_t> old_bits;
+            old_bits.swap(bits_);
+            const size_t old_width = width_;
+
+            width_ = width;
+            slots_.assign(width_, Level{});
+            bits_.assign(width_ / 64, 0);
+            rebase_around(lo + (hi - lo) / 2);
+
+            size_t n = 0;
+            for (size_t i = 0; i < old_width; ++i) {
+                if (!((old_bits[i >> 6] >> (i & 63)) & 1u)) continue;
+                const size_t j = slot_of(old[i].px);
+                slots_[j] = old[i];
+                for (QueueEntry* e = slots_[j].head; e; e = e->next) e->level = &slots_[j];
+                set(j);
+                if (n++ == 0 || better(j, best_)) best_ = j;
+            }
+        }
+
+        int64_t tick_;
+        size_t width_;
+        size_t max_width_;
+        int64_t base_{0};
+        bool base_set_{false};
+        std::vector<Level> slots_;
+        std::vector<uint64_t> bits_;
+        size_t best_{0};
+        size_t count_{0};
+        size_t high_water_{0};
+        size_t grows_{0};
+};
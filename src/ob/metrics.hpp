@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "event.hpp"
+#include "timing.hpp"
+
+// Optional book instrumentation, picked by the Metrics slot of Policies.
+//
+//   NoMetrics    default. Every hook is an empty inline function and the
+//                timer an empty object, so an uninstrumented book compiles
+//                to exactly the same code as before.
+//   BookMetrics  counters plus cycle-counter latency histograms for add /
+//                cancel / replace / match. Two cycle_now() reads per timed
+//                call, a handful of increments otherwise.
+//
+// The book calls the hooks; readers take a copy with snapshot() (or
+// BasicOrderBook::metrics()) and convert cycles with cycles_per_ns().
+
+enum class BookOp : uint8_t { Add, Cancel, Replace, Match };
+inline constexpr size_t kBookOps = 4;
+inline constexpr size_t kRejectReasons = static_cast<size_t>(RejectReason::BadAccount) + 1;
+
+struct BookCounters
+{
+    uint64_t adds{0};                       // add() calls, accepted or not
+    uint64_t accepted{0};                   // adds that passed validation
+    uint64_t cancels{0};                    // successful cancel()
+    uint64_t replaces{0};                   // successful replace()
+    uint64_t rejects[kRejectReasons]{};     // by RejectReason (index 0 unused)
+    uint64_t fills{0};                      // trades
+    uint64_t filled_qty{0};
+    uint64_t aggressive{0};                 // matches that touched at least one level
+    uint64_t levels_created{0};
+    uint64_t levels_destroyed{0};
+};
+
+struct MetricsSnapshot
+{
+    BookCounters counters;
+    LatencyHistogram latency[kBookOps];     // cycles, indexed by BookOp; add includes its match
+    LatencyHistogram sweep_depth;           // price levels touched per aggressive match
+};
+
+// Scope timer handed out by BookMetrics::time(); records on destruction.
+class OpTimer
+{
+    public:
+        explicit OpTimer(LatencyHistogram& h) : h_{h}, t0_{cycle_now()} {}
+        OpTimer(const OpTimer&) = delete;
+        OpTimer& operator=(const OpTimer&) = delete;
+        ~OpTimer() { h_.record(cycle_now() - t0_); }
+
+    private:
+        LatencyHistogram& h_;
+        uint64_t t0_;
+};
+
+struct NoMetrics
+{
+    struct Timer {};
+    static constexpr bool enabled = false;
+
+    Timer time(BookOp) { return {}; }
+    void on_add() {}
+    void on_accept() {}
+    void on_cancel() {}
+    void on_replace() {}
+    void on_reject(RejectReason) {}
+    void on_fill(int64_t) {}
+    void on_sweep(size_t) {}
+    void on_level_created(bool) {}
+    void on_level_destroyed(bool) {}
+};
+
+class BookMetrics
+{
+    public:
+        using Timer = OpTimer;
+        static constexpr bool enabled = true;
+
+        OpTimer time(BookOp op) { return OpTimer{s_.latency[static_cast<size_t>(op)]}; }
+        void on_add() { ++s_.counters.adds; }
+        void on_accept() { ++s_.counters.accepted; }
+        void on_cancel() { ++s_.counters.cancels; }
+        void on_replace() { ++s_.counters.replaces; }
+        void on_reject(RejectReason why) { ++s_.counters.rejects[static_cast<size_t>(why)]; }
+        void on_fill(int64_t qty)
+        {
+            ++s_.counters.fills;
+            s_.counters.filled_qty += static_cast<uint64_t>(qty);
+        }
+        void on_sweep(size_t levels)
+        {
+            if (!levels) return;
+            ++s_.counters.aggressive;
+            s_.sweep_depth.record(levels);
+        }
+        void on_level_created(bool created) { s_.counters.levels_created += created; }
+        void on_level_destroyed(bool destroyed) { s_.counters.levels_destroyed += destroyed; }
+
+        const MetricsSnapshot& snapshot() const { return s_; }
+        void reset() { s_ = MetricsSnapshot{}; }
+
+    private:
+        MetricsSnapshot s_;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include "order.hpp"
+
+// Flat, tagged order message for batch entry points (apply_batch, the
+// NumPy binding, journals). Fixed 40-byte little-endian layout with only
+// integer fields so it maps 1:1 onto a NumPy structured dtype.
+
+enum class MsgKind : uint8_t { Add, Cancel, Replace };
+
+struct OrderMsg
+{
+    uint64_t id{};
+    int64_t px{};        // Add: limit price; Replace: new price
+    int64_t qty{};       // Add: qty; Replace: new qty
+    int64_t ts_ns{};
+    uint8_t kind{};      // MsgKind
+    uint8_t side{};      // Side (Add)
+    uint8_t type{};      // Type (Add)
+    uint8_t tif{};       // TIF (Add)
+    uint32_t account{};  // Order::account (Add); was zero padding, so older journals read as 0
+};
+
+static_assert(sizeof(OrderMsg) == 40, "OrderMsg layout is part of the batch/NumPy ABI");
+
+// True if side/type/tif each name an enumerator. The raw bytes come from
+// NumPy arrays and files, so apply_batch checks this before to_order().
+inline bool valid_add(const OrderMsg& m)
+{
+    return m.side <= static_cast<uint8_t>(Side::Sell)
+        && m.type <= static_cast<uint8_t>(Type::StopLimit)
+        && m.tif  <= static_cast<uint8_t>(TIF::GTD);
+}
+
+inline Order to_order(const OrderMsg& m)
+{
+    Order o;
+    o.id    = m.id;
+    o.side  = static_cast<Side>(m.side);
+    o.type  = static_cast<Type>(m.type);
+    o.tif   = static_cast<TIF>(m.tif);
+    o.px    = m.px;
+    o.qty   = m.qty;
+    o.ts_ns = m.ts_ns;
+    o.account = m.account;
+    return o;
+}
+
+inline OrderMsg add_msg(const Order& o)
+{
+    OrderMsg m;
+    m.kind  = static_cast<uint8_t>(MsgKind::Add);
+    m.id    = o.id;
+    m.side  = static_cast<uint8_t>(o.side);
+    m.type  = static_cast<uint8_t>(o.type);
+    m.tif   = static_cast<uint8_t>(o.tif);
+    m.px    = o.px;
+    m.qty   = o.qty;
+    m.ts_ns = o.ts_ns;
+    m.account = o.account;
+    return m;
+}
+
+inline OrderMsg cancel_msg(uint64_t id, int64_t ts_ns)
+{
+    OrderMsg m;
+    m.kind  = static_cast<uint8_t>(MsgKind::Cancel);
+    m.id    = id;
+    m.ts_ns = ts_ns;
+    return m;
+}
+
+inline OrderMsg replace_msg(uint64_t id, int64_t px, int64_t qty, int64_t ts_ns)
+{
+    OrderMsg m;
+    m.kind  = static_cast<uint8_t>(MsgKind::Replace);
+    m.id    = id;
+    m.px    = px;
+    m.qty   = qty;
+    m.ts_ns = ts_ns;
+    return m;
+}
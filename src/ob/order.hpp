@@ -2,9 +2,11 @@
 #include <cstdint>
 
 
-enum class Side{Buy, Sell};
-enum class Type{Limit, Market};
-enum class TIF{Day, IOC, FOK, GTC, PostOnly};
+enum class Side : uint8_t {Buy, Sell};
+enum class Type{Limit, Market, Stop, StopLimit};
+enum class TIF : uint8_t {Day, IOC, FOK, GTC, PostOnly, GTD};
+
+constexpr Side opposite(Side s) { return s == Side::Buy ? Side::Sell : Side::Buy; }
 
 
 struct Order 
@@ -17,6 +19,10 @@ struct Order
     int64_t qty{};
     int64_t ts_ns{};
     bool post_only{false};
+    int64_t stop_px{};          // Stop / StopLimit: trigger on last trade at or through this price
+    int64_t display_qty{};      // Limit: iceberg peak shown at a time (0 = show everything)
+    uint32_t account{};         // owner for self-trade prevention / tallies (0 = none)
+    int64_t expire_ns{};        // GTD: rests until advance_time() reaches this
 };
 
 struct Trade 
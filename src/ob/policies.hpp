@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "event.hpp"
+#include "metrics.hpp"
+#include "order.hpp"
+#include "price_level.hpp"
+#include "stp.hpp"
+#include "top_of_book.hpp"
+
+// Compile-time building blocks for BasicOrderBook.
+//
+//   SideTraits<S>      everything that differs between Buy and Sell, so the
+//                      matching code is written once and instantiated twice
+//   Sink               where events go (RingSink, NullSink)
+//   Stp                self-trade prevention and account tallies, NoStp or
+//                      AccountStp<A> (stp.hpp)
+//   Validation         which input checks add()/replace() perform
+//   Metrics            instrumentation, NoMetrics or BookMetrics (metrics.hpp)
+//   Publisher          cross-thread top-N quotes, NoPublisher or TopOfBook<N>
+//                      (top_of_book.hpp)
+//
+// Policies<Sink, Stp, Validation, Metrics, Publisher> bundles all but the
+// first for the book.
+
+template <Side S> struct SideTraits;
+
+template <>
+struct SideTraits<Side::Buy>
+{
+    static constexpr Side side = Side::Buy;
+    static constexpr Side opposite = Side::Sell;
+    // A buy at px trades with an ask at maker_px.
+    static constexpr bool crosses(int64_t px, int64_t maker_px) { return px >= maker_px; }
+};
+
+template <>
+struct SideTraits<Side::Sell>
+{
+    static constexpr Side side = Side::Sell;
+    static constexpr Side opposite = Side::Buy;
+    static constexpr bool crosses(int64_t px, int64_t maker_px) { return px <= maker_px; }
+};
+
+// ---- event sinks ----
+// A sink must provide push(const Event&), ring() and stats(). ring() is what
+// BasicOrderBook::events() returns. order_events = true makes the book also
+// emit the market-by-order events (event.hpp); otherwise that code is
+// compiled out.
+
+// Default: every event lands in the book's EventRing.
+class RingSink
+{
+    public:
+        static constexpr bool order_events = false;
+
+        explicit RingSink(size_t capacity) : ring_{capacity} {}
+
+        void push(const Event& e) { ring_.push(e); }
+        EventRing& ring() { return ring_; }
+        const EventRing& ring() const { return ring_; }
+        PoolStats stats() const { return ring_.stats(); }
+
+    private:
+        EventRing ring_;
+};
+
+// Discards everything; events() stays empty. For runs that only care about
+// final book state, where building events is pure overhead.
+class NullSink
+{
+    public:
+        static constexpr bool order_events = false;
+
+        explicit NullSink(size_t) : ring_{16} {}
+
+        void push(const Event&) {}
+        EventRing& ring() { return ring_; }
+        const EventRing& ring() const { return ring_; }
+        PoolStats stats() const { return ring_.stats(); }
+
+    private:
+        EventRing ring_;
+};
+
+// RingSink plus the L3 feed: OrderAdded / OrderReduced / OrderRemoved with
+// queue positions. Costs an extra event per order change, and a queue walk
+// (to the nearer end) for cancels and in-place replaces.
+class MboSink : public RingSink
+{
+    public:
+        static constexpr bool order_events = true;
+        using RingSink::RingSink;
+};
+
+// ---- validation ----
+
+// Every check; rejects carry a RejectReason.
+struct FullValidation
+{
+    static constexpr bool qty = true;           // qty > 0
+    static constexpr bool price = true;         // limit px > 0 and on the tick grid
+    static constexpr bool duplicate_id = true;  // id not already resting
+};
+
+// No checks. Only for input already known to be valid, e.g. a generator or
+// a feed that was validated upstream; anything else corrupts the book.
+struct TrustedInput
+{
+    static constexpr bool qty = false;
+    static constexpr bool price = false;
+    static constexpr bool duplicate_id = false;
+};
+
+template <class SinkT = RingSink, class StpT = NoStp, class ValidationT = FullValidation,
+          class MetricsT = NoMetrics, class PublisherT = NoPublisher>
+struct Policies
+{
+    using Sink = SinkT;
+    using Stp = StpT;
+    using Validation = ValidationT;
+    using Metrics = MetricsT;
+    using Publisher = PublisherT;
+};
+
+using DefaultPolicies = Policies<>;
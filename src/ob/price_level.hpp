@@ -1,36 +1,118 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include "order.hpp"
 
+struct Level;
+struct QueueEntry;
 
-struct QueueEntry 
+// State for the order kinds that need more than id / qty / time. Allocated
+// from the book's pool only for those orders (icebergs, pending stops, GTD);
+// plain orders carry nullptr.
+struct OrderExt
+{
+    int64_t peak{0};        // iceberg: displayed slice size (0 = not an iceberg)
+    int64_t hidden{0};      // iceberg: quantity not yet displayed
+    int64_t px{0};          // pending stop: limit price once triggered (StopLimit)
+    Type type{};            // pending stop: Stop or StopLimit
+    TIF tif{};
+    int64_t expire_ns{0};   // GTD: expiry time; the order is linked into the book's ExpiryWheel
+    QueueEntry* wprev{nullptr};
+    QueueEntry* wnext{nullptr};
+    uint32_t wslot{0};      // wheel slot the order is linked into
+};
+
+// One resting order. Nodes live in the IdMap pool and are linked
+// intrusively into their Level, so unlinking never searches the queue.
+struct QueueEntry
 {
     uint64_t id;
     int64_t qty;
     int64_t ts_ns;
+    Side side{};
+    TIF tif{TIF::Day};          // lifetime once resting: Day, GTC or GTD
+    uint32_t account{0};        // Order::account; side, tif and account share one word
+    QueueEntry* prev{nullptr};
+    QueueEntry* next{nullptr};
+    Level* level{nullptr};
+    OrderExt* ext{nullptr};     // iceberg / pending stop state, see OrderExt
 };
 
+static_assert(sizeof(QueueEntry) == 64, "QueueEntry is one cache line; new fields must fit the padding");
+
 //One price level in book (FIFO queue of orders at that price)
+//qty / n are running aggregates: every change to a linked entry's qty must
+//go through push_back / unlink / reduce / resize so they stay exact.
 
-struct Level 
+struct Level
 {
     int64_t px{0};
-    std::deque<QueueEntry> q;
+    QueueEntry* head{nullptr};
+    QueueEntry* tail{nullptr};
+    size_t n{0};
+    int64_t qty{0};
 
     Level() = default;
     explicit Level(int64_t p): px(p) {}
 
-    void enqueue(uint64_t id, int64_t qty, int64_t ts_ns)
+    bool empty() const { return head == nullptr; }
+    QueueEntry* front() const { return head; }
+
+    void push_back(QueueEntry* e)
+    {
+        e->level = this;
+        e->next = nullptr;
+        e->prev = tail;
+        if (tail) tail->next = e; else head = e;
+        tail = e;
+        ++n;
+        qty += e->qty;
+    }
+
+    void unlink(QueueEntry* e)
+    {
+        if (e->prev) e->prev->next = e->next; else head = e->next;
+        if (e->next) e->next->prev = e->prev; else tail = e->prev;
+        e->prev = e->next = nullptr;
+        e->level = nullptr;
+        --n;
+        qty -= e->qty;
+    }
+
+    // Partial or full fill of a linked entry.
+    void reduce(QueueEntry* e, int64_t by)
     {
-        q.push_back({id, qty, ts_ns});
+        e->qty -= by;
+        qty -= by;
     }
-    
-    int64_t total_qty() const
+
+    void resize(QueueEntry* e, int64_t new_qty)
+    {
+        qty += new_qty - e->qty;
+        e->qty = new_qty;
+    }
+
+    // Loses time priority: O(1) relink at the tail.
+    void move_to_back(QueueEntry* e)
     {
-        int64_t tot = 0;
-        for (const auto& e : q) tot += e.qty;
-        return tot;
+        if (e == tail) return;
+        unlink(e);
+        push_back(e);
     }
 
-    size_t count() const { return q.size(); }
-};
\ No newline at end of file
+    int64_t total_qty() const { return qty; }
+
+    size_t count() const { return n; }
+
+    // 0-based FIFO position of a linked entry. Walks in from both ends at
+    // once, so the cost is the distance to the nearer end.
+    size_t position(const QueueEntry* e) const
+    {
+        const QueueEntry* f = head;
+        const QueueEntry* b = tail;
+        for (size_t i = 0;; ++i, f = f->next, b = b->prev) {
+            if (f == e) return i;
+            if (b == e) return n - 1 - i;
+        }
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "order.hpp"
+#include "price_level.hpp"
+
+// Self-trade prevention and per-account tallies, picked by the Stp slot of
+// Policies.
+//
+//   NoStp          default; compiled out.
+//   AccountStp<A>  orders with the same non-zero Order::account never trade
+//                  with each other; A says what happens instead. Also keeps
+//                  open quantity and net position per account.
+//
+// add() rejects orders whose account admits() refuses (BadAccount) before
+// anything else sees them.
+// The match loop asks active(taker) once per incoming order and, only if it
+// said yes, check(taker, maker) before each fill: for AccountStp that is a
+// single compare of two account ids already in cache. The on_* hooks report
+// every change of resting quantity and every fill; for NoStp they are empty.
+// A custom rule can derive from NoStp and set enabled / override check().
+
+enum class StpAction : uint8_t
+{
+    Trade,              // no conflict, fill normally
+    CancelResting,      // cancel oldest: cancel the maker, keep matching
+    CancelIncoming,     // cancel newest: stop matching, drop the taker's remainder
+    CancelBoth,
+    Decrement,          // no trade: take the smaller qty off both, drop whichever reaches 0
+};
+
+// Order::account of orders that belong to nobody; never self-trade checked.
+inline constexpr uint32_t kNoAccount = 0;
+
+struct NoStp
+{
+    static constexpr bool enabled = false;
+    static bool admits(uint32_t /*account*/) { return true; }
+    static bool active(const Order&) { return true; }
+    static StpAction check(const Order&, const QueueEntry&) { return StpAction::Trade; }
+
+    void on_open(uint32_t /*account*/, Side, int64_t /*delta*/) {}
+    void on_fill(uint32_t /*taker*/, uint32_t /*maker*/, Side /*taker side*/, int64_t /*qty*/) {}
+};
+
+struct AccountTally
+{
+    int64_t open_buy{0};        // resting qty, shown + hidden
+    int64_t open_sell{0};
+    int64_t position{0};        // bought - sold
+    int64_t traded{0};          // filled qty, both sides
+};
+
+// Tallies live in a vector indexed by account, so accounts are expected to be
+// small dense ids (agents, firms); the table grows to the largest one seen,
+// and ids from max_accounts up are rejected rather than sizing it (2 MiB at
+// the limit).
+template <StpAction A>
+class AccountStp
+{
+    static_assert(A != StpAction::Trade, "use NoStp to disable self-trade prevention");
+
+    public:
+        static constexpr bool enabled = true;
+        static constexpr StpAction action = A;
+        static constexpr uint32_t max_accounts = 1u << 16;
+
+        static bool admits(uint32_t account) { return account < max_accounts; }
+        static bool active(const Order& in) { return in.account != kNoAccount; }
+        static StpAction check(const Order& in, const QueueEntry& maker)
+        {
+            return in.account == maker.account ? A : StpAction::Trade;
+        }
+
+        // Resting qty of one account changed by delta (rest, cancel, replace, decrement).
+        void on_open(uint32_t account, Side side, int64_t delta) { open(at(account), side) += delta; }
+
+        void on_fill(uint32_t taker, uint32_t maker, Side taker_side, int64_t qty)
+        {
+            const int64_t bought = taker_side == Side::Buy ? qty : -qty;
+            AccountTally& m = at(maker);
+            open(m, taker_side == Side::Buy ? Side::Sell : Side::Buy) -= qty;
+            m.position -= bought;
+            m.traded += qty;
+            AccountTally& t = at(taker);
+            t.position += bought;
+            t.traded += qty;
+        }
+
+        // Zeroes for an account never seen.
+        AccountTally account(uint32_t id) const { return id < t_.size() ? t_[id] : AccountTally{}; }
+        size_t accounts() const { return t_.size(); }
+
+    private:
+        static int64_t& open(AccountTally& t, Side side) { return side == Side::Buy ? t.open_buy : t.open_sell; }
+
+        AccountTally& at(uint32_t id)
+        {
+            assert(admits(id));
+            if (id >= t_.size()) t_.resize(size_t{id} + 1);
+            return t_[id];
+        }
+
+        std::vector<AccountTally> t_;
+};
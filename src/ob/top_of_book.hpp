@@ -0,0 +1,220 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "order.hpp"
+#include "price_level.hpp"
+
+// Top-of-book publication for readers on other threads, picked by the
+// Publisher slot of Policies.
+//
+//   NoPublisher   default; compiled out.
+//   TopOfBook<N>  after every mutation that touched one of the top N levels
+//                 of a side, the book copies the top N of both sides into a
+//                 TopN<N> and publishes it. Readers take consistent copies
+//                 from any thread, never blocking the matching thread.
+//
+// Publication is a two-slot seqlock. The writer fills the slot readers are
+// not being pointed at, then flips the version; a reader copies the current
+// slot and only retries if the writer wrapped all the way round onto that
+// same slot meanwhile (two publishes during one copy). Every word is a
+// relaxed atomic, so the racy copy is well-defined, and on x86 both sides
+// compile to plain loads and stores.
+
+// All fields are 8 bytes wide: the writer stores them one word at a time.
+// Entries past bid_levels / ask_levels are left over from older publishes.
+template <size_t N>
+struct TopN
+{
+    struct Quote { int64_t px; int64_t qty; uint64_t orders; };
+
+    uint64_t version{0};        // publish count, 0 = nothing published yet
+    int64_t ts_ns{0};           // timestamp of the call that produced it
+    uint64_t bid_levels{0};     // valid entries in bids / asks, best first
+    uint64_t ask_levels{0};
+    Quote bids[N]{};
+    Quote asks[N]{};
+
+    bool has_bid() const { return bid_levels != 0; }
+    bool has_ask() const { return ask_levels != 0; }
+    int64_t best_bid() const { return bids[0].px; }
+    int64_t best_ask() const { return asks[0].px; }
+};
+
+struct NoPublisher
+{
+    static constexpr bool enabled = false;
+    void touch(Side, int64_t) {}
+};
+
+// Held by the book's entry points: publishes once the call is complete, so
+// readers never see a half-applied mutation (e.g. a crossed book mid-sweep).
+template <class Pub, class Book>
+class PublishGuard
+{
+    public:
+        PublishGuard(Pub& p, const Book& ob, int64_t ts_ns) : p_{p}, ob_{ob}, ts_ns_{ts_ns} {}
+        PublishGuard(const PublishGuard&) = delete;
+        PublishGuard& operator=(const PublishGuard&) = delete;
+        ~PublishGuard() { p_.publish(ob_, ts_ns_); }
+
+    private:
+        Pub& p_;
+        const Book& ob_;
+        int64_t ts_ns_;
+};
+
+template <size_t N>
+class TopOfBook
+{
+    static_assert(N > 0, "publish at least one level");
+
+    public:
+        static constexpr bool enabled = true;
+        static constexpr size_t depth = N;
+        using Snapshot = TopN<N>;
+
+        TopOfBook() { store(0, Snapshot{}); }
+
+        // Moving is for setup (e.g. returning a freshly loaded book); it must
+        // not happen while readers are attached. The snapshot goes into the
+        // slot its version selects, so readers and the next publish() see
+        // the same state as on the source.
+        TopOfBook(TopOfBook&& o) noexcept
+        {
+            const Snapshot s = o.read();
+            store(s.version & 1, s);
+            version_.store(s.version, std::memory_order_relaxed);
+            bound_[0] = o.bound_[0];
+            bound_[1] = o.bound_[1];
+            dirty_ = o.dirty_;
+        }
+
+        // ---- readers: any thread ----
+
+        // Latest snapshot. Lock-free; loops only while the writer keeps
+        // lapping this reader.
+        Snapshot read() const
+        {
+            Snapshot s;
+            while (!try_read(s)) {}
+            return s;
+        }
+
+        // One wait-free attempt; false if the copy raced a wrap-around.
+        bool try_read(Snapshot& out) const
+        {
+            const uint64_t v = version_.load(std::memory_order_acquire);
+            const Slot& slot = slots_[v & 1];
+            const uint64_t s0 = slot.seq.load(std::memory_order_acquire);
+            if (s0 & 1) return false;
+            uint64_t words[kWords];
+            for (size_t i = 0; i < kWords; ++i) words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != s0) return false;
+            std::memcpy(&out, words, sizeof out);
+            return true;
+        }
+
+        uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+        // ---- writer: the book's thread ----
+
+        // A level at px changed. Marks the snapshot stale if px is inside
+        // the published window of that side.
+        void touch(Side side, int64_t px)
+        {
+            dirty_ |= side == Side::Buy ? px >= bound_[0] : px <= bound_[1];
+        }
+
+        // Republish from the book if anything in the window changed. Levels
+        // go straight from the ladder into the slot, no staging copy.
+        template <class Book>
+        void publish(const Book& ob, int64_t ts_ns)
+        {
+            if (!dirty_) return;
+            dirty_ = false;
+
+            const uint64_t v = version_.load(std::memory_order_relaxed) + 1;
+            Slot& slot = slots_[v & 1];
+            const uint64_t seq = begin_write(slot);
+            std::atomic<uint64_t>* w = slot.words;
+            put(w[kVersion], v);
+            put(w[kTs], static_cast<uint64_t>(ts_ns));
+            put(w[kBidLevels], collect(ob, Side::Buy, w + kBids, bound_[0], std::numeric_limits<int64_t>::min()));
+            put(w[kAskLevels], collect(ob, Side::Sell, w + kAsks, bound_[1], std::numeric_limits<int64_t>::max()));
+            slot.seq.store(seq + 2, std::memory_order_release);
+            version_.store(v, std::memory_order_release);
+        }
+
+        // Force the next publish() to rebuild (e.g. after a bulk load).
+        void invalidate() { dirty_ = true; }
+
+    private:
+        static_assert(std::is_trivially_copyable_v<Snapshot>);
+        static constexpr size_t kWords = sizeof(Snapshot) / sizeof(uint64_t);
+
+        // Word offsets of the Snapshot fields.
+        static constexpr size_t kVersion = offsetof(Snapshot, version) / 8;
+        static constexpr size_t kTs = offsetof(Snapshot, ts_ns) / 8;
+        static constexpr size_t kBidLevels = offsetof(Snapshot, bid_levels) / 8;
+        static constexpr size_t kAskLevels = offsetof(Snapshot, ask_levels) / 8;
+        static constexpr size_t kBids = offsetof(Snapshot, bids) / 8;
+        static constexpr size_t kAsks = offsetof(Snapshot, asks) / 8;
+        static_assert(sizeof(Snapshot) == (4 + 6 * N) * sizeof(uint64_t) && kAsks == kBids + 3 * N,
+                      "TopN must be a packed array of 8-byte words");
+
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> seq{0};           // odd while being written
+            std::atomic<uint64_t> words[kWords];
+        };
+
+        static void put(std::atomic<uint64_t>& w, uint64_t v) { w.store(v, std::memory_order_relaxed); }
+
+        // Top N levels of one side into out (3 words each); returns how many
+        // and sets bound to the N-th price, or none if the side is shallower.
+        template <class Book>
+        static uint64_t collect(const Book& ob, Side side, std::atomic<uint64_t>* out, int64_t& bound, int64_t none)
+        {
+            size_t n = 0;
+            bound = none;
+            ob.for_each_level(side, [&](const Level& l) {
+                put(out[3 * n], static_cast<uint64_t>(l.px));
+                put(out[3 * n + 1], static_cast<uint64_t>(l.total_qty()));
+                put(out[3 * n + 2], l.count());
+                if (++n < N) return true;
+                bound = l.px;
+                return false;
+            });
+            return n;
+        }
+
+        // Mark the slot as being written; returns the (even) sequence it had.
+        static uint64_t begin_write(Slot& slot)
+        {
+            const uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+            slot.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            return seq;
+        }
+
+        // Whole-snapshot store, for construction and moves.
+        void store(size_t i, const Snapshot& s)
+        {
+            Slot& slot = slots_[i];
+            uint64_t words[kWords];
+            std::memcpy(words, &s, sizeof s);
+            const uint64_t seq = begin_write(slot);
+            for (size_t k = 0; k < kWords; ++k) put(slot.words[k], words[k]);
+            slot.seq.store(seq + 2, std::memory_order_release);
+        }
+
+        Slot slots_[2];
+        alignas(64) std::atomic<uint64_t> version_{0};
+        int64_t bound_[2]{std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+        bool dirty_{true};
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Memory for the matching hot path. Everything a book allocates per order
+// or per level comes from a BlockPool owned by that book: blocks are carved
+// from large slabs up front and recycled through an intrusive free list, so
+// once the pools have grown to the working set the steady state never
+// reaches malloc.
+
+struct PoolStats
+{
+    size_t capacity{0};     // blocks/slots currently available without growing
+    size_t in_use{0};
+    size_t high_water{0};   // max in_use ever seen
+    size_t grows{0};        // slab allocations after construction
+};
+
+// Fixed-size block allocator. Not thread-safe: one per book.
+class BlockPool
+{
+    public:
+        BlockPool(size_t block_size, size_t reserve_blocks, size_t slab_blocks = 1024)
+            : block_size_{round_up(block_size)}, slab_blocks_{slab_blocks ? slab_blocks : 1}
+        {
+            if (reserve_blocks) add_slab(reserve_blocks);
+        }
+
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+
+        // Moving keeps every handed-out block valid (slabs are heap-owned).
+        BlockPool(BlockPool&& o) noexcept
+            : block_size_{o.block_size_}, slab_blocks_{o.slab_blocks_},
+              free_{std::exchange(o.free_, nullptr)}, slabs_{std::move(o.slabs_)},
+              stats_{std::exchange(o.stats_, PoolStats{})} {}
+        BlockPool& operator=(BlockPool&& o) noexcept
+        {
+            block_size_ = o.block_size_;
+            slab_blocks_ = o.slab_blocks_;
+            free_ = std::exchange(o.free_, nullptr);
+            slabs_ = std::move(o.slabs_);
+            stats_ = std::exchange(o.stats_, PoolStats{});
+            return *this;
+        }
+
+        void* allocate()
+        {
+            if (!free_) {
+                add_slab(slab_blocks_);
+                ++stats_.grows;
+            }
+            FreeNode* n = free_;
+            free_ = n->next;
+            if (++stats_.in_use > stats_.high_water) stats_.high_water = stats_.in_use;
+            return n;
+        }
+
+        void deallocate(void* p)
+        {
+            auto* n = static_cast<FreeNode*>(p);
+            n->next = free_;
+            free_ = n;
+            --stats_.in_use;
+        }
+
+        size_t block_size() const { return block_size_; }
+        const PoolStats& stats() const { return stats_; }
+
+    private:
+        struct FreeNode { FreeNode* next; };
+
+        static size_t round_up(size_t n)
+        {
+            constexpr size_t a = alignof(std::max_align_t);
+            n = n < sizeof(FreeNode) ? sizeof(FreeNode) : n;
+            return (n + a - 1) / a * a;
+        }
+
+        void add_slab(size_t blocks)
+        {
+            slabs_.emplace_back(new std::byte[blocks * block_size_]);
+            std::byte* base = slabs_.back().get();
+            for (size_t i = blocks; i-- > 0;) {
+                auto* n = reinterpret_cast<FreeNode*>(base + i * block_size_);
+                n->next = free_;
+                free_ = n;
+            }
+            stats_.capacity += blocks;
+        }
+
+        size_t block_size_;
+        size_t slab_blocks_;
+        FreeNode* free_{nullptr};
+        std::vector<std::unique_ptr<std::byte[]>> slabs_;
+        PoolStats stats_{};
+};
+
+// Typed front end over a BlockPool.
+template <class T>
+class ObjectPool
+{
+    public:
+        explicit ObjectPool(size_t reserve, size_t slab = 4096) : pool_{sizeof(T), reserve, slab} {}
+
+        template <class... Args>
+        T* create(Args&&... args)
+        {
+            return ::new (pool_.allocate()) T(std::forward<Args>(args)...);
+        }
+
+        void destroy(T* p)
+        {
+            p->~T();
+            pool_.deallocate(p);
+        }
+
+        const PoolStats& stats() const { return pool_.stats(); }
+
+    private:
+        BlockPool pool_;
+};
+
+// std-compatible allocator for node containers (std::map etc.). Single-object
+// requests that fit the pool's block size are served from the pool; anything
+// else (bulk arrays, oversized rebinds) falls through to operator new.
+template <class T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    BlockPool* pool{nullptr};
+
+    explicit PoolAllocator(BlockPool* p) noexcept : pool{p} {}
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& o) noexcept : pool{o.pool} {}
+
+    T* allocate(size_t n)
+    {
+        if (n == 1 && sizeof(T) <= pool->block_size() && alignof(T) <= alignof(std::max_align_t))
+            return static_cast<T*>(pool->allocate());
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if (n == 1 && sizeof(T) <= pool->block_size() && alignof(T) <= alignof(std::max_align_t))
+            pool->deallocate(p);
+        else
+            ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U>& o) const noexcept { return pool == o.pool; }
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "gen/rng.hpp"
+
+namespace sim {
+
+// One-way delay of a link: base_ns plus a random part, uniform in
+// [0, jitter_ns] or exponential with mean jitter_ns (heavy-ish tail).
+struct Latency
+{
+    enum class Jitter : uint8_t { Uniform, Exponential };
+
+    int64_t base_ns{0};
+    int64_t jitter_ns{0};
+    Jitter jitter{Jitter::Uniform};
+
+    int64_t sample(gen::Rng& rng) const
+    {
+        if (jitter_ns <= 0) return base_ns;
+        if (jitter == Jitter::Uniform)
+            return base_ns + static_cast<int64_t>(rng.below(static_cast<uint64_t>(jitter_ns) + 1));
+        return base_ns + static_cast<int64_t>(rng.exponential(static_cast<double>(jitter_ns)));
+    }
+};
+
+// A point-to-point link that keeps messages in order, like a TCP session:
+// a message never arrives before the one sent ahead of it, however the
+// jitter falls.
+class Link
+{
+    public:
+        Link() = default;
+        explicit Link(const Latency& l) : l_{l} {}
+
+        const Latency& latency() const { return l_; }
+
+        // Arrival time of a message sent at ts_ns.
+        int64_t arrival(int64_t ts_ns, gen::Rng& rng)
+        {
+            last_ = std::max(last_, ts_ns + l_.sample(rng));
+            return last_;
+        }
+
+    private:
+        Latency l_{};
+        int64_t last_{0};
+};
+
+} // namespace sim
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+// Monotone priority queue on 64-bit keys (simulated time): the key pushed
+// must never be below the last key popped, which a discrete-event loop
+// guarantees. Keys live in 65 buckets by the highest bit in which they
+// differ from the last popped key; popping empties bucket 0 front to back
+// and, when it runs dry, redistributes the lowest non-empty bucket, each
+// entry moving down at most 64 times over its life. Push is O(1), pop is
+// amortised O(log range) with no comparisons between unrelated entries.
+//
+// Entries with equal keys pop in push order (the seq each entry carries
+// breaks ties when a bucket is redistributed into bucket 0), so a run is
+// deterministic and same-time events are FIFO.
+template <class V>
+class RadixHeap
+{
+    public:
+        struct Entry
+        {
+            uint64_t key;
+            uint64_t seq;
+            V value;
+        };
+
+        bool empty() const { return size_ == 0; }
+        size_t size() const { return size_; }
+        uint64_t last() const { return last_; }
+
+        void push(uint64_t key, const V& v)
+        {
+            assert(key >= last_ && "RadixHeap keys must not go below the last popped key");
+            b_[bucket(key)].push_back(Entry{key, seq_++, v});
+            ++size_;
+        }
+
+        // Smallest entry; the heap must not be empty.
+        const Entry& top()
+        {
+            if (head_ == b_[0].size()) refill();
+            return b_[0][head_];
+        }
+
+        Entry pop()
+        {
+            const Entry e = top();
+            ++head_;
+            --size_;
+            return e;
+        }
+
+        void reserve(size_t n) { b_[0].reserve(n); }
+
+    private:
+        size_t bucket(uint64_t key) const
+        {
+            return key == last_ ? 0 : static_cast<size_t>(64 - std::countl_zero(key ^ last_));
+        }
+
+        // Bucket 0 is used up: move last_ to the smallest key of the first
+        // non-empty bucket and spread that bucket over the ones below it.
+        void refill()
+        {
+            b_[0].clear();
+            head_ = 0;
+            size_t i = 1;
+            while (b_[i].empty()) ++i;
+            std::vector<Entry>& src = b_[i];
+            last_ = std::min_element(src.begin(), src.end(), [](const Entry& a, const Entry& b) {
+                        return a.key < b.key;
+                    })->key;
+            for (const Entry& e : src) b_[bucket(e.key)].push_back(e);
+            src.clear();
+            if (b_[0].size() > 1)
+                std::sort(b_[0].begin(), b_[0].end(), [](const Entry& a, const Entry& b) { return a.seq < b.seq; });
+        }
+
+        std::array<std::vector<Entry>, 65> b_{};
+        size_t head_{0};            // next entry of bucket 0
+        size_t size_{0};
+        uint64_t last_{0};
+        uint64_t seq_{0};
+};
+
+} // namespace sim
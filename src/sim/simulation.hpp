@@ -0,0 +1,466 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "gen/rng.hpp"
+#include "ob/book.hpp"
+#include "sim/latency.hpp"
+#include "sim/radix_heap.hpp"
+#include "sim/task.hpp"
+
+// Discrete-event simulation of agents trading on one or more books.
+//
+// Time is simulated: every order, fill report, quote and timer is an event
+// keyed on its ts_ns in a RadixHeap, and the loop pops them in time order
+// (FIFO on equal times). Nothing on the book side takes Order::ts_ns on
+// faith any more: an order is stamped with the time it reaches the book.
+//
+// Agents are C++20 coroutines, one per agent, written as straight-line code:
+//
+//     sim::Task taker(sim::Agent<>& a)
+//     {
+//         a.subscribe(0);
+//         for (;;) {
+//             const sim::Notice n = co_await a.next();
+//             if (n.kind == sim::NoticeKind::Quote && n.ask_px && n.ask_px < 100)
+//                 a.send(0, Order{.side = Side::Buy, .type = Type::Market, .tif = TIF::IOC, .qty = 10});
+//         }
+//     }
+//
+// Each agent has its own links to the exchange: orders leave processing_ns
+// after the agent decides to send them and arrive order_entry later; fills,
+// rejects and quotes come back over market_data. Both links keep message
+// order (latency.hpp). What an agent sees is therefore always late by its
+// own latency, and two agents racing for the same quote are decided by it.
+//
+// Events are a kind, an agent, a book and a payload in a slab; the heap
+// holds 24-byte (time, seq, slot) entries. Dispatch is a switch, no
+// allocation per event in the steady state.
+
+namespace sim {
+
+enum class NoticeKind : uint8_t
+{
+    Timer,      // next(timeout) ran out
+    Fill,       // one of the agent's orders traded
+    Quote,      // best bid / ask of a subscribed book changed (conflated)
+    Reject,     // an add / cancel / replace was refused
+};
+
+// Something the exchange told an agent, or a timeout.
+struct Notice
+{
+    NoticeKind kind{NoticeKind::Timer};
+    RejectReason reason{RejectReason::None};    // Reject
+    Side side{};                // Fill / rejected Add: side of the agent's order (Buy for a
+                                // rejected cancel / replace, which does not carry one)
+    uint32_t book{0};
+    uint64_t order_id{0};       // Fill / Reject
+    int64_t ts_ns{0};           // exchange time it happened (Timer: the deadline)
+    int64_t px{0};              // Fill: trade price; Quote: best bid, 0 = none
+    int64_t qty{0};             // Fill: traded qty; Quote: qty at the best bid
+    int64_t ask_px{0};          // Quote: best ask, 0 = none
+    int64_t ask_qty{0};
+};
+
+struct AgentConfig
+{
+    Latency order_entry{};      // agent -> book
+    Latency market_data{};      // book -> agent: fills, rejects, quotes
+    int64_t processing_ns{0};   // reaction time, added to every send
+    int64_t start_ns{0};        // first resume of the body
+    uint64_t seed{1};           // latency jitter and Agent::rng()
+};
+
+struct SimConfig
+{
+    int64_t start_ns{0};
+    uint64_t first_order_id{1};     // ids handed out by Agent::send
+    size_t events{1 << 16};         // event slab / heap capacity reserved up front
+};
+
+template <class Book> class Simulation;
+
+template <class Book = OrderBook>
+class Agent
+{
+    public:
+        Agent(const Agent&) = delete;
+        Agent& operator=(const Agent&) = delete;
+
+        uint32_t id() const { return id_; }
+        int64_t now() const { return sim_.now(); }
+        gen::Rng& rng() { return rng_; }
+
+        // Order entry. Each is scheduled to reach the book after
+        // processing_ns plus the order_entry latency. send() assigns o.id
+        // (unique in the simulation) and returns it; o.ts_ns is set on
+        // arrival. Rejections come back as Reject notices. cancel() and
+        // replace() only reach the agent's own orders: any other id is
+        // refused as UnknownId without touching the book.
+        uint64_t send(uint32_t book, Order o)
+        {
+            o.id = sim_.new_order_id(id_);
+            sim_.to_book(*this, book, MsgKind::Add, o);
+            return o.id;
+        }
+
+        void cancel(uint32_t book, uint64_t order_id)
+        {
+            Order o;
+            o.id = order_id;
+            sim_.to_book(*this, book, MsgKind::Cancel, o);
+        }
+
+        void replace(uint32_t book, uint64_t order_id, int64_t px, int64_t qty)
+        {
+            Order o;
+            o.id = order_id;
+            o.px = px;
+            o.qty = qty;
+            sim_.to_book(*this, book, MsgKind::Replace, o);
+        }
+
+        // Quote notices for every change of that book's best bid / ask.
+        void subscribe(uint32_t book) { sim_.subscribe(*this, book); }
+
+        // ---- awaitables ----
+
+        struct SleepAwaiter
+        {
+            Agent& a;
+            int64_t until;
+            bool await_ready() const { return until <= a.now(); }
+            void await_suspend(std::coroutine_handle<>) { a.state_ = State::Sleeping; a.sim_.wake_at(a, until); }
+            void await_resume() const {}
+        };
+
+        struct NextAwaiter
+        {
+            Agent& a;
+            int64_t deadline;       // < 0: none
+            bool await_ready() const { return a.pending() || (deadline >= 0 && deadline <= a.now()); }
+            void await_suspend(std::coroutine_handle<>)
+            {
+                a.state_ = State::Waiting;
+                if (deadline >= 0) a.sim_.wake_at(a, deadline);
+            }
+            Notice await_resume() { return a.pending() ? a.pop() : Notice{.ts_ns = a.now()}; }
+        };
+
+        // Resume ns later / at ts_ns. Notices arriving meanwhile queue up.
+        SleepAwaiter sleep(int64_t ns) { return {*this, now() + ns}; }
+        SleepAwaiter sleep_until(int64_t ts_ns) { return {*this, ts_ns}; }
+
+        // Next notice, oldest first; a Timer notice if timeout_ns (>= 0)
+        // passes first.
+        NextAwaiter next(int64_t timeout_ns = -1) { return {*this, timeout_ns < 0 ? -1 : now() + timeout_ns}; }
+
+        // Notices received and not yet taken by next().
+        size_t pending() const { return inbox_.size() - head_; }
+        bool done() const { return state_ == State::Done; }
+
+    private:
+        friend class Simulation<Book>;
+        enum class State : uint8_t { Running, Sleeping, Waiting, Done };
+
+        Agent(Simulation<Book>& sim, uint32_t id, const AgentConfig& cfg)
+            : sim_{sim}, id_{id}, cfg_{cfg}, rng_{cfg.seed}, entry_{cfg.order_entry}, md_{cfg.market_data} {}
+
+        // Quotes are conflated: a newer one from the same book replaces one
+        // still waiting at the back of the inbox.
+        void push(const Notice& n)
+        {
+            if (n.kind == NoticeKind::Quote && pending() && inbox_.back().kind == NoticeKind::Quote
+                && inbox_.back().book == n.book)
+                inbox_.back() = n;
+            else
+                inbox_.push_back(n);
+        }
+
+        Notice pop()
+        {
+            const Notice n = inbox_[head_++];
+            if (head_ == inbox_.size()) {
+                inbox_.clear();
+                head_ = 0;
+            }
+            return n;
+        }
+
+        Simulation<Book>& sim_;
+        uint32_t id_;
+        AgentConfig cfg_;
+        gen::Rng rng_;
+        Link entry_;
+        Link md_;
+        std::function<Task(Agent&)> body_;     // owns the captures a lambda body refers to
+        Task task_{};
+        State state_{State::Sleeping};
+        uint64_t gen_{0};               // bumped on every resume; stale timers carry an old one
+        std::vector<Notice> inbox_;
+        size_t head_{0};
+};
+
+template <class Book = OrderBook>
+class Simulation
+{
+    public:
+        using AgentType = Agent<Book>;
+
+        explicit Simulation(const SimConfig& cfg = {})
+            : now_{cfg.start_ns}, next_id_{cfg.first_order_id}
+        {
+            slab_.reserve(cfg.events);
+            free_.reserve(cfg.events);
+            q_.reserve(cfg.events);
+        }
+
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+
+        // ---- setup ----
+
+        uint32_t add_book(std::string symbol, int64_t tick, const BookConfig& cfg = {})
+        {
+            books_.push_back(std::make_unique<BookState>(std::move(symbol), tick, cfg));
+            return static_cast<uint32_t>(books_.size() - 1);
+        }
+
+        // body(Agent&) -> Task. The body first runs at cfg.start_ns. The
+        // agent keeps its own copy of body, so a capturing lambda coroutine
+        // stays valid for the whole run.
+        template <class F>
+        uint32_t add_agent(const AgentConfig& cfg, F&& body)
+        {
+            const auto id = static_cast<uint32_t>(agents_.size());
+            agents_.push_back(std::unique_ptr<AgentType>(new AgentType(*this, id, cfg)));
+            AgentType& a = *agents_.back();
+            a.body_ = std::forward<F>(body);
+            a.task_ = a.body_(a);
+            wake_at(a, cfg.start_ns);
+            return id;
+        }
+
+        // Direct access, for inspection between run() calls. Orders added
+        // here bypass the agents and get no notices.
+        Book& book(uint32_t i) { return books_[i]->book; }
+        const Book& book(uint32_t i) const { return books_[i]->book; }
+        size_t books() const { return books_.size(); }
+        AgentType& agent(uint32_t i) { return *agents_[i]; }
+        size_t agents() const { return agents_.size(); }
+
+        // ---- running ----
+
+        // Process events in time order until none is left at or before
+        // until_ns; now() ends at the last event processed. Can be called
+        // again to continue. Rethrows an exception escaping an agent body.
+        void run(int64_t until_ns = std::numeric_limits<int64_t>::max())
+        {
+            while (!q_.empty() && q_.top().key <= static_cast<uint64_t>(until_ns)) {
+                const auto e = q_.pop();
+                now_ = static_cast<int64_t>(e.key);
+                ++processed_;
+                switch (slab_[e.value].kind) {
+                    case Kind::Wake:    wake(e.value); break;
+                    case Kind::Arrive:  arrive(e.value); break;
+                    case Kind::Deliver: deliver(e.value); break;
+                }
+            }
+        }
+
+        int64_t now() const { return now_; }
+        uint64_t events_processed() const { return processed_; }
+        size_t events_pending() const { return q_.size(); }
+
+        // Agent that sent an order id (handed out by Agent::send), or -1.
+        int64_t owner(uint64_t order_id) const
+        {
+            const uint64_t i = order_id - first_id();
+            return order_id >= first_id() && i < owner_.size() ? owner_[i] : -1;
+        }
+
+    private:
+        friend class Agent<Book>;
+
+        enum class Kind : uint8_t { Wake, Arrive, Deliver };
+
+        struct Item
+        {
+            Kind kind{};
+            MsgKind msg{};
+            uint32_t agent{0};
+            uint32_t book{0};
+            union
+            {
+                uint64_t gen;       // Wake
+                Order order;        // Arrive: add (whole order) / cancel (id) / replace (id, px, qty)
+                Notice notice;      // Deliver
+            };
+
+            Item() : gen{0} {}
+        };
+
+        struct Top
+        {
+            int64_t bid_px{0}, bid_qty{0}, ask_px{0}, ask_qty{0};
+            bool operator==(const Top&) const = default;
+        };
+
+        struct BookState
+        {
+            BookState(std::string symbol, int64_t tick, const BookConfig& cfg) : book(std::move(symbol), tick, cfg) {}
+            Book book;
+            Top top{};
+            std::vector<uint32_t> subscribers;
+        };
+
+        uint64_t first_id() const { return next_id_ - owner_.size(); }
+
+        uint32_t alloc()
+        {
+            if (free_.empty()) {
+                slab_.emplace_back();
+                return static_cast<uint32_t>(slab_.size() - 1);
+            }
+            const uint32_t i = free_.back();
+            free_.pop_back();
+            return i;
+        }
+
+        // Never in the past: the heap is monotone.
+        Item& schedule(int64_t ts_ns, Kind kind, uint32_t agent)
+        {
+            const uint32_t i = alloc();
+            q_.push(static_cast<uint64_t>(std::max(ts_ns, now_)), i);
+            Item& it = slab_[i];
+            it.kind = kind;
+            it.agent = agent;
+            return it;
+        }
+
+        // ---- called by agents ----
+
+        uint64_t new_order_id(uint32_t agent)
+        {
+            owner_.push_back(agent);
+            return next_id_++;
+        }
+
+        void to_book(AgentType& a, uint32_t book, MsgKind kind, const Order& o)
+        {
+            Item& it = schedule(a.entry_.arrival(now_ + a.cfg_.processing_ns, a.rng_), Kind::Arrive, a.id_);
+            it.msg = kind;
+            it.book = book;
+            it.order = o;
+        }
+
+        void subscribe(AgentType& a, uint32_t book) { books_[book]->subscribers.push_back(a.id_); }
+
+        void wake_at(AgentType& a, int64_t ts_ns) { schedule(ts_ns, Kind::Wake, a.id_).gen = a.gen_; }
+
+        // ---- event handlers ----
+
+        void resume(AgentType& a)
+        {
+            ++a.gen_;
+            a.state_ = AgentType::State::Running;
+            a.task_.resume();
+            if (a.task_.done()) a.state_ = AgentType::State::Done;
+        }
+
+        // Handlers read what they need out of the slot and release it before
+        // anything can schedule (and so grow the slab under them).
+
+        void wake(uint32_t slot)
+        {
+            const Item& it = slab_[slot];
+            AgentType& a = *agents_[it.agent];
+            const bool live = it.gen == a.gen_ && a.state_ != AgentType::State::Done;
+            free_.push_back(slot);
+            if (live) resume(a);
+        }
+
+        void deliver(uint32_t slot)
+        {
+            const Item& it = slab_[slot];
+            AgentType& a = *agents_[it.agent];
+            if (a.state_ != AgentType::State::Done) a.push(it.notice);
+            free_.push_back(slot);
+            if (a.state_ == AgentType::State::Waiting) resume(a);
+        }
+
+        void notify(uint32_t agent, const Notice& n)
+        {
+            AgentType& a = *agents_[agent];
+            schedule(a.md_.arrival(now_, a.rng_), Kind::Deliver, agent).notice = n;
+        }
+
+        void arrive(uint32_t slot)
+        {
+            const Item it = slab_[slot];
+            free_.push_back(slot);
+            BookState& bs = *books_[it.book];
+            Book& ob = bs.book;
+            Order o = it.order;
+            o.ts_ns = now_;
+
+            // the book only knows ids, so ownership is checked here
+            const bool foreign = it.msg != MsgKind::Add && owner(o.id) != static_cast<int64_t>(it.agent);
+            bool ok = false;
+            if (!foreign) {
+                switch (it.msg) {
+                    case MsgKind::Add:     ok = ob.add(o); break;
+                    case MsgKind::Cancel:  ok = ob.cancel(o.id, now_); break;
+                    case MsgKind::Replace: ok = ob.replace(o.id, o.px, o.qty, now_); break;
+                }
+            }
+            if (!ok)
+                notify(it.agent, Notice{.kind = NoticeKind::Reject,
+                                        .reason = foreign ? RejectReason::UnknownId : ob.last_reject(),
+                                        .side = o.side, .book = it.book, .order_id = o.id, .ts_ns = now_});
+
+            ob.events().drain([&](const Event& e) {
+                if (e.type != EventType::Trade) return;
+                Notice n{.kind = NoticeKind::Fill, .book = it.book, .ts_ns = e.ts_ns, .px = e.px, .qty = e.qty};
+                if (const int64_t taker = owner(e.id); taker >= 0) {
+                    n.side = e.side;
+                    n.order_id = e.id;
+                    notify(static_cast<uint32_t>(taker), n);
+                }
+                if (const int64_t maker = owner(e.maker_id); maker >= 0) {
+                    n.side = opposite(e.side);
+                    n.order_id = e.maker_id;
+                    notify(static_cast<uint32_t>(maker), n);
+                }
+            });
+
+            if (bs.subscribers.empty()) return;
+            Top top;
+            ob.for_each_level(Side::Buy, [&](const Level& l) { top.bid_px = l.px; top.bid_qty = l.total_qty(); return false; });
+            ob.for_each_level(Side::Sell, [&](const Level& l) { top.ask_px = l.px; top.ask_qty = l.total_qty(); return false; });
+            if (top == bs.top) return;
+            bs.top = top;
+            const Notice q{.kind = NoticeKind::Quote, .book = it.book, .ts_ns = now_, .px = top.bid_px,
+                           .qty = top.bid_qty, .ask_px = top.ask_px, .ask_qty = top.ask_qty};
+            for (const uint32_t s : bs.subscribers) notify(s, q);
+        }
+
+        int64_t now_;
+        uint64_t next_id_;
+        uint64_t processed_{0};
+        RadixHeap<uint32_t> q_;
+        std::vector<Item> slab_;
+        std::vector<uint32_t> free_;
+        std::vector<std::unique_ptr<BookState>> books_;
+        std::vector<std::unique_ptr<AgentType>> agents_;
+        std::vector<uint32_t> owner_;       // agent per order id, from first_order_id
+};
+
+} // namespace sim
@@ -0,0 +1,56 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace sim {
+
+// Return type of an agent body: a coroutine that starts suspended and is
+// resumed only by the Simulation that owns it (at its start time, then
+// whenever something it co_awaits is ready). It never resumes anyone else
+// on completion; the Simulation sees done() and destroys it. An exception
+// escaping the body is kept and rethrown from Simulation::run().
+class Task
+{
+    public:
+        struct promise_type
+        {
+            std::exception_ptr error;
+
+            Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        Task() = default;
+        Task(Task&& o) noexcept : h_{std::exchange(o.h_, {})} {}
+        Task& operator=(Task&& o) noexcept
+        {
+            if (this != &o) {
+                if (h_) h_.destroy();
+                h_ = std::exchange(o.h_, {});
+            }
+            return *this;
+        }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() { if (h_) h_.destroy(); }
+
+        bool done() const { return !h_ || h_.done(); }
+
+        // Run until the next suspension point; rethrows what the body threw.
+        void resume()
+        {
+            h_.resume();
+            if (h_.done() && h_.promise().error) std::rethrow_exception(h_.promise().error);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) : h_{h} {}
+
+        std::coroutine_handle<promise_type> h_{};
+};
+
+} // namespace sim
@@ -0,0 +1,106 @@
+#include "ob/book.hpp"
+#include "ob/order.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+// Count every global allocation in this test binary. The hooks stay out of
+// line: once GCC inlines them it pairs free() with the operator new call
+// site and warns (-Wmismatched-new-delete) at some optimisation levels.
+static std::atomic<size_t> g_allocs{0};
+
+[[gnu::noinline]] void* operator new(size_t n)
+{
+    ++g_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc{};
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept { std::free(p); }
+void* operator new[](size_t n) { return ::operator new(n); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { ::operator delete(p); }
+
+// Resting adds, cancels, repricing replaces and marketable orders around a
+// fixed mid, keeping the live order count bounded.
+template <class Book>
+static void churn(Book& ob, uint64_t& next_id, std::vector<uint64_t>& live, std::mt19937_64& rng, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        const int roll = static_cast<int>(rng() % 10);
+        if ((roll < 5 && live.size() < 1500) || live.empty()) {
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            const int64_t off = 1 + static_cast<int64_t>(rng() % 30);
+            const int64_t px = side == Side::Buy ? 10000 - off : 10000 + off;
+            ob.add(Order{next_id, side, Type::Limit, TIF::Day, px, 1 + static_cast<int64_t>(rng() % 20), i, false});
+            live.push_back(next_id++);
+        } else if (roll < 8) {
+            const size_t k = rng() % live.size();
+            ob.cancel(live[k], i);
+            live[k] = live.back();
+            live.pop_back();
+        } else if (roll < 9) {
+            const int64_t px = 10000 + static_cast<int64_t>(rng() % 61) - 30;
+            ob.replace(live[rng() % live.size()], px, 1 + static_cast<int64_t>(rng() % 20), i);
+        } else {
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            ob.add(Order{next_id++, side, Type::Market, TIF::IOC, 0, 1 + static_cast<int64_t>(rng() % 40), i, false});
+        }
+        if (ob.events().size() > 1000) ob.events().clear();
+    }
+}
+
+template <class Book>
+static void expect_steady_state_malloc_free()
+{
+    BookConfig cfg;
+    cfg.ladder = LadderConfig{10000, 256, 128};
+    cfg.orders = 4096;
+    cfg.events = 2048;
+    Book ob("TEST", 1, cfg);
+
+    std::mt19937_64 rng(3);
+    std::vector<uint64_t> live;
+    live.reserve(4096);
+    uint64_t next_id = 1;
+
+    churn(ob, next_id, live, rng, 50000);        // warm-up
+
+    const size_t before = g_allocs.load();
+    churn(ob, next_id, live, rng, 200000);
+    ob.cancel_day(200000);                      // bulk cancel scratch is preallocated too
+    live.clear();
+    ob.events().clear();
+    churn(ob, next_id, live, rng, 50000);
+    EXPECT_EQ(g_allocs.load() - before, 0u);
+
+    const MemoryStats ms = ob.memory_stats();
+    EXPECT_GT(ms.orders.high_water, 0u);
+    EXPECT_LE(ms.orders.high_water, ms.orders.capacity);
+    EXPECT_EQ(ms.orders.grows, 0u);
+    EXPECT_EQ(ms.index.grows, 0u);
+    EXPECT_LE(ms.bid_levels.high_water, ms.bid_levels.capacity);
+    EXPECT_LE(ms.events.high_water, ms.events.capacity);
+    EXPECT_EQ(ms.events.grows, 0u);
+}
+
+TEST(Alloc, MapBookSteadyStateDoesNotMalloc) { expect_steady_state_malloc_free<OrderBook>(); }
+TEST(Alloc, ArrayBookSteadyStateDoesNotMalloc) { expect_steady_state_malloc_free<ArrayOrderBook>(); }
+
+TEST(Alloc, PoolsGrowPastCapacityAndReportIt) {
+    BookConfig cfg;
+    cfg.orders = 16;
+    OrderBook ob("TEST", 1, cfg);
+    for (uint64_t id = 1; id <= 5000; ++id)
+        ASSERT_TRUE(ob.add(Order{id, Side::Buy, Type::Limit, TIF::Day, 10000 - static_cast<int64_t>(id % 50), 1, 0, false}));
+
+    const MemoryStats ms = ob.memory_stats();
+    EXPECT_EQ(ms.orders.in_use, 5000u);
+    EXPECT_EQ(ms.orders.high_water, 5000u);
+    EXPECT_GE(ms.orders.capacity, 5000u);
+    EXPECT_GT(ms.orders.grows, 0u);
+    EXPECT_GT(ms.index.grows, 0u);
+    EXPECT_EQ(ms.bid_levels.in_use, 50u);
+}
@@ -1,6 +1,14 @@
+#include "gen/poisson.hpp"
 #include "ob/book.hpp"
 #include "ob/order.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
 
 TEST(Book, InsertAndSnapshot) {
     OrderBook ob("TEST", 1);
@@ -246,4 +254,1212 @@ TEST(Book, Replace_PriceChangeCanTrade_OrRepost) {
     ASSERT_EQ(bs.size(), 1u);
     EXPECT_EQ(bs[0].px, 10200);
     EXPECT_EQ(bs[0].qty, 2);
-}
\ No newline at end of file
+}
+TEST(Book, CancelMiddleOfQueue_KeepsFIFOOfOthers) {
+    OrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 3, false}));
+
+    EXPECT_TRUE(ob.cancel(2, 4));
+    EXPECT_FALSE(ob.cancel(2, 5)); // already gone
+
+    auto as = ob.asks(5);
+    ASSERT_EQ(as.size(), 1u);
+    EXPECT_EQ(as[0].qty, 20);
+    EXPECT_EQ(as[0].orders, 2u);
+
+    ASSERT_TRUE(ob.add(Order{9, Side::Buy, Type::Limit, TIF::IOC, 10100, 20, 6, false}));
+    auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(trades[0].maker_id, 1u);
+    EXPECT_EQ(trades[1].maker_id, 3u);
+    EXPECT_TRUE(ob.asks(5).empty());
+}
+
+TEST(Book, LevelAggregates_TrackFillsCancelsAndReplaces) {
+    OrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10100, 20, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 10100, 30, 3, false}));
+    ASSERT_TRUE(ob.add(Order{4, Side::Sell, Type::Limit, TIF::Day, 10200, 40, 4, false}));
+
+    // partial fill of the front order
+    ASSERT_TRUE(ob.add(Order{9, Side::Buy, Type::Limit, TIF::IOC, 10100, 4, 5, false}));
+    auto as = ob.asks(5);
+    EXPECT_EQ(as[0].qty, 56);
+    EXPECT_EQ(as[0].orders, 3u);
+
+    ASSERT_TRUE(ob.replace(2, 10100, 5, 6));    // shrink
+    ASSERT_TRUE(ob.replace(1, 10100, 16, 7));   // grow, to back
+    ASSERT_TRUE(ob.cancel(3, 8));
+    as = ob.asks(5);
+    EXPECT_EQ(as[0].qty, 21);
+    EXPECT_EQ(as[0].orders, 2u);
+    EXPECT_EQ(as[1].qty, 40);
+
+    // FOK uses the level totals across both prices: 21 + 40 = 61 available
+    EXPECT_FALSE(ob.add(Order{10, Side::Buy, Type::Limit, TIF::FOK, 10200, 62, 9, false}));
+    EXPECT_TRUE(ob.add(Order{11, Side::Buy, Type::Limit, TIF::FOK, 10200, 61, 10, false}));
+    EXPECT_TRUE(ob.asks(5).empty());
+}
+
+TEST(Book, Events_FullStreamInOrder) {
+    OrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 2, false}));
+    EXPECT_FALSE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 3, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy,  Type::Limit, TIF::Day, 10100, 15, 4, false}));
+    ASSERT_TRUE(ob.replace(2, 10100, 3, 5));
+    ASSERT_TRUE(ob.cancel(2, 6));
+    EXPECT_FALSE(ob.cancel(2, 7));
+
+    std::vector<Event> ev;
+    EXPECT_EQ(ob.events().drain([&](const Event& e) { ev.push_back(e); }), 14u);
+    EXPECT_TRUE(ob.events().empty());
+
+    auto is = [&](size_t i, EventType t, uint64_t id) {
+        return ev[i].type == t && ev[i].id == id;
+    };
+    ASSERT_EQ(ev.size(), 14u);
+    EXPECT_TRUE(is(0, EventType::Accept, 1));
+    EXPECT_EQ(ev[1].type, EventType::LevelUpdate);
+    EXPECT_EQ(ev[1].qty, 10);
+    EXPECT_TRUE(is(2, EventType::Accept, 2));
+    EXPECT_EQ(ev[3].qty, 20);
+    EXPECT_EQ(ev[3].orders, 2u);
+
+    EXPECT_TRUE(is(4, EventType::Reject, 2));
+    EXPECT_EQ(ev[4].reason, RejectReason::DuplicateId);
+
+    // buy 15: accept, two fills at the ask level, one L2 delta for it
+    EXPECT_TRUE(is(5, EventType::Accept, 3));
+    EXPECT_TRUE(is(6, EventType::Trade, 3));
+    EXPECT_EQ(ev[6].maker_id, 1u);
+    EXPECT_EQ(ev[6].qty, 10);
+    EXPECT_EQ(ev[6].side, Side::Buy);
+    EXPECT_TRUE(is(7, EventType::Trade, 3));
+    EXPECT_EQ(ev[7].maker_id, 2u);
+    EXPECT_EQ(ev[7].qty, 5);
+    EXPECT_EQ(ev[8].type, EventType::LevelUpdate);
+    EXPECT_EQ(ev[8].side, Side::Sell);
+    EXPECT_EQ(ev[8].qty, 5);
+    EXPECT_EQ(ev[8].orders, 1u);
+
+    EXPECT_TRUE(is(9, EventType::Replace, 2));
+    EXPECT_EQ(ev[10].qty, 3);
+    EXPECT_TRUE(is(11, EventType::Cancel, 2));
+    EXPECT_EQ(ev[11].qty, 3);
+    EXPECT_EQ(ev[12].type, EventType::LevelUpdate);
+    EXPECT_EQ(ev[12].qty, 0);
+    EXPECT_EQ(ev[12].orders, 0u);
+    EXPECT_TRUE(is(13, EventType::Reject, 2));
+    EXPECT_EQ(ev[13].reason, RejectReason::UnknownId);
+}
+
+TEST(Book, ApplyBatch_SequentialWithPerMessageStatus) {
+    OrderBook ob("TEST", 5);
+    const OrderMsg msgs[] = {
+        add_msg(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}),
+        add_msg(Order{2, Side::Sell, Type::Limit, TIF::Day, 10101, 10, 2, false}),  // off tick
+        add_msg(Order{1, Side::Sell, Type::Limit, TIF::Day, 10105, 10, 3, false}),  // duplicate
+        replace_msg(1, 10100, 4, 4),
+        add_msg(Order{3, Side::Buy,  Type::Limit, TIF::IOC, 10100, 3, 5, false}),
+        cancel_msg(1, 6),
+        cancel_msg(1, 7),                                                             // gone
+    };
+    RejectReason status[7];
+    EXPECT_EQ(ob.apply_batch(msgs, status), 4u);
+
+    EXPECT_EQ(status[0], RejectReason::None);
+    EXPECT_EQ(status[1], RejectReason::BadPrice);
+    EXPECT_EQ(status[2], RejectReason::DuplicateId);
+    EXPECT_EQ(status[3], RejectReason::None);
+    EXPECT_EQ(status[4], RejectReason::None);
+    EXPECT_EQ(status[5], RejectReason::None);
+    EXPECT_EQ(status[6], RejectReason::UnknownId);
+
+    auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].qty, 3);
+    EXPECT_TRUE(ob.asks(5).empty());
+
+    OrderMsg bad = cancel_msg(9, 8);
+    bad.kind = 7;
+    RejectReason st;
+    EXPECT_EQ(ob.apply_batch({&bad, 1}, {&st, 1}), 0u);
+    EXPECT_EQ(st, RejectReason::BadMessage);
+}
+
+TEST(Book, ApplyBatch_RejectsOutOfRangeEnums) {
+    OrderBook ob("TEST", 5);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 10000, 10, 1, false}));
+    ob.events().clear();
+
+    OrderMsg msgs[4];
+    for (int i = 0; i < 4; ++i)
+        msgs[i] = add_msg(Order{uint64_t(10 + i), Side::Sell, Type::Limit, TIF::Day, 10000, 5, 2, false});
+    msgs[0].side = 7;
+    msgs[1].type = 9;
+    msgs[2].tif  = 200;
+    RejectReason status[4];
+    EXPECT_EQ(ob.apply_batch(msgs, status), 1u);
+    EXPECT_EQ(status[0], RejectReason::BadMessage);
+    EXPECT_EQ(status[1], RejectReason::BadMessage);
+    EXPECT_EQ(status[2], RejectReason::BadMessage);
+    EXPECT_EQ(status[3], RejectReason::None);
+
+    // only the well-formed message reached the book
+    auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].taker_id, 13u);
+    EXPECT_EQ(ob.bids(1)[0].qty, 5);
+}
+
+TEST(Book, TypedAdd_MatchesRuntimeDispatch) {
+    OrderBook a("TEST", 1), b("TEST", 1);
+    for (OrderBook* ob : {&a, &b}) {
+        ASSERT_TRUE(ob->add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+        ASSERT_TRUE(ob->add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10102, 10, 2, false}));
+    }
+
+    const Order ioc{3, Side::Buy, Type::Limit, TIF::IOC, 10101, 25, 3, false};
+    EXPECT_TRUE(a.add(ioc));
+    Order typed = ioc;
+    typed.tif = TIF::Day;                   // ignored by the typed path
+    EXPECT_TRUE((b.add<Type::Limit, TIF::IOC>(typed)));
+
+    const Order fok{4, Side::Buy, Type::Market, TIF::FOK, 0, 50, 4, false};
+    EXPECT_FALSE(a.add(fok));
+    EXPECT_FALSE((b.add<Type::Market, TIF::FOK>(fok)));
+    EXPECT_EQ(b.last_reject(), RejectReason::CannotFill);
+
+    std::vector<Event> ea, eb;
+    a.events().drain([&](const Event& e) { ea.push_back(e); });
+    b.events().drain([&](const Event& e) { eb.push_back(e); });
+    ASSERT_EQ(ea.size(), eb.size());
+    for (size_t i = 0; i < ea.size(); ++i) {
+        EXPECT_EQ(ea[i].type, eb[i].type);
+        EXPECT_EQ(ea[i].id, eb[i].id);
+        EXPECT_EQ(ea[i].px, eb[i].px);
+        EXPECT_EQ(ea[i].qty, eb[i].qty);
+    }
+    EXPECT_TRUE(b.bids(5).empty());          // IOC remainder did not rest
+    ASSERT_EQ(b.asks(5).size(), 1u);
+    EXPECT_EQ(b.asks(5)[0].px, 10102);
+}
+
+TEST(Book, Policies_NullSinkAndTrustedInputKeepBookState) {
+    using Quiet = BasicOrderBook<MapLadder, Policies<NullSink, NoStp, TrustedInput>>;
+    OrderBook ref("TEST", 1);
+    Quiet quiet("TEST", 1);
+
+    gen::PoissonFlow flow({}, 7);
+    std::vector<OrderMsg> msgs(20000);
+    flow.fill(msgs);
+    std::vector<RejectReason> sa(msgs.size()), sb(msgs.size());
+    EXPECT_EQ(ref.apply_batch(msgs, sa), quiet.apply_batch(msgs, sb));
+    EXPECT_EQ(sa, sb);
+
+    EXPECT_TRUE(quiet.events().empty());
+    EXPECT_EQ(ref.order_count(), quiet.order_count());
+    const auto rb = ref.bids(50), qb = quiet.bids(50);
+    const auto ra = ref.asks(50), qa = quiet.asks(50);
+    ASSERT_EQ(rb.size(), qb.size());
+    ASSERT_EQ(ra.size(), qa.size());
+    for (size_t i = 0; i < rb.size(); ++i) {
+        EXPECT_EQ(rb[i].px, qb[i].px);
+        EXPECT_EQ(rb[i].qty, qb[i].qty);
+    }
+    for (size_t i = 0; i < ra.size(); ++i) {
+        EXPECT_EQ(ra[i].px, qa[i].px);
+        EXPECT_EQ(ra[i].qty, qa[i].qty);
+    }
+}
+
+namespace {
+// Test owner rule: ids in the same block of 100 belong to one trader.
+template <StpAction A>
+struct SameBlockStp : NoStp
+{
+    static constexpr bool enabled = true;
+    static StpAction check(const Order& in, const QueueEntry& maker)
+    {
+        return in.id / 100 == maker.id / 100 ? A : StpAction::Trade;
+    }
+};
+}
+
+TEST(Book, Policies_StpHook) {
+    using CancelResting = BasicOrderBook<MapLadder, Policies<RingSink, SameBlockStp<StpAction::CancelResting>>>;
+    using CancelIncoming = BasicOrderBook<MapLadder, Policies<RingSink, SameBlockStp<StpAction::CancelIncoming>>>;
+
+    {
+        CancelResting ob("TEST", 1);
+        ASSERT_TRUE(ob.add(Order{101, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+        ASSERT_TRUE(ob.add(Order{201, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 2, false}));
+        ob.events().clear();
+        ASSERT_TRUE(ob.add(Order{102, Side::Buy, Type::Limit, TIF::Day, 10100, 15, 3, false}));
+
+        // Own order 101 is cancelled, 201 trades, the remainder rests.
+        std::vector<Event> ev;
+        ob.events().drain([&](const Event& e) { ev.push_back(e); });
+        ASSERT_GE(ev.size(), 3u);
+        EXPECT_EQ(ev[1].type, EventType::Cancel);
+        EXPECT_EQ(ev[1].id, 101u);
+        EXPECT_EQ(ev[2].type, EventType::Trade);
+        EXPECT_EQ(ev[2].maker_id, 201u);
+        EXPECT_EQ(ev[2].qty, 10);
+        EXPECT_EQ(ob.order_count(), 1u);
+        EXPECT_TRUE(ob.asks(5).empty());
+        ASSERT_EQ(ob.bids(5).size(), 1u);
+        EXPECT_EQ(ob.bids(5)[0].qty, 5);
+    }
+    {
+        CancelIncoming ob("TEST", 1);
+        ASSERT_TRUE(ob.add(Order{201, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+        ASSERT_TRUE(ob.add(Order{101, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 2, false}));
+        ASSERT_TRUE(ob.add(Order{102, Side::Buy, Type::Limit, TIF::Day, 10100, 15, 3, false}));
+
+        // 201 fills 10, then own order 101 stops the taker; nothing rests.
+        auto trades = ob.pop_trade();
+        ASSERT_EQ(trades.size(), 1u);
+        EXPECT_EQ(trades[0].maker_id, 201u);
+        EXPECT_TRUE(ob.bids(5).empty());
+        ASSERT_EQ(ob.asks(5).size(), 1u);
+        EXPECT_EQ(ob.asks(5)[0].qty, 10);
+    }
+}
+
+TEST(Book, Metrics_CountersAndHistograms) {
+    InstrumentedOrderBook ob("TEST", 5);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 10105, 10, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 10105, 10, 3, false}));
+    EXPECT_FALSE(ob.add(Order{4, Side::Sell, Type::Limit, TIF::Day, 10101, 10, 4, false}));  // off tick
+    EXPECT_FALSE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 10110, 10, 5, false}));  // duplicate
+    ASSERT_TRUE(ob.add(Order{5, Side::Buy, Type::Market, TIF::IOC, 0, 25, 6, false}));        // sweeps 2 levels
+    ASSERT_TRUE(ob.replace(3, 10110, 5, 7));
+    ASSERT_TRUE(ob.cancel(3, 8));
+    EXPECT_FALSE(ob.cancel(3, 9));
+
+    const MetricsSnapshot& m = ob.metrics();
+    const BookCounters& c = m.counters;
+    EXPECT_EQ(c.adds, 6u);
+    EXPECT_EQ(c.accepted, 4u);
+    EXPECT_EQ(c.cancels, 1u);
+    EXPECT_EQ(c.replaces, 1u);
+    EXPECT_EQ(c.rejects[static_cast<size_t>(RejectReason::BadPrice)], 1u);
+    EXPECT_EQ(c.rejects[static_cast<size_t>(RejectReason::DuplicateId)], 1u);
+    EXPECT_EQ(c.rejects[static_cast<size_t>(RejectReason::UnknownId)], 1u);
+    EXPECT_EQ(c.fills, 3u);
+    EXPECT_EQ(c.filled_qty, 25u);
+    EXPECT_EQ(c.aggressive, 1u);
+    EXPECT_EQ(c.levels_created, 3u);     // 10100, 10105, then 10110 on replace
+    EXPECT_EQ(c.levels_destroyed, 3u);
+
+    EXPECT_EQ(m.latency[static_cast<size_t>(BookOp::Add)].count(), 6u);
+    EXPECT_EQ(m.latency[static_cast<size_t>(BookOp::Cancel)].count(), 2u);
+    EXPECT_EQ(m.latency[static_cast<size_t>(BookOp::Replace)].count(), 1u);
+    EXPECT_EQ(m.latency[static_cast<size_t>(BookOp::Match)].count(), 5u);   // every accepted non-post-only add + the reprice
+    EXPECT_EQ(m.sweep_depth.count(), 1u);
+    EXPECT_EQ(m.sweep_depth.max(), 2u);
+
+    ob.reset_metrics();
+    EXPECT_EQ(ob.metrics().counters.adds, 0u);
+    EXPECT_EQ(ob.metrics().latency[0].count(), 0u);
+
+    // Compiled out: an uninstrumented book carries no metrics state.
+    static_assert(sizeof(OrderBook) < sizeof(InstrumentedOrderBook));
+    static_assert(std::is_empty_v<NoMetrics>);
+}
+
+namespace {
+// Consumer-side book rebuilt only from the event stream: L3 queues from the
+// Order* events, L2 levels from LevelUpdate.
+struct Mirror
+{
+    std::map<int64_t, std::list<std::pair<uint64_t, int64_t>>> queues[2];   // px -> FIFO of (id, qty)
+    std::map<int64_t, LevelView> l2[2];
+    size_t bad_positions = 0;
+
+    static int idx(Side s) { return s == Side::Buy ? 0 : 1; }
+
+    auto find(const Event& e)
+    {
+        auto& q = queues[idx(e.side)][e.px];
+        auto it = q.begin();
+        size_t pos = 0;
+        while (it != q.end() && it->first != e.id) { ++it; ++pos; }
+        bad_positions += it == q.end() || pos != e.orders;
+        return it;
+    }
+
+    void apply(const Event& e)
+    {
+        auto& q = queues[idx(e.side)];
+        switch (e.type) {
+            case EventType::OrderAdded:
+                bad_positions += q[e.px].size() != e.orders;
+                q[e.px].emplace_back(e.id, e.qty);
+                break;
+            case EventType::OrderReduced:
+                find(e)->second = e.qty;
+                break;
+            case EventType::OrderRemoved:
+                q[e.px].erase(find(e));
+                if (q[e.px].empty()) q.erase(e.px);
+                break;
+            case EventType::LevelUpdate:
+                if (e.orders == 0) l2[idx(e.side)].erase(e.px);
+                else l2[idx(e.side)][e.px] = LevelView{e.px, e.qty, e.orders};
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Best-first, like bids()/asks().
+    std::vector<LevelView> l3_levels(Side s) const
+    {
+        std::vector<LevelView> out;
+        for (const auto& [px, fifo] : queues[idx(s)]) {
+            int64_t qty = 0;
+            for (const auto& o : fifo) qty += o.second;
+            out.push_back(LevelView{px, qty, fifo.size()});
+        }
+        if (s == Side::Buy) std::reverse(out.begin(), out.end());
+        return out;
+    }
+
+    std::vector<LevelView> l2_levels(Side s) const
+    {
+        std::vector<LevelView> out;
+        for (const auto& [px, v] : l2[idx(s)]) out.push_back(v);
+        if (s == Side::Buy) std::reverse(out.begin(), out.end());
+        return out;
+    }
+};
+
+bool same_levels(const std::vector<LevelView>& a, const std::vector<LevelView>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].px != b[i].px || a[i].qty != b[i].qty || a[i].orders != b[i].orders) return false;
+    return true;
+}
+}
+
+TEST(Book, Mbo_MirrorStaysInSync) {
+    MboOrderBook ob("TEST", 1);
+    Mirror mirror;
+
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.05;
+    cfg.max_live = 2000;
+    gen::PoissonFlow flow(cfg, 11);
+    std::vector<OrderMsg> msgs(500);
+    std::vector<RejectReason> status(msgs.size());
+
+    for (int round = 0; round < 100; ++round) {
+        flow.fill(msgs);
+        ob.apply_batch(msgs, status);
+        ob.events().drain([&](const Event& e) { mirror.apply(e); });
+
+        const auto bids = ob.bids(1 << 20), asks = ob.asks(1 << 20);
+        ASSERT_TRUE(same_levels(mirror.l3_levels(Side::Buy), bids)) << "round " << round;
+        ASSERT_TRUE(same_levels(mirror.l3_levels(Side::Sell), asks)) << "round " << round;
+        ASSERT_TRUE(same_levels(mirror.l2_levels(Side::Buy), bids)) << "round " << round;
+        ASSERT_TRUE(same_levels(mirror.l2_levels(Side::Sell), asks)) << "round " << round;
+    }
+    EXPECT_EQ(mirror.bad_positions, 0u);
+
+    // Queue order too, not just totals.
+    for (const Side side : {Side::Buy, Side::Sell}) {
+        ob.for_each_level(side, [&](const Level& lvl) {
+            const auto& fifo = mirror.queues[Mirror::idx(side)].at(lvl.px);
+            auto it = fifo.begin();
+            for (const QueueEntry* e = lvl.head; e; e = e->next, ++it) {
+                ASSERT_NE(it, fifo.end());
+                EXPECT_EQ(it->first, e->id);
+                EXPECT_EQ(it->second, e->qty);
+            }
+        });
+    }
+}
+
+TEST(Book, Mbo_QueuePositions) {
+    MboOrderBook ob("TEST", 1);
+    for (uint64_t id = 1; id <= 4; ++id)
+        ASSERT_TRUE(ob.add(Order{id, Side::Buy, Type::Limit, TIF::Day, 10000, 10, static_cast<int64_t>(id), false}));
+    ob.events().clear();
+
+    auto last = [&](EventType t) {
+        Event out{};
+        ob.events().drain([&](const Event& e) { if (e.type == t) out = e; });
+        return out;
+    };
+
+    ASSERT_TRUE(ob.cancel(3, 10));
+    Event e = last(EventType::OrderRemoved);
+    EXPECT_EQ(e.id, 3u);
+    EXPECT_EQ(e.orders, 2u);
+    EXPECT_EQ(e.qty, 10);
+
+    ASSERT_TRUE(ob.replace(2, 10000, 4, 11));        // shrink keeps its place
+    e = last(EventType::OrderReduced);
+    EXPECT_EQ(e.id, 2u);
+    EXPECT_EQ(e.orders, 1u);
+    EXPECT_EQ(e.qty, 4);
+
+    ASSERT_TRUE(ob.replace(1, 10000, 20, 12));       // growing goes to the back
+    e = last(EventType::OrderAdded);
+    EXPECT_EQ(e.id, 1u);
+    EXPECT_EQ(e.orders, 2u);
+
+    ASSERT_TRUE(ob.add(Order{9, Side::Sell, Type::Market, TIF::IOC, 0, 6, 13, false}));
+    std::vector<Event> ev;
+    ob.events().drain([&](const Event& x) { ev.push_back(x); });
+    // Trade 2 (qty 4, filled out), trade 4 (2 of 10).
+    std::vector<EventType> types;
+    for (const Event& x : ev) types.push_back(x.type);
+    const std::vector<EventType> want = {EventType::Accept, EventType::Trade, EventType::OrderRemoved,
+                                         EventType::Trade, EventType::OrderReduced, EventType::LevelUpdate};
+    EXPECT_EQ(types, want);
+    EXPECT_EQ(ev[2].id, 2u);
+    EXPECT_EQ(ev[2].qty, 0);
+    EXPECT_EQ(ev[4].id, 4u);
+    EXPECT_EQ(ev[4].qty, 8);
+    EXPECT_EQ(ev[4].orders, 0u);
+
+    // Default books never emit order events.
+    OrderBook plain("TEST", 1);
+    ASSERT_TRUE(plain.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 10000, 10, 1, false}));
+    plain.events().drain([&](const Event& x) { EXPECT_NE(x.type, EventType::OrderAdded); });
+}
+
+TEST(Book, Stops_TriggerOnLastTradeAndCascade) {
+    OrderBook ob("TEST", 1);
+    auto stop = [](uint64_t id, Side s, Type t, int64_t stop_px, int64_t px, int64_t qty, int64_t ts) {
+        return Order{id, s, t, TIF::Day, px, qty, ts, false, stop_px, 0};
+    };
+
+    // Asks 101 x10, 102 x10, 103 x10; bids 99 x10, 98 x10.
+    for (uint64_t i = 0; i < 3; ++i)
+        ASSERT_TRUE(ob.add(Order{1 + i, Side::Sell, Type::Limit, TIF::Day, 101 + static_cast<int64_t>(i), 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::Day, 99, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{5, Side::Buy, Type::Limit, TIF::Day, 98, 10, 1, false}));
+
+    // No trade yet: nothing can trigger.
+    ASSERT_TRUE(ob.add(stop(10, Side::Buy, Type::Stop, 101, 0, 10, 2)));          // buy 10 at market from 101
+    ASSERT_TRUE(ob.add(stop(11, Side::Buy, Type::StopLimit, 102, 102, 15, 3)));   // buy 15 limit 102 from 102
+    ASSERT_TRUE(ob.add(stop(12, Side::Sell, Type::Stop, 98, 0, 5, 4)));
+    EXPECT_EQ(ob.stop_count(), 3u);
+    EXPECT_EQ(ob.order_count(), 5u);
+    EXPECT_FALSE(ob.add(stop(13, Side::Buy, Type::Stop, 0, 0, 5, 5)));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadPrice);
+    EXPECT_FALSE(ob.add(Order{12, Side::Buy, Type::Limit, TIF::Day, 97, 1, 5, false}));
+    EXPECT_EQ(ob.last_reject(), RejectReason::DuplicateId);
+    ob.events().clear();
+
+    // Trade at 101 releases 10, which lifts 102 and releases 11; 11 takes the
+    // rest of 102 and rests 6 at 102.
+    ASSERT_TRUE(ob.add(Order{20, Side::Buy, Type::Limit, TIF::IOC, 101, 1, 6, false}));
+    std::vector<Event> ev;
+    ob.events().drain([&](const Event& e) { ev.push_back(e); });
+    std::vector<uint64_t> triggered;
+    for (const Event& e : ev)
+        if (e.type == EventType::StopTriggered) triggered.push_back(e.id);
+    EXPECT_EQ(triggered, (std::vector<uint64_t>{10, 11}));
+    EXPECT_EQ(ob.last_trade_px(), 102);
+    EXPECT_EQ(ob.stop_count(), 1u);
+    auto asks = ob.asks(5);
+    ASSERT_EQ(asks.size(), 1u);
+    EXPECT_EQ(asks[0].px, 103);
+    auto bids = ob.bids(5);
+    ASSERT_EQ(bids.size(), 3u);
+    EXPECT_EQ(bids[0].px, 102);
+    EXPECT_EQ(bids[0].qty, 6);
+
+    // The sell stop is cancellable while pending, and its id is then free.
+    ASSERT_TRUE(ob.cancel(12, 7));
+    EXPECT_EQ(ob.stop_count(), 0u);
+    EXPECT_FALSE(ob.cancel(12, 8));
+
+    // A stop already through the last trade fires on arrival.
+    ASSERT_TRUE(ob.add(stop(12, Side::Sell, Type::Stop, 103, 0, 5, 9)));
+    EXPECT_EQ(ob.stop_count(), 0u);
+    EXPECT_EQ(ob.last_trade_px(), 102);
+    bids = ob.bids(5);
+    ASSERT_EQ(bids.size(), 3u);
+    EXPECT_EQ(bids[0].px, 102);
+    EXPECT_EQ(bids[0].qty, 1);
+}
+
+TEST(Book, Stops_ReleaseIsAcceptedAndCountedOnce) {
+    InstrumentedOrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{10, Side::Buy, Type::Stop, TIF::Day, 0, 4, 2, false, 101, 0}));
+    ASSERT_TRUE(ob.add(Order{20, Side::Buy, Type::Limit, TIF::IOC, 101, 1, 3, false}));   // trade at 101 fires 10
+
+    std::vector<EventType> seq;
+    ob.events().drain([&](const Event& e) { if (e.id == 10) seq.push_back(e.type); });
+    EXPECT_EQ(seq, (std::vector<EventType>{EventType::Accept, EventType::StopTriggered, EventType::Trade}));
+    EXPECT_EQ(ob.asks(1)[0].qty, 5);
+
+    const MetricsSnapshot& m = ob.metrics();
+    EXPECT_EQ(m.counters.adds, 3u);
+    EXPECT_EQ(m.counters.accepted, 3u);
+    EXPECT_EQ(m.latency[static_cast<size_t>(BookOp::Add)].count(), 3u);
+}
+
+TEST(Book, Iceberg_ReplenishesAtBackOfQueue) {
+    MboOrderBook ob("TEST", 1);
+    Mirror mirror;
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 100, 25, 1, false, 0, 10}));   // shows 10 of 25
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 100, 5, 2, false}));
+    EXPECT_EQ(ob.iceberg_count(), 1u);
+    auto asks = ob.asks(1);
+    EXPECT_EQ(asks[0].qty, 15);
+
+    // Takes the peak (10), then 2's 5, then 3 of the refilled peak.
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy, Type::Market, TIF::IOC, 0, 18, 3, false}));
+    std::vector<std::pair<uint64_t, int64_t>> fills;
+    ob.events().drain([&](const Event& e) {
+        mirror.apply(e);
+        if (e.type == EventType::Trade) fills.emplace_back(e.maker_id, e.qty);
+    });
+    EXPECT_EQ(fills, (std::vector<std::pair<uint64_t, int64_t>>{{1, 10}, {2, 5}, {1, 3}}));
+    asks = ob.asks(1);
+    ASSERT_EQ(asks.size(), 1u);
+    EXPECT_EQ(asks[0].qty, 7);
+    EXPECT_TRUE(same_levels(mirror.l3_levels(Side::Sell), ob.asks(5)));
+
+    // A newer order queues behind the refilled peak but ahead of the next one.
+    ASSERT_TRUE(ob.add(Order{4, Side::Sell, Type::Limit, TIF::Day, 100, 4, 4, false}));
+    ASSERT_TRUE(ob.add(Order{5, Side::Buy, Type::Market, TIF::IOC, 0, 12, 5, false}));
+    fills.clear();
+    ob.events().drain([&](const Event& e) {
+        mirror.apply(e);
+        if (e.type == EventType::Trade) fills.emplace_back(e.maker_id, e.qty);
+    });
+    EXPECT_EQ(fills, (std::vector<std::pair<uint64_t, int64_t>>{{1, 7}, {4, 4}, {1, 1}}));
+    EXPECT_TRUE(same_levels(mirror.l3_levels(Side::Sell), ob.asks(5)));
+    EXPECT_EQ(ob.iceberg_count(), 1u);
+
+    // Replace sets the total; cancel reports shown + hidden.
+    ASSERT_TRUE(ob.replace(1, 100, 30, 6));
+    EXPECT_EQ(ob.asks(1)[0].qty, 10);
+    ob.events().clear();
+    ASSERT_TRUE(ob.cancel(1, 7));
+    Event c{};
+    ob.events().drain([&](const Event& e) { if (e.type == EventType::Cancel) c = e; });
+    EXPECT_EQ(c.qty, 30);
+    EXPECT_EQ(ob.iceberg_count(), 0u);
+    EXPECT_EQ(ob.order_count(), 0u);
+}
+
+TEST(Book, AccountStp_Modes) {
+    auto setup = [](auto& ob) {
+        // Account 7 rests 10 then account 8 rests 10, both at 100.
+        ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 100, 10, 1, false, 0, 0, 7}));
+        ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 100, 10, 2, false, 0, 0, 8}));
+        ob.events().clear();
+    };
+    const Order taker{3, Side::Buy, Type::Limit, TIF::Day, 100, 15, 3, false, 0, 0, 7};
+
+    {   // cancel oldest: 1 goes, 2 fills 10, 5 rests
+        StpOrderBook<StpAction::CancelResting> ob("TEST", 1);
+        setup(ob);
+        ASSERT_TRUE(ob.add(taker));
+        EXPECT_EQ(ob.order_count(), 1u);
+        EXPECT_EQ(ob.bids(1)[0].qty, 5);
+    }
+    {   // cancel newest: nothing trades, the taker is dropped
+        StpOrderBook<StpAction::CancelIncoming> ob("TEST", 1);
+        setup(ob);
+        ASSERT_TRUE(ob.add(taker));
+        EXPECT_TRUE(ob.pop_trade().empty());
+        EXPECT_EQ(ob.order_count(), 2u);
+        EXPECT_TRUE(ob.bids(1).empty());
+    }
+    {   // cancel both
+        StpOrderBook<StpAction::CancelBoth> ob("TEST", 1);
+        setup(ob);
+        ASSERT_TRUE(ob.add(taker));
+        EXPECT_TRUE(ob.pop_trade().empty());
+        EXPECT_EQ(ob.order_count(), 1u);
+        EXPECT_EQ(ob.asks(1)[0].qty, 10);
+    }
+    {   // decrement: 10 off both (1 is gone), then 5 trades with 2
+        StpArrayOrderBook<StpAction::Decrement> ob("TEST", 1);
+        setup(ob);
+        ASSERT_TRUE(ob.add(taker));
+        std::vector<Event> ev;
+        ob.events().drain([&](const Event& e) { ev.push_back(e); });
+        ASSERT_GE(ev.size(), 3u);
+        EXPECT_EQ(ev[1].type, EventType::SelfTradePrevented);
+        EXPECT_EQ(ev[1].maker_id, 1u);
+        EXPECT_EQ(ev[1].qty, 10);
+        EXPECT_EQ(ev[2].type, EventType::Trade);
+        EXPECT_EQ(ev[2].maker_id, 2u);
+        EXPECT_EQ(ev[2].qty, 5);
+        EXPECT_EQ(ob.order_count(), 1u);
+        EXPECT_EQ(ob.asks(1)[0].qty, 5);
+        EXPECT_TRUE(ob.bids(1).empty());
+        EXPECT_EQ(ob.stp().account(7).position, 5);
+        EXPECT_EQ(ob.stp().account(7).open_sell, 0);
+        EXPECT_EQ(ob.stp().account(8).open_sell, 5);
+        EXPECT_EQ(ob.stp().account(8).position, -5);
+    }
+    {   // unassigned orders never self-trade check
+        StpOrderBook<> ob("TEST", 1);
+        ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 100, 10, 1, false}));
+        ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::Day, 100, 10, 2, false}));
+        EXPECT_EQ(ob.pop_trade().size(), 1u);
+    }
+}
+
+TEST(Book, AccountStp_FokSkipsOwnLiquidity) {
+    auto setup = [](auto& ob) {
+        // Account 8 rests 5 ahead of account 7's 10, both at 100.
+        ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 100, 5, 1, false, 0, 0, 8}));
+        ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 100, 10, 2, false, 0, 0, 7}));
+        ob.events().clear();
+    };
+    const Order fok{3, Side::Buy, Type::Limit, TIF::FOK, 100, 12, 3, false, 0, 0, 7};
+
+    {   // only 5 of the 15 is tradeable: rejected before anything fills
+        StpOrderBook<StpAction::CancelIncoming> ob("TEST", 1);
+        setup(ob);
+        EXPECT_FALSE(ob.add(fok));
+        EXPECT_TRUE(ob.pop_trade().empty());
+        EXPECT_EQ(ob.asks(1)[0].qty, 15);
+        EXPECT_EQ(ob.stp().account(7).position, 0);
+    }
+    {
+        StpOrderBook<StpAction::CancelBoth> ob("TEST", 1);
+        setup(ob);
+        EXPECT_FALSE(ob.add(fok));
+        EXPECT_EQ(ob.order_count(), 2u);
+    }
+    {
+        StpArrayOrderBook<StpAction::Decrement> ob("TEST", 1);
+        setup(ob);
+        EXPECT_FALSE(ob.add(fok));
+        EXPECT_EQ(ob.asks(1)[0].qty, 15);
+    }
+    {   // cancel oldest skips account 7's order and fills the 5 it can
+        StpOrderBook<StpAction::CancelResting> ob("TEST", 1);
+        setup(ob);
+        EXPECT_FALSE(ob.add(fok));
+        EXPECT_TRUE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::FOK, 100, 5, 4, false, 0, 0, 7}));
+        EXPECT_EQ(ob.stp().account(7).position, 5);
+    }
+    {   // fillable ahead of the own order: fills as usual
+        StpOrderBook<StpAction::CancelIncoming> ob("TEST", 1);
+        setup(ob);
+        EXPECT_TRUE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::FOK, 100, 5, 4, false, 0, 0, 7}));
+        EXPECT_EQ(ob.asks(1)[0].qty, 10);
+    }
+}
+
+TEST(Book, AccountStp_RejectsAccountsPastTheLimit) {
+    StpOrderBook<> ob("TEST", 1);
+    constexpr uint32_t max = AccountStp<StpAction::CancelIncoming>::max_accounts;
+    EXPECT_FALSE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 100, 10, 1, false, 0, 0, 0xFFFFFFFFu}));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadAccount);
+    EXPECT_FALSE(ob.add(Order{2, Side::Sell, Type::Stop, TIF::Day, 0, 10, 2, false, 90, 0, max}));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadAccount);
+    EXPECT_EQ(ob.stp().accounts(), 0u);
+    EXPECT_EQ(ob.order_count(), 0u);
+
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 100, 10, 3, false, 0, 0, max - 1}));
+    EXPECT_EQ(ob.stp().accounts(), size_t{max});
+    EXPECT_EQ(ob.stp().account(max - 1).open_sell, 10);
+}
+
+TEST(Book, LoadLevel_RefusesBadInputAndLeavesBookUnchanged) {
+    StpOrderBook<> ob("TEST", 5);
+    const RestingOrder bids[] = {{1, 4, 1, 7, TIF::Day, {}}, {2, 6, 2, 7, TIF::GTC, {}}};
+    ASSERT_EQ(ob.load_level(Side::Buy, 100, bids), RejectReason::None);
+
+    const RestingOrder dup_inside[] = {{3, 5, 3, 7, TIF::Day, {}}, {3, 5, 4, 7, TIF::Day, {}}};
+    EXPECT_EQ(ob.load_level(Side::Buy, 100, dup_inside), RejectReason::DuplicateId);
+    EXPECT_EQ(ob.load_level(Side::Buy, 95, dup_inside), RejectReason::DuplicateId);
+    const RestingOrder one[] = {{2, 5, 3, 0, TIF::Day, {}}};
+    EXPECT_EQ(ob.load_level(Side::Sell, 110, one), RejectReason::DuplicateId);
+
+    const RestingOrder fresh[] = {{9, 5, 3, 0, TIF::Day, {}}};
+    EXPECT_EQ(ob.load_level(Side::Sell, 100, fresh), RejectReason::WouldCross);
+    EXPECT_EQ(ob.load_level(Side::Sell, 103, fresh), RejectReason::BadPrice);
+    EXPECT_EQ(ob.load_level(Side::Sell, 0, fresh), RejectReason::BadPrice);
+    const RestingOrder no_qty[] = {{9, 0, 3, 0, TIF::Day, {}}};
+    EXPECT_EQ(ob.load_level(Side::Sell, 110, no_qty), RejectReason::BadQty);
+    const RestingOrder bad_acct[] = {{9, 5, 3, 0xFFFFFFFFu, TIF::Day, {}}};
+    EXPECT_EQ(ob.load_level(Side::Sell, 110, bad_acct), RejectReason::BadAccount);
+
+    EXPECT_EQ(ob.order_count(), 2u);
+    EXPECT_EQ(ob.level_count(Side::Buy), 1u);
+    EXPECT_EQ(ob.level_count(Side::Sell), 0u);
+    EXPECT_EQ(ob.bids(5)[0].qty, 10);
+    EXPECT_EQ(ob.stp().account(7).open_buy, 10);
+    EXPECT_FALSE(ob.cancel(3, 5));
+}
+
+TEST(Book, AccountStp_TalliesMatchBookUnderRandomFlow) {
+    StpOrderBook<StpAction::CancelResting> ob("TEST", 1);
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.1;
+    cfg.accounts = 16;
+    cfg.max_live = 2000;
+    gen::PoissonFlow flow(cfg, 5);
+    std::vector<OrderMsg> msgs(20000);
+    flow.fill(msgs);
+    std::vector<RejectReason> status(msgs.size());
+    ob.apply_batch(msgs, status);
+
+    // Resting qty per account from the book itself.
+    std::map<uint32_t, int64_t> open[2];
+    for (const Side side : {Side::Buy, Side::Sell})
+        ob.for_each_level(side, [&](const Level& lvl) {
+            for (const QueueEntry* e = lvl.head; e; e = e->next) open[side == Side::Sell][e->account] += e->qty;
+        });
+
+    int64_t net = 0, traded = 0;
+    for (uint32_t a = 0; a < ob.stp().accounts(); ++a) {
+        const AccountTally t = ob.stp().account(a);
+        EXPECT_EQ(t.open_buy, open[0][a]) << "account " << a;
+        EXPECT_EQ(t.open_sell, open[1][a]) << "account " << a;
+        net += t.position;
+        traded += t.traded;
+    }
+    EXPECT_EQ(net, 0);
+    int64_t filled = 0;
+    ob.events().drain([&](const Event& e) { if (e.type == EventType::Trade) filled += e.qty; });
+    EXPECT_EQ(traded, 2 * filled);
+    EXPECT_GT(filled, 0);
+}
+
+TEST(Book, Impact_EstimatesMatchExecution) {
+    OrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 101,  5, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 103, 20, 3, false}));
+    ASSERT_TRUE(ob.add(Order{4, Side::Buy,  Type::Limit, TIF::Day,  99,  8, 4, false}));
+
+    FillEstimate f = ob.fill_estimate(Side::Buy, 25);
+    EXPECT_EQ(f.qty, 25);
+    EXPECT_EQ(f.worst_px, 103);
+    EXPECT_EQ(f.levels, 2u);
+    EXPECT_DOUBLE_EQ(f.vwap(), (101.0 * 15 + 103.0 * 10) / 25);
+    EXPECT_EQ(ob.px_to_fill(Side::Buy, 15), 101);
+    EXPECT_EQ(ob.px_to_fill(Side::Buy, 36), 0);             // only 35 offered
+    EXPECT_EQ(ob.fill_estimate(Side::Buy, 36).qty, 35);
+    EXPECT_EQ(ob.qty_up_to(Side::Buy, 102), 15);
+    EXPECT_EQ(ob.qty_up_to(Side::Buy, 100), 0);
+    EXPECT_EQ(ob.qty_up_to(Side::Sell, 99), 8);
+    EXPECT_TRUE(std::isnan(ob.fill_estimate(Side::Sell, 0).vwap()));
+
+    // Same answers from a curve, and from actually sweeping a twin book.
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.05;
+    gen::PoissonFlow flow(cfg, 9);
+    std::vector<OrderMsg> msgs(20000);
+    flow.fill(msgs);
+    std::vector<RejectReason> status(msgs.size());
+    ArrayOrderBook a("TEST", 1), b("TEST", 1);
+    a.apply_batch(msgs, status);
+    b.apply_batch(msgs, status);
+    b.events().clear();
+
+    for (const Side side : {Side::Buy, Side::Sell}) {
+        const DepthCurve c = a.depth_curve(side);
+        ASSERT_EQ(c.levels(), a.level_count(opposite(side)));
+        for (int64_t q = 0; q <= c.total_qty() + 10; q += 97) {
+            const FillEstimate x = a.fill_estimate(side, q), y = c.fill(q);
+            EXPECT_EQ(x.qty, y.qty);
+            EXPECT_EQ(x.worst_px, y.worst_px);
+            EXPECT_EQ(x.levels, y.levels);
+            EXPECT_NEAR(x.notional, y.notional, 1e-6 * x.notional);
+            EXPECT_EQ(a.px_to_fill(side, q), c.px_to_fill(q));
+        }
+        for (const auto& l : side == Side::Buy ? a.asks(1000) : a.bids(1000))
+            EXPECT_EQ(a.qty_up_to(side, l.px), c.qty_up_to(l.px));
+    }
+
+    ASSERT_GT(a.level_count(Side::Sell), 1u);
+    const int64_t q = a.asks(1)[0].qty + 1;                 // into the second level
+    const FillEstimate est = a.fill_estimate(Side::Buy, q);
+    ASSERT_TRUE(b.add(Order{1'000'000'000, Side::Buy, Type::Market, TIF::IOC, 0, q, 1, false}));
+    int64_t filled = 0;
+    double notional = 0.0;
+    for (const Trade& t : b.pop_trade()) {
+        filled += t.qty;
+        notional += static_cast<double>(t.px) * static_cast<double>(t.qty);
+    }
+    EXPECT_EQ(filled, est.qty);
+    EXPECT_DOUBLE_EQ(notional, est.notional);
+    EXPECT_EQ(b.last_trade_px(), est.worst_px);
+}
+
+TEST(Book, Auction_UncrossAtMaxVolumeFifo) {
+    OrderBook ob("TEST", 1);
+    ob.begin_auction();
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy,  Type::Limit, TIF::Day, 102, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy,  Type::Limit, TIF::Day, 101, 10, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy,  Type::Limit, TIF::Day, 101,  5, 3, false}));
+    ASSERT_TRUE(ob.add(Order{4, Side::Sell, Type::Limit, TIF::Day,  99,  8, 4, false}));
+    ASSERT_TRUE(ob.add(Order{5, Side::Sell, Type::Limit, TIF::Day, 100, 12, 5, false}));
+    ASSERT_TRUE(ob.add(Order{6, Side::Sell, Type::Limit, TIF::Day, 103, 50, 6, false}));
+    EXPECT_FALSE(ob.add(Order{7, Side::Buy, Type::Market, TIF::IOC, 0, 5, 7, false}));
+    EXPECT_EQ(ob.last_reject(), RejectReason::Auction);
+    EXPECT_FALSE(ob.add(Order{8, Side::Buy, Type::Limit, TIF::IOC, 105, 5, 8, false}));
+    ASSERT_TRUE(ob.replace(3, 100, 5, 9));                  // reprices without trading
+    EXPECT_TRUE(ob.pop_trade().empty());
+    EXPECT_EQ(ob.bids(1)[0].px, 102);                       // crossed book
+    EXPECT_EQ(ob.asks(1)[0].px, 99);
+
+    // demand / supply: 99: 25/8, 100: 25/20, 101: 20/20, 102: 10/20
+    const AuctionResult r = ob.auction_price();
+    EXPECT_EQ(r.px, 101);
+    EXPECT_EQ(r.qty, 20);
+    EXPECT_EQ(r.imbalance, 0);
+    EXPECT_TRUE(ob.in_auction());
+
+    const AuctionResult u = ob.uncross(10);
+    EXPECT_EQ(u.px, r.px);
+    EXPECT_FALSE(ob.in_auction());
+    const auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 3u);
+    EXPECT_EQ(trades[0].taker_id, 1u); EXPECT_EQ(trades[0].maker_id, 4u); EXPECT_EQ(trades[0].qty, 8);
+    EXPECT_EQ(trades[1].taker_id, 1u); EXPECT_EQ(trades[1].maker_id, 5u); EXPECT_EQ(trades[1].qty, 2);
+    EXPECT_EQ(trades[2].taker_id, 2u); EXPECT_EQ(trades[2].maker_id, 5u); EXPECT_EQ(trades[2].qty, 10);
+    for (const Trade& t : trades) EXPECT_EQ(t.px, 101);
+    EXPECT_EQ(ob.last_trade_px(), 101);
+    EXPECT_EQ(ob.bids(1)[0].px, 100);                       // uncrossed
+    EXPECT_EQ(ob.asks(1)[0].px, 103);
+    EXPECT_EQ(ob.order_count(), 2u);
+
+    // Continuous again: this one trades on arrival.
+    ASSERT_TRUE(ob.add(Order{9, Side::Buy, Type::Market, TIF::IOC, 0, 5, 11, false}));
+    EXPECT_EQ(ob.pop_trade().size(), 1u);
+}
+
+TEST(Book, Auction_TieBreaks) {
+    using L = AuctionLevel;
+    // Same volume and surplus at 100 and 102, buyers left over at both -> highest.
+    const L b1[] = {{102, 10}};
+    const L a1[] = {{100, 5}};
+    AuctionResult r = equilibrium(b1, a1, 101);
+    EXPECT_EQ(r.qty, 5);
+    EXPECT_EQ(r.px, 102);
+    EXPECT_EQ(r.imbalance, 5);
+
+    // Mirror image: sellers left over -> lowest.
+    const L b2[] = {{102, 5}};
+    const L a2[] = {{100, 10}};
+    r = equilibrium(b2, a2, 101);
+    EXPECT_EQ(r.px, 100);
+    EXPECT_EQ(r.imbalance, -5);
+
+    // 101 and 102 both execute 10; 102 leaves nothing over, 101 one buyer.
+    const L b4[] = {{102, 10}, {101, 1}};
+    const L a4[] = {{100, 5}, {101, 5}};
+    r = equilibrium(b4, a4, 101);
+    EXPECT_EQ(r.qty, 10);
+    EXPECT_EQ(r.px, 102);
+    EXPECT_EQ(r.imbalance, 0);
+
+    // Balanced over 100..104: reference price decides, midpoint without one.
+    const L b3[] = {{104, 10}};
+    const L a3[] = {{100, 10}};
+    EXPECT_EQ(equilibrium(b3, a3, 103).px, 104);            // only level prices are candidates
+    EXPECT_EQ(equilibrium(b3, a3, 101).px, 100);
+    EXPECT_EQ(equilibrium(b3, a3, 0).px, 100);              // midpoint 102 is equidistant: lower
+    EXPECT_EQ(equilibrium(b3, a3, 0).qty, 10);
+
+    // Not crossed.
+    EXPECT_EQ(equilibrium({}, a3, 0).qty, 0);
+}
+
+TEST(Book, Auction_MatchesBruteForceUnderRandomFlow) {
+    gen::FlowConfig cfg;
+    cfg.max_live = 3000;
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        ArrayOrderBook ob("TEST", 1);
+        ob.begin_auction();
+        gen::PoissonFlow flow(cfg, seed);
+        std::vector<OrderMsg> msgs(5000);
+        flow.fill(msgs);
+        // Pull every limit through the mid so the book crosses deeply.
+        for (OrderMsg& m : msgs)
+            if (m.kind == static_cast<uint8_t>(MsgKind::Add) && m.type == static_cast<uint8_t>(Type::Limit))
+                m.px += (m.side == static_cast<uint8_t>(Side::Buy) ? 5 : -5);
+        std::vector<RejectReason> status(msgs.size());
+        ob.apply_batch(msgs, status);
+        ob.events().clear();
+
+        const auto bids = ob.bids(1 << 20), asks = ob.asks(1 << 20);
+        int64_t best = 0;
+        for (int64_t p = asks.front().px - 1; p <= bids.front().px + 1; ++p) {
+            int64_t d = 0, s = 0;
+            for (const auto& l : bids) d += l.px >= p ? l.qty : 0;
+            for (const auto& l : asks) s += l.px <= p ? l.qty : 0;
+            best = std::max(best, std::min(d, s));
+        }
+        const AuctionResult r = ob.auction_price();
+        ASSERT_GT(best, 0);
+        EXPECT_EQ(r.qty, best) << "seed " << seed;
+
+        ob.uncross(1);
+        int64_t filled = 0;
+        ob.events().drain([&](const Event& e) {
+            if (e.type != EventType::Trade) return;
+            filled += e.qty;
+            EXPECT_EQ(e.px, r.px);
+        });
+        EXPECT_EQ(filled, r.qty);
+        ASSERT_FALSE(ob.bids(1).empty() || ob.asks(1).empty());
+        EXPECT_LT(ob.bids(1)[0].px, ob.asks(1)[0].px);
+    }
+}
+
+TEST(Book, Gtd_ExpiresOnAdvanceTime) {
+    OrderBook ob("TEST", 1, BookConfig{.expiry_tick_ns = 1000});
+    auto gtd = [](uint64_t id, Side side, int64_t px, int64_t qty, int64_t expire_ns) {
+        return Order{.id = id, .side = side, .type = Type::Limit, .tif = TIF::GTD, .px = px, .qty = qty, .expire_ns = expire_ns};
+    };
+    ASSERT_TRUE(ob.add(gtd(1, Side::Buy, 100, 10, 5'500)));
+    ASSERT_TRUE(ob.add(gtd(2, Side::Buy, 100, 20, 5'000)));
+    ASSERT_TRUE(ob.add(gtd(3, Side::Sell, 105, 5, 3'600'000'000'000)));    // an hour out: top level
+    ASSERT_TRUE(ob.add(gtd(4, Side::Sell, 106, 5, 86'400'000'000'000)));   // a day out: far list
+    ASSERT_TRUE(ob.add(Order{5, Side::Buy, Type::Limit, TIF::GTC, 99, 7, 0, false}));
+    EXPECT_EQ(ob.expiry_count(), 4u);
+    ob.events().clear();
+
+    EXPECT_EQ(ob.advance_time(4'999), 0u);
+    EXPECT_EQ(ob.advance_time(5'000), 1u);          // same tick as id 1, which is not due yet
+    std::vector<Event> evs;
+    ob.events().drain([&](const Event& e) { evs.push_back(e); });
+    ASSERT_EQ(evs.size(), 2u);
+    EXPECT_EQ(evs[0].type, EventType::Expire);
+    EXPECT_EQ(evs[0].id, 2u);
+    EXPECT_EQ(evs[0].qty, 20);
+    EXPECT_EQ(evs[1].type, EventType::LevelUpdate);
+    EXPECT_EQ(evs[1].qty, 10);
+
+    // A GTD must expire after the book's time; a reprice keeps the expiry.
+    EXPECT_FALSE(ob.add(gtd(6, Side::Buy, 98, 1, 5'000)));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadExpiry);
+    ASSERT_TRUE(ob.replace(1, 101, 10, 5'100));
+    EXPECT_EQ(ob.advance_time(5'499), 0u);
+    EXPECT_EQ(ob.advance_time(5'500), 1u);
+    EXPECT_TRUE(ob.bids(5).size() == 1 && ob.bids(5)[0].px == 99);
+
+    // A cancelled GTD leaves the wheel; the far ones fire when their time comes.
+    ASSERT_TRUE(ob.cancel(3, 6'000));
+    EXPECT_EQ(ob.expiry_count(), 1u);
+    EXPECT_EQ(ob.advance_time(86'399'999'999'999), 0u);
+    EXPECT_EQ(ob.advance_time(86'400'000'000'000), 1u);
+    EXPECT_EQ(ob.expiry_count(), 0u);
+    EXPECT_EQ(ob.order_count(), 1u);                // only the GTC is left
+    EXPECT_TRUE(ob.asks(5).empty());
+}
+
+// Random GTD expiries from one tick to days ahead, advanced in random
+// steps: each advance must expire exactly the orders a sorted reference
+// says are due, and nothing else.
+TEST(Book, Gtd_WheelMatchesReferenceOverLongHorizons) {
+    std::mt19937_64 rng(11);
+    ArrayOrderBook ob("TEST", 1, BookConfig{.expiry_tick_ns = 1'000});
+    std::multimap<int64_t, uint64_t> due;               // expire_ns -> id
+    int64_t now = 0;
+    uint64_t next = 1;
+    for (int step = 0; step < 4000; ++step) {
+        const int adds = static_cast<int>(rng() % 8);
+        for (int k = 0; k < adds; ++k) {
+            const int64_t ahead = 1 + static_cast<int64_t>(rng() % (int64_t{1} << (rng() % 48)));
+            const Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            const int64_t px = side == Side::Buy ? 900 + static_cast<int64_t>(rng() % 50) : 1000 + static_cast<int64_t>(rng() % 50);
+            ASSERT_TRUE(ob.add(Order{.id = next, .side = side, .type = Type::Limit, .tif = TIF::GTD, .px = px,
+                                     .qty = 1, .ts_ns = now, .expire_ns = now + ahead}));
+            due.emplace(now + ahead, next++);
+        }
+        if (rng() % 5 == 0 && !due.empty()) {           // cancel one
+            auto it = due.begin();
+            std::advance(it, static_cast<long>(rng() % due.size()));
+            ASSERT_TRUE(ob.cancel(it->second, now));
+            due.erase(it);
+        }
+        now += static_cast<int64_t>(rng() % (int64_t{1} << (rng() % 44)));
+        ob.events().clear();
+        const size_t fired = ob.advance_time(now);
+        std::vector<uint64_t> want, got;
+        while (!due.empty() && due.begin()->first <= now) {
+            want.push_back(due.begin()->second);
+            due.erase(due.begin());
+        }
+        ob.events().drain([&](const Event& e) { if (e.type == EventType::Expire) got.push_back(e.id); });
+        std::sort(want.begin(), want.end());
+        std::sort(got.begin(), got.end());
+        ASSERT_EQ(fired, got.size());
+        ASSERT_EQ(got, want) << "step " << step << " now " << now;
+        ASSERT_EQ(ob.expiry_count(), due.size());
+    }
+    EXPECT_EQ(ob.order_count(), due.size());
+}
+
+// A GTD order carries an OrderExt for its expiry but is not an iceberg:
+// growing and shrinking it must keep all of it displayed.
+TEST(Book, Gtd_ReplaceKeepsPlainOrderDisplayed) {
+    OrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{.id = 1, .side = Side::Sell, .type = Type::Limit, .tif = TIF::GTD, .px = 100, .qty = 10, .ts_ns = 1, .expire_ns = 1000}));
+    ASSERT_TRUE(ob.replace(1, 100, 20, 2));
+    ASSERT_EQ(ob.asks(1).size(), 1u);
+    EXPECT_EQ(ob.asks(1)[0].qty, 20);
+    EXPECT_EQ(ob.iceberg_count(), 0u);
+    ASSERT_TRUE(ob.replace(1, 100, 15, 3));
+    EXPECT_EQ(ob.asks(1)[0].qty, 15);
+    ob.events().clear();
+
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::IOC, 100, 40, 4, false}));
+    const auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].qty, 15);
+    EXPECT_EQ(ob.order_count(), 0u);
+    EXPECT_EQ(ob.expiry_count(), 0u);
+}
+
+TEST(Book, BulkCancel_DaySideAndBeyond) {
+    MboOrderBook ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::GTC, 100, 20, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy, Type::Limit, TIF::Day, 100, 30, 3, false}));
+    ASSERT_TRUE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::PostOnly, 99, 40, 4, false}));
+    ASSERT_TRUE(ob.add(Order{.id = 5, .side = Side::Buy, .type = Type::Limit, .tif = TIF::GTD, .px = 98, .qty = 50, .ts_ns = 5, .expire_ns = 1000}));
+    ASSERT_TRUE(ob.add(Order{.id = 6, .side = Side::Sell, .type = Type::Limit, .tif = TIF::Day, .px = 105, .qty = 60, .ts_ns = 6, .display_qty = 10}));
+    ASSERT_TRUE(ob.add(Order{7, Side::Sell, Type::Limit, TIF::GTC, 106, 70, 7, false}));
+    ASSERT_TRUE(ob.add(Order{8, Side::Sell, Type::Limit, TIF::Day, 107, 80, 8, false}));
+    ob.events().clear();
+
+    // Day orders go (PostOnly rests as Day, the iceberg with its hidden qty),
+    // GTC and GTD stay; one LevelUpdate per level touched.
+    EXPECT_EQ(ob.cancel_day(10), 5u);
+    std::vector<Event> evs;
+    ob.events().drain([&](const Event& e) { evs.push_back(e); });
+    std::vector<std::pair<EventType, uint64_t>> seq;
+    for (const Event& e : evs) seq.emplace_back(e.type, e.type == EventType::LevelUpdate ? static_cast<uint64_t>(e.px) : e.id);
+    const std::vector<std::pair<EventType, uint64_t>> want{
+        {EventType::Cancel, 1}, {EventType::OrderRemoved, 1}, {EventType::Cancel, 3}, {EventType::OrderRemoved, 3},
+        {EventType::LevelUpdate, 100},
+        {EventType::Cancel, 4}, {EventType::OrderRemoved, 4}, {EventType::LevelUpdate, 99},
+        {EventType::Cancel, 6}, {EventType::OrderRemoved, 6}, {EventType::LevelUpdate, 105},
+        {EventType::Cancel, 8}, {EventType::OrderRemoved, 8}, {EventType::LevelUpdate, 107},
+    };
+    EXPECT_EQ(seq, want);
+    EXPECT_EQ(evs[3].orders, 1u);                   // id 3 left from behind id 2
+    EXPECT_EQ(evs[8].qty, 60);                      // shown plus hidden
+    EXPECT_EQ(ob.order_count(), 3u);
+    EXPECT_EQ(ob.iceberg_count(), 0u);
+    EXPECT_EQ(ob.level_count(Side::Buy), 2u);
+    EXPECT_EQ(ob.level_count(Side::Sell), 1u);
+
+    // At or beyond a price: bids at or below 99 (the GTD leaves the wheel).
+    ASSERT_TRUE(ob.add(Order{9, Side::Buy, Type::Limit, TIF::GTC, 97, 5, 11, false}));
+    EXPECT_EQ(ob.cancel_beyond(Side::Buy, 99, 12), 2u);
+    EXPECT_EQ(ob.expiry_count(), 0u);
+    ASSERT_EQ(ob.bids(5).size(), 1u);
+    EXPECT_EQ(ob.bids(5)[0].px, 100);
+    EXPECT_EQ(ob.cancel_beyond(Side::Sell, 107, 13), 0u);
+    EXPECT_EQ(ob.cancel_side(Side::Sell, 14), 1u);
+    EXPECT_TRUE(ob.asks(5).empty());
+    EXPECT_EQ(ob.order_count(), 1u);
+
+    // The index is consistent: ids can be reused, the survivor still cancels.
+    EXPECT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 1, 15, false}));
+    EXPECT_TRUE(ob.cancel(2, 16));
+    EXPECT_FALSE(ob.cancel(3, 17));
+}
+
+// The bulk paths (level drops, index sweep) must leave the same book, and
+// report the same cancels, as cancelling the same orders one at a time.
+template <class Book>
+static void bulk_cancel_matches_one_by_one()
+{
+    gen::FlowConfig cfg;
+    cfg.max_live = 4000;
+    for (uint64_t seed = 1; seed <= 4; ++seed) {
+        Book bulk("TEST", 1), single("TEST", 1);
+        gen::PoissonFlow flow(cfg, seed);
+        std::vector<OrderMsg> msgs(8000);
+        flow.fill(msgs);
+        std::mt19937_64 rng(seed);
+        for (OrderMsg& m : msgs)
+            if (m.kind == static_cast<uint8_t>(MsgKind::Add) && m.tif == static_cast<uint8_t>(TIF::Day) && rng() % 3 == 0)
+                m.tif = static_cast<uint8_t>(TIF::GTC);
+        std::vector<RejectReason> status(msgs.size());
+        bulk.apply_batch(msgs, status);
+        single.apply_batch(msgs, status);
+        const int64_t mid = (bulk.bids(1)[0].px + bulk.asks(1)[0].px) / 2;
+
+        // Orders the next operation will take, one by one on `single`.
+        auto take = [&](auto pred, int64_t ts) {
+            std::vector<uint64_t> ids;
+            for (const Side side : {Side::Buy, Side::Sell})
+                single.for_each_level(side, [&](const Level& lvl) {
+                    for (const QueueEntry* e = lvl.head; e; e = e->next) if (pred(*e)) ids.push_back(e->id);
+                });
+            for (uint64_t id : ids) EXPECT_TRUE(single.cancel(id, ts));
+            return ids;
+        };
+        auto cancelled = [](Book& ob) {
+            std::vector<uint64_t> ids;
+            ob.events().drain([&](const Event& e) { if (e.type == EventType::Cancel) ids.push_back(e.id); });
+            std::sort(ids.begin(), ids.end());
+            return ids;
+        };
+        auto same_book = [&] {
+            for (const Side side : {Side::Buy, Side::Sell}) {
+                std::vector<std::pair<uint64_t, int64_t>> a, b;
+                bulk.for_each_level(side, [&](const Level& l) { for (auto* e = l.head; e; e = e->next) a.emplace_back(e->id, l.px); });
+                single.for_each_level(side, [&](const Level& l) { for (auto* e = l.head; e; e = e->next) b.emplace_back(e->id, l.px); });
+                EXPECT_EQ(a, b) << "seed " << seed;
+                EXPECT_EQ(bulk.level_count(side), single.level_count(side));
+            }
+            EXPECT_EQ(bulk.order_count(), single.order_count());
+        };
+        bulk.events().clear();
+        single.events().clear();
+
+        auto ids = take([&](const QueueEntry& e) { return e.side == Side::Sell && e.level->px >= mid + 3; }, 1);
+        EXPECT_EQ(bulk.cancel_beyond(Side::Sell, mid + 3, 1), ids.size());
+        std::sort(ids.begin(), ids.end());
+        EXPECT_EQ(cancelled(bulk), ids);
+        single.events().clear();
+        same_book();
+
+        ids = take([](const QueueEntry& e) { return e.tif == TIF::Day; }, 2);
+        EXPECT_EQ(bulk.cancel_day(2), ids.size());
+        std::sort(ids.begin(), ids.end());
+        EXPECT_EQ(cancelled(bulk), ids);
+        single.events().clear();
+        same_book();
+
+        ids = take([](const QueueEntry& e) { return e.side == Side::Buy; }, 3);
+        EXPECT_EQ(bulk.cancel_side(Side::Buy, 3), ids.size());
+        same_book();
+
+        // both books keep trading identically afterwards
+        bulk.events().clear();
+        single.events().clear();
+        std::vector<RejectReason> s1(msgs.size()), s2(msgs.size());
+        bulk.apply_batch(msgs, s1);
+        single.apply_batch(msgs, s2);
+        EXPECT_EQ(s1, s2);
+        same_book();
+    }
+}
+
+TEST(Book, BulkCancel_MatchesOneByOneUnderRandomFlow_Map) { bulk_cancel_matches_one_by_one<OrderBook>(); }
+TEST(Book, BulkCancel_MatchesOneByOneUnderRandomFlow_Array) { bulk_cancel_matches_one_by_one<ArrayOrderBook>(); }
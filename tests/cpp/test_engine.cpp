@@ -0,0 +1,206 @@
+#include "engine/engine.hpp"
+#include "engine/mpsc_queue.hpp"
+#include "engine/scenarios.hpp"
+#include "engine/work_stealing.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(MpscQueue, ManyProducersEveryItemOnceInPerProducerOrder) {
+    MpscQueue<uint64_t> q(1024);
+    constexpr int kProducers = 4;
+    constexpr uint64_t kPer = 50000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (uint64_t i = 0; i < kPer; ++i) {
+                const uint64_t v = (static_cast<uint64_t>(p) << 32) | i;
+                while (!q.try_push(v)) std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(kProducers, 0);
+    uint64_t got = 0, v = 0;
+    while (got < kProducers * kPer) {
+        if (!q.try_pop(v)) continue;
+        const auto p = static_cast<size_t>(v >> 32);
+        ASSERT_EQ(v & 0xffffffffu, next[p]);
+        ++next[p];
+        ++got;
+    }
+    for (auto& t : producers) t.join();
+    EXPECT_FALSE(q.try_pop(v));
+}
+
+// The same per-symbol message streams through the engine and through plain
+// single-threaded books must leave identical books behind.
+TEST(Engine, ShardedBooksMatchSingleThreadedReplay) {
+    EngineConfig cfg;
+    cfg.workers = 3;
+    cfg.pin_threads = false;
+    cfg.queue_capacity = 256;
+
+    std::vector<std::atomic<uint64_t>> trades(16);
+    Engine eng(cfg, [&](uint32_t sym, EventRing& ev) {
+        ev.drain([&](const Event& e) {
+            if (e.type == EventType::Trade) trades[sym].fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+
+    std::vector<OrderBook> ref;
+    ref.reserve(16);
+    for (int s = 0; s < 16; ++s) {
+        const std::string name = "SYM" + std::to_string(s);
+        EXPECT_EQ(eng.add_symbol(name, 1), static_cast<uint32_t>(s));
+        ref.emplace_back(name, 1);
+    }
+    EXPECT_EQ(eng.symbol_id("SYM3"), 3);
+    EXPECT_EQ(eng.symbol_id("nope"), -1);
+
+    std::mt19937_64 rng(11);
+    std::vector<Command> cmds;
+    std::vector<std::vector<uint64_t>> live(16);
+    uint64_t next_id = 1;
+    for (int i = 0; i < 60000; ++i) {
+        Command c;
+        c.symbol = static_cast<uint32_t>(rng() % 16);
+        auto& ids = live[c.symbol];
+        const int roll = static_cast<int>(rng() % 10);
+        if (roll < 6 || ids.empty()) {
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            const int64_t px = 1000 + static_cast<int64_t>(rng() % 21) - 10;
+            c.kind = CmdKind::Add;
+            c.o = Order{next_id, side, Type::Limit, TIF::Day, px, 1 + static_cast<int64_t>(rng() % 9), i, false};
+            ids.push_back(next_id++);
+        } else if (roll < 9) {
+            c.kind = CmdKind::Cancel;
+            c.o.id = ids[rng() % ids.size()];
+        } else {
+            c.kind = CmdKind::Replace;
+            c.o.id = ids[rng() % ids.size()];
+            c.o.px = 1000 + static_cast<int64_t>(rng() % 21) - 10;
+            c.o.qty = 1 + static_cast<int64_t>(rng() % 9);
+        }
+        cmds.push_back(c);
+    }
+
+    eng.start();
+    for (const auto& c : cmds) eng.submit(c);
+    eng.stop();
+    EXPECT_EQ(eng.processed(), cmds.size());
+
+    std::vector<uint64_t> ref_trades(16, 0);
+    for (const auto& c : cmds) {
+        OrderBook& ob = ref[c.symbol];
+        switch (c.kind) {
+            case CmdKind::Add:     ob.add(c.o); break;
+            case CmdKind::Cancel:  ob.cancel(c.o.id, c.o.ts_ns); break;
+            case CmdKind::Replace: ob.replace(c.o.id, c.o.px, c.o.qty, c.o.ts_ns); break;
+        }
+        ref_trades[c.symbol] += ob.pop_trade().size();
+    }
+
+    for (uint32_t s = 0; s < 16; ++s) {
+        EXPECT_EQ(trades[s].load(), ref_trades[s]);
+        auto a = eng.book(s).bids(50), b = ref[s].bids(50);
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t k = 0; k < a.size(); ++k) {
+            EXPECT_EQ(a[k].px, b[k].px);
+            EXPECT_EQ(a[k].qty, b[k].qty);
+        }
+        auto x = eng.book(s).asks(50), y = ref[s].asks(50);
+        ASSERT_EQ(x.size(), y.size());
+        for (size_t k = 0; k < x.size(); ++k) {
+            EXPECT_EQ(x[k].px, y[k].px);
+            EXPECT_EQ(x[k].qty, y[k].qty);
+        }
+    }
+}
+
+TEST(Engine, SubmitRejectsUnknownSymbol) {
+    EngineConfig cfg;
+    cfg.workers = 2;
+    cfg.pin_threads = false;
+    Engine eng(cfg);
+    eng.add_symbol("A", 1);
+    eng.start();
+
+    Command c;
+    c.symbol = 1;
+    c.kind = CmdKind::Add;
+    c.o = {.id = 1, .side = Side::Buy, .px = 100, .qty = 1};
+    EXPECT_THROW(eng.try_submit(c), std::out_of_range);
+    EXPECT_THROW(eng.submit(c), std::out_of_range);
+    c.symbol = 0;
+    EXPECT_TRUE(eng.try_submit(c));
+    eng.stop();
+    EXPECT_EQ(eng.processed(), 1u);
+}
+
+TEST(WorkStealingPool, EveryTaskOnceUnderUnevenLoad) {
+    WorkStealingPool pool(4);
+    constexpr size_t kTasks = 97;
+    std::vector<std::atomic<int>> runs(kTasks);
+    std::vector<std::atomic<int>> by_worker(pool.threads());
+    pool.run(kTasks, [&](size_t t, size_t w) {
+        // Worker 0's initial block is by far the slowest: the others must steal it.
+        if (t < kTasks / 4) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        runs[t].fetch_add(1);
+        by_worker[w].fetch_add(1);
+    });
+    for (size_t t = 0; t < kTasks; ++t) EXPECT_EQ(runs[t].load(), 1) << "task " << t;
+    int total = 0;
+    for (auto& n : by_worker) total += n.load();
+    EXPECT_EQ(total, static_cast<int>(kTasks));
+
+    EXPECT_THROW(pool.run(10, [](size_t t, size_t) { if (t == 3) throw std::runtime_error("boom"); }),
+                 std::runtime_error);
+}
+
+TEST(Scenarios, ResultsIndependentOfThreadCount) {
+    std::vector<Scenario> sc(6);
+    for (size_t i = 0; i < sc.size(); ++i) {
+        sc[i].seed = 100 + i;
+        sc[i].messages = 20000;
+        sc[i].flow.marketable_frac = 0.02 * static_cast<double>(i);
+        sc[i].array_ladder = i % 2;
+        sc[i].latency = i % 3 == 0;
+    }
+    const ScenarioResults one = run_scenarios(sc, 1);
+    const ScenarioResults many = run_scenarios(sc, 4);
+    ASSERT_EQ(one.size(), sc.size());
+    ASSERT_EQ(many.size(), sc.size());
+    for (size_t i = 0; i < sc.size(); ++i) {
+        EXPECT_EQ(one.trades[i], many.trades[i]);
+        EXPECT_EQ(one.volume[i], many.volume[i]);
+        EXPECT_EQ(one.accepted[i], many.accepted[i]);
+        EXPECT_EQ(one.resting[i], many.resting[i]);
+        EXPECT_EQ(one.spread_p50[i], many.spread_p50[i]);
+        EXPECT_DOUBLE_EQ(one.spread_mean[i], many.spread_mean[i]);
+        EXPECT_DOUBLE_EQ(one.vwap[i], many.vwap[i]);
+        EXPECT_EQ(std::isnan(one.add_p50_ns[i]), !sc[i].latency);
+    }
+    // More marketable flow trades more.
+    EXPECT_GT(one.trades[5], one.trades[0]);
+    EXPECT_GT(one.two_sided[0], 0.5);
+
+    // Cross-check one row against a hand-driven book.
+    OrderBook ob("SIM", 1);
+    gen::PoissonFlow flow(sc[0].flow, sc[0].seed);
+    std::vector<OrderMsg> msgs(sc[0].messages);
+    flow.fill(msgs);
+    std::vector<RejectReason> status(msgs.size());
+    ob.apply_batch(msgs, status);
+    uint64_t trades = 0;
+    ob.events().drain([&](const Event& e) { trades += e.type == EventType::Trade; });
+    EXPECT_EQ(one.trades[0], trades);
+    EXPECT_EQ(one.resting[0], ob.order_count());
+}
@@ -0,0 +1,111 @@
+#include "gen/poisson.hpp"
+#include "gen/random_walk.hpp"
+#include "ob/book.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+TEST(Gen, SameSeedSameStream_BulkMatchesNext) {
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.05;
+    gen::PoissonFlow a(cfg, 42), b(cfg, 42), c(cfg, 43);
+
+    std::vector<OrderMsg> bulk(20000);
+    a.fill(bulk);
+    bool differs = false;
+    for (const OrderMsg& m : bulk) {
+        const OrderMsg x = b.next();
+        ASSERT_EQ(std::memcmp(&m, &x, sizeof(OrderMsg)), 0);
+        const OrderMsg y = c.next();
+        differs |= std::memcmp(&m, &y, sizeof(OrderMsg)) != 0;
+    }
+    EXPECT_TRUE(differs);
+}
+
+TEST(Gen, PoissonRatesAndWellFormedMessages) {
+    gen::FlowConfig cfg;
+    cfg.cancel_rate = 0.0;
+    cfg.replace_rate = 0.0;
+    cfg.size_dist = gen::SizeDist::Uniform;
+    cfg.size_min = 5;
+    cfg.size_max = 10;
+    gen::PoissonFlow flow(cfg, 7);
+
+    constexpr size_t n = 200000;
+    size_t limits = 0, markets = 0, buys = 0;
+    int64_t prev_ts = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const OrderMsg m = flow.next();
+        ASSERT_EQ(m.kind, static_cast<uint8_t>(MsgKind::Add));
+        ASSERT_GE(m.ts_ns, prev_ts);
+        ASSERT_GE(m.qty, 5);
+        ASSERT_LE(m.qty, 10);
+        prev_ts = m.ts_ns;
+        if (m.type == static_cast<uint8_t>(Type::Market)) ++markets;
+        else ++limits;
+        if (m.side == static_cast<uint8_t>(Side::Buy)) ++buys;
+    }
+
+    // 84k msgs/sec in total: elapsed time and the type/side split should be
+    // within a few percent of the configured rates.
+    const double secs = static_cast<double>(flow.now_ns()) * 1e-9;
+    EXPECT_NEAR(static_cast<double>(n) / secs, 84000.0, 84000.0 * 0.02);
+    EXPECT_NEAR(static_cast<double>(markets) / n, 4000.0 / 84000.0, 0.005);
+    EXPECT_NEAR(static_cast<double>(buys) / n, 0.5, 0.01);
+    EXPECT_EQ(limits + markets, n);
+}
+
+TEST(Gen, CancelsAndReplacesTargetLiveIds_DriveBook) {
+    gen::FlowConfig cfg;
+    gen::PoissonFlow flow(cfg, 3);
+    std::vector<OrderMsg> msgs(100000);
+    flow.fill(msgs);
+
+    std::unordered_set<uint64_t> live;
+    size_t cancels = 0, replaces = 0;
+    for (const OrderMsg& m : msgs) {
+        switch (static_cast<MsgKind>(m.kind)) {
+            case MsgKind::Add:
+                if (m.type == static_cast<uint8_t>(Type::Limit)) {
+                    ASSERT_GT(m.px, 0);
+                    live.insert(m.id);
+                }
+                break;
+            case MsgKind::Cancel:
+                ASSERT_EQ(live.erase(m.id), 1u);
+                ++cancels;
+                break;
+            case MsgKind::Replace:
+                ASSERT_TRUE(live.count(m.id));
+                ++replaces;
+                break;
+        }
+    }
+    EXPECT_GT(cancels, 0u);
+    EXPECT_GT(replaces, 0u);
+    EXPECT_EQ(live.size(), flow.live());
+
+    OrderBook ob("GEN", 1);
+    std::vector<RejectReason> status(msgs.size());
+    EXPECT_GT(ob.apply_batch(msgs, status), msgs.size() / 2);
+    EXPECT_FALSE(ob.bids(1).empty());
+    EXPECT_FALSE(ob.asks(1).empty());
+}
+
+TEST(Gen, RandomWalkStaysOnGridAboveFloor) {
+    gen::WalkConfig cfg;
+    cfg.start_px = 50;
+    cfg.tick = 5;
+    cfg.floor_px = 10;
+    cfg.moves_per_sec = 1000.0;
+    cfg.drift = -0.2;
+    gen::RandomWalk walk(cfg, 9);
+
+    for (int i = 0; i < 10000; ++i) {
+        const int64_t px = walk.advance(1'000'000);
+        ASSERT_EQ(px % 5, 0);
+        ASSERT_GE(px, 10);
+    }
+    EXPECT_LT(walk.mid(), 100);
+}
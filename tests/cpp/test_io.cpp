@@ -0,0 +1,568 @@
+#include "gen/poisson.hpp"
+#include "io/csv.hpp"
+#include "io/journal.hpp"
+#include "io/snapshot.hpp"
+#include "io/sqlite.hpp"
+#include "ob/book.hpp"
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string tmp_path(const char* name)
+{
+    return ::testing::TempDir() + "obsim_" + name;
+}
+
+static std::string slurp(const std::string& path)
+{
+    std::ifstream f(path);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+TEST(Csv, GtdRowsAndExpireEvents) {
+    const std::string path = tmp_path("gtd.csv");
+    OrderBook ob("CSV", 1);
+    ob.add(Order{.id = 1, .side = Side::Buy, .type = Type::Limit, .tif = TIF::GTD, .px = 100, .qty = 4, .ts_ns = 10, .expire_ns = 50});
+    ob.events().clear();
+    ob.advance_time(60);
+    {
+        io::CsvWriter w(path);
+        w.raw(io::kEventHeader);
+        ob.events().drain([&](const Event& e) { w.write(e); });
+    }
+    EXPECT_EQ(slurp(path),
+              "ts_ns,type,id,maker_id,side,px,qty,orders,reason\n"
+              "60,expire,1,0,B,100,4,0,0\n"
+              "60,level,0,0,B,100,0,0,0\n");
+
+    {
+        io::CsvWriter w(path);
+        w.raw(io::kOrderHeader);
+        w.write(add_msg(Order{.id = 2, .side = Side::Sell, .type = Type::Limit, .tif = TIF::GTD, .px = 101, .qty = 3, .ts_ns = 70}));
+    }
+    EXPECT_EQ(slurp(path), std::string(io::kOrderHeader) + "70,A,2,S,L,T,101,3\n");
+    io::CsvOrderReader r(path);
+    std::vector<OrderMsg> back(4);
+    ASSERT_EQ(r.read(back), 1u);
+    EXPECT_EQ(back[0].tif, static_cast<uint8_t>(TIF::GTD));
+    std::remove(path.c_str());
+}
+
+TEST(Csv, OrdersRoundTripAcrossChunks) {
+    const std::string path = tmp_path("orders.csv");
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.1;
+    gen::PoissonFlow flow(cfg, 5);
+    std::vector<OrderMsg> msgs(50000);
+    flow.fill(msgs);
+    {
+        io::CsvWriter w(path, 4096);    // small buffer: many flushes
+        w.raw(io::kOrderHeader);
+        for (const OrderMsg& m : msgs) w.write(m);
+    }
+
+    io::CsvOrderReader r(path);
+    std::vector<OrderMsg> back;
+    std::vector<OrderMsg> chunk(777);
+    for (size_t n; (n = r.read(chunk)) != 0;) back.insert(back.end(), chunk.begin(), chunk.begin() + n);
+
+    EXPECT_EQ(r.bad_lines(), 0u);
+    EXPECT_EQ(r.lines(), msgs.size() + 1);
+    ASSERT_EQ(back.size(), msgs.size());
+    for (size_t i = 0; i < msgs.size(); ++i) {
+        const OrderMsg& a = msgs[i];
+        const OrderMsg& b = back[i];
+        ASSERT_EQ(a.kind, b.kind);
+        ASSERT_EQ(a.id, b.id);
+        ASSERT_EQ(a.ts_ns, b.ts_ns);
+        if (a.kind == static_cast<uint8_t>(MsgKind::Cancel)) continue;
+        ASSERT_EQ(a.px, b.px);
+        ASSERT_EQ(a.qty, b.qty);
+        if (a.kind == static_cast<uint8_t>(MsgKind::Add)) {
+            ASSERT_EQ(a.side, b.side);
+            ASSERT_EQ(a.type, b.type);
+            ASSERT_EQ(a.tif, b.tif);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(Csv, EveryOrderTypeKeepsItsCode) {
+    const std::string path = tmp_path("types.csv");
+    {
+        io::CsvWriter w(path);
+        for (uint8_t t = 0; t <= 4; ++t) {   // Limit, Market, Stop, StopLimit, then a bad byte
+            OrderMsg m = add_msg(Order{t + 1u, Side::Buy, Type::Limit, TIF::Day, 100, 1, t, false});
+            m.type = t;
+            w.write(m);
+        }
+    }
+    {
+        std::ifstream f(path);
+        std::string line;
+        std::string types;
+        while (std::getline(f, line)) {
+            size_t at = 0;
+            for (int field = 0; field < 4; ++field) at = line.find(',', at) + 1;   // ts,kind,id,side,[type]
+            types += line[at];
+        }
+        EXPECT_EQ(types, "LMST?");
+    }
+
+    io::CsvOrderReader r(path);
+    std::vector<OrderMsg> back(8);
+    ASSERT_EQ(r.read(back), 4u);
+    EXPECT_EQ(r.bad_lines(), 1u);   // '?' is refused, not read back as a limit
+    for (uint8_t t = 0; t < 4; ++t) EXPECT_EQ(back[t].type, t);
+    std::remove(path.c_str());
+}
+
+TEST(Csv, SkipsBadRowsHandlesCrLfAndMissingNewline) {
+    const std::string path = tmp_path("bad.csv");
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << "1,A,1,S,L,D,100,5\r\n"
+             "2,X,2,S,L,D,100,5\n"          // bad kind
+             "\n"
+             "3,A,3,B,L,I,abc,5\n"          // bad px
+             "4,C,1,,,,,\n"
+             "5,A,4,B,L,P,99,7,extra\n"     // too many fields
+             "6,A,5,B,M,I,,9";
+    }
+    io::CsvOrderReader r(path);
+    std::vector<OrderMsg> got;
+    r.for_each([&](const OrderMsg& m) { got.push_back(m); });
+
+    EXPECT_EQ(r.bad_lines(), 3u);
+    ASSERT_EQ(got.size(), 3u);
+    EXPECT_EQ(got[0].px, 100);
+    EXPECT_EQ(got[0].side, static_cast<uint8_t>(Side::Sell));
+    EXPECT_EQ(got[1].kind, static_cast<uint8_t>(MsgKind::Cancel));
+    EXPECT_EQ(got[1].id, 1u);
+    EXPECT_EQ(got[2].type, static_cast<uint8_t>(Type::Market));
+    EXPECT_EQ(got[2].qty, 9);
+    EXPECT_TRUE(r.done());
+    std::remove(path.c_str());
+}
+
+TEST(Csv, TradeAndEventRows) {
+    const std::string path = tmp_path("trades.csv");
+    OrderBook ob("CSV", 1);
+    ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 5, 10, false});
+    ob.add(Order{2, Side::Buy, Type::Limit, TIF::IOC, 101, 3, 20, false});
+    {
+        io::CsvWriter w(path);
+        w.raw(io::kEventHeader);
+        ob.events().drain([&](const Event& e) { w.write(e); });
+        w.write(Trade{2, 1, 101, 3, 20, true});
+        EXPECT_GT(w.bytes_written(), 0u);
+    }
+    EXPECT_EQ(slurp(path),
+              "ts_ns,type,id,maker_id,side,px,qty,orders,reason\n"
+              "10,accept,1,0,S,101,5,0,0\n"
+              "10,level,0,0,S,101,5,1,0\n"
+              "20,accept,2,0,B,101,3,0,0\n"
+              "20,trade,2,1,B,101,3,0,0\n"
+              "20,level,0,0,S,101,2,1,0\n"
+              "20,2,1,101,3,B\n");
+    std::remove(path.c_str());
+}
+
+// Record a run through io::Recorder, replay the journal into a fresh book and
+// require the identical event stream, field for field.
+TEST(Journal, ReplayReproducesEventStreamExactly) {
+    const std::string path = tmp_path("run.journal");
+    gen::FlowConfig fcfg;
+    fcfg.marketable_frac = 0.1;
+    gen::PoissonFlow flow(fcfg, 21);
+    std::vector<OrderMsg> msgs(60000);
+    flow.fill(msgs);
+
+    std::vector<Event> live;
+    auto collect = [](std::vector<Event>& into) {
+        return [&into](EventRing& ev) { ev.drain([&](const Event& e) { into.push_back(e); }); };
+    };
+    {
+        OrderBook ob("JRNL", 1);
+        io::JournalWriter w(path, ob.symbol(), ob.tick(), 1000);
+        io::Recorder rec(ob, w);
+        // First half one call at a time, second half in batches.
+        const size_t half = msgs.size() / 2;
+        for (size_t i = 0; i < half; ++i) {
+            const OrderMsg& m = msgs[i];
+            switch (static_cast<MsgKind>(m.kind)) {
+                case MsgKind::Add:     rec.add(to_order(m)); break;
+                case MsgKind::Cancel:  rec.cancel(m.id, m.ts_ns); break;
+                case MsgKind::Replace: rec.replace(m.id, m.px, m.qty, m.ts_ns); break;
+            }
+            collect(live)(ob.events());
+        }
+        std::vector<RejectReason> status(msgs.size());
+        rec.apply_batch(std::span(msgs).subspan(half), status);
+        collect(live)(ob.events());
+        EXPECT_EQ(w.records(), msgs.size());
+    }
+
+    io::Journal j(path);
+    EXPECT_EQ(j.symbol(), "JRNL");
+    EXPECT_EQ(j.tick(), 1);
+    ASSERT_EQ(j.size(), msgs.size());
+    EXPECT_EQ(std::memcmp(j.records().data(), msgs.data(), msgs.size() * sizeof(OrderMsg)), 0);
+
+    std::vector<Event> replayed;
+    OrderBook again(std::string(j.symbol()), j.tick());
+    io::replay(j, again, collect(replayed));
+    ASSERT_EQ(replayed.size(), live.size());
+    for (size_t i = 0; i < live.size(); ++i) {
+        const Event& a = live[i];
+        const Event& b = replayed[i];
+        ASSERT_TRUE(a.type == b.type && a.reason == b.reason && a.side == b.side && a.id == b.id &&
+                    a.maker_id == b.maker_id && a.px == b.px && a.qty == b.qty && a.ts_ns == b.ts_ns &&
+                    a.orders == b.orders) << "event " << i;
+    }
+    std::remove(path.c_str());
+}
+
+TEST(Journal, RejectsForeignFilesAndIgnoresTornTail) {
+    const std::string path = tmp_path("torn.journal");
+    {
+        io::JournalWriter w(path, "X", 5);
+        w.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 100, 1, 1, false});
+        w.cancel(1, 2);
+    }
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::app);
+        f << "partial";
+    }
+    io::Journal j(path);
+    EXPECT_EQ(j.size(), 2u);
+    EXPECT_EQ(j.tick(), 5);
+    EXPECT_EQ(j.records()[1].kind, static_cast<uint8_t>(MsgKind::Cancel));
+
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << std::string(100, 'x');
+    }
+    EXPECT_THROW(io::Journal{path}, std::runtime_error);
+    EXPECT_THROW(io::JournalWriter(path, std::string(40, 'S'), 1), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+// Orders an OrderMsg cannot represent are refused before the book sees them.
+TEST(Journal, RefusesOrdersTheRecordCannotHold) {
+    const std::string path = tmp_path("refuse.journal");
+    {
+        OrderBook ob("X", 1);
+        io::JournalWriter w(path, ob.symbol(), ob.tick());
+        io::Recorder rec(ob, w);
+        EXPECT_THROW(rec.add(Order{.id = 1, .side = Side::Buy, .type = Type::Stop, .qty = 5, .stop_px = 101}), std::invalid_argument);
+        EXPECT_THROW(rec.add(Order{.id = 2, .side = Side::Sell, .type = Type::Limit, .px = 101, .qty = 50, .display_qty = 10}),
+                     std::invalid_argument);
+        EXPECT_THROW(rec.add(Order{.id = 4, .side = Side::Buy, .type = Type::Limit, .tif = TIF::GTD, .px = 99, .qty = 1, .expire_ns = 10}),
+                     std::invalid_argument);
+        EXPECT_EQ(ob.expiry_count(), 0u);
+        EXPECT_TRUE(rec.add(Order{3, Side::Buy, Type::Limit, TIF::Day, 100, 1, 1, false}));
+        EXPECT_EQ(ob.stop_count(), 0u);
+        EXPECT_EQ(ob.order_count(), 1u);
+        EXPECT_EQ(w.records(), 1u);
+    }
+    std::remove(path.c_str());
+}
+
+template <class Book>
+static std::vector<std::vector<RestingOrder>> queues(const Book& ob, Side side)
+{
+    std::vector<std::vector<RestingOrder>> out;
+    ob.for_each_level(side, [&](const Level& l) {
+        out.emplace_back();
+        for (const QueueEntry* e = l.head; e; e = e->next) out.back().push_back({e->id, e->qty, e->ts_ns, e->account, e->tif, {}});
+        out.back().push_back({0, l.px, static_cast<int64_t>(l.total_qty()), 0, TIF::Day, {}});    // level marker
+    });
+    return out;
+}
+
+static bool same(const std::vector<std::vector<RestingOrder>>& a, const std::vector<std::vector<RestingOrder>>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].size() != b[i].size()) return false;
+        for (size_t k = 0; k < a[i].size(); ++k)
+            if (a[i][k].id != b[i][k].id || a[i][k].qty != b[i][k].qty || a[i][k].ts_ns != b[i][k].ts_ns ||
+                a[i][k].account != b[i][k].account || a[i][k].tif != b[i][k].tif) return false;
+    }
+    return true;
+}
+
+// Snapshot mid-run, restore, replay the rest of the journal from the stored
+// offset: queues, FIFO order, timestamps and later events must all match a
+// book that never stopped.
+template <class Book>
+static void snapshot_round_trip(const char* tag)
+{
+    const std::string snap = tmp_path((std::string(tag) + ".snap").c_str());
+    gen::FlowConfig fcfg;
+    fcfg.marketable_frac = 0.05;
+    gen::PoissonFlow flow(fcfg, 17);
+    std::vector<OrderMsg> msgs(80000);
+    flow.fill(msgs);
+    const std::span<const OrderMsg> all(msgs);
+    const size_t cut = 50000;
+
+    Book ob("SNAP", 1);
+    io::replay(all.first(cut), ob);
+    ASSERT_GT(ob.order_count(), 100u);
+    io::save_snapshot(ob, snap, cut);
+
+    io::SnapshotInfo info;
+    Book back = io::load_snapshot<Book>(snap, BookConfig{}, &info);
+    EXPECT_EQ(info.symbol, "SNAP");
+    EXPECT_EQ(info.journal_offset, cut);
+    EXPECT_EQ(info.orders, ob.order_count());
+    EXPECT_EQ(back.order_count(), ob.order_count());
+    EXPECT_TRUE(back.events().empty());
+    EXPECT_TRUE(same(queues(ob, Side::Buy), queues(back, Side::Buy)));
+    EXPECT_TRUE(same(queues(ob, Side::Sell), queues(back, Side::Sell)));
+
+    std::vector<Event> a, b;
+    io::replay(all.subspan(info.journal_offset), ob, [&](EventRing& ev) { ev.drain([&](const Event& e) { a.push_back(e); }); });
+    io::replay(all.subspan(info.journal_offset), back, [&](EventRing& ev) { ev.drain([&](const Event& e) { b.push_back(e); }); });
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i)
+        ASSERT_TRUE(a[i].type == b[i].type && a[i].id == b[i].id && a[i].maker_id == b[i].maker_id &&
+                    a[i].px == b[i].px && a[i].qty == b[i].qty && a[i].orders == b[i].orders) << "event " << i;
+    EXPECT_TRUE(same(queues(ob, Side::Buy), queues(back, Side::Buy)));
+    std::remove(snap.c_str());
+}
+
+TEST(Snapshot, RestorePreservesFifoAndResumesFromJournalOffset_Map) { snapshot_round_trip<OrderBook>("map"); }
+TEST(Snapshot, RestorePreservesFifoAndResumesFromJournalOffset_Array) { snapshot_round_trip<ArrayOrderBook>("array"); }
+
+TEST(Snapshot, TruncatedFileThrows) {
+    const std::string snap = tmp_path("trunc.snap");
+    OrderBook ob("T", 1);
+    for (uint64_t i = 1; i <= 10; ++i) ob.add(Order{i, Side::Buy, Type::Limit, TIF::Day, 100, 1, 0, false});
+    io::save_snapshot(ob, snap);
+    ASSERT_EQ(::truncate(snap.c_str(), 96 + 16 + 5 * 32), 0);
+    EXPECT_THROW(io::load_snapshot<OrderBook>(snap), std::runtime_error);
+    std::remove(snap.c_str());
+}
+
+// Hand-corrupted copies of a small valid snapshot (tick 5): bid level at 96
+// holding ids 1, 2 (records at 112, 144), ask level at 176 holding id 3
+// (record at 192). Every one must be refused, not half-loaded.
+TEST(Snapshot, CorruptFilesThrow) {
+    const std::string good = tmp_path("good.snap"), bad = tmp_path("bad.snap");
+    OrderBook ob("C", 5);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 100, 4, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::Day, 100, 6, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 110, 5, 3, false}));
+    io::save_snapshot(ob, good);
+    const std::string bytes = slurp(good);
+    ASSERT_EQ(bytes.size(), 224u);
+    ASSERT_NO_THROW(io::load_snapshot<OrderBook>(good));
+
+    struct Patch { const char* what; size_t off; int64_t v; size_t len; };
+    const Patch patches[] = {
+        {"bid level side 2",         108, 2,   1},
+        {"ask level marked bid",     188, 0,   1},
+        {"duplicate id in a level",  144, 1,   8},
+        {"duplicate id across",      192, 2,   8},
+        {"ask at the bid",           176, 100, 8},
+        {"ask through the bid",      176, 95,  8},
+        {"zero px",                   96, 0,   8},
+        {"negative px",               96, -100, 8},
+        {"off-tick px",               96, 101, 8},
+        {"zero qty",                 120, 0,   8},
+        {"negative qty",             152, -3,  8},
+        {"empty level",              104, 0,   4},
+        {"zero tick",                 16, 0,   8},
+        {"header order count",        64, int64_t{1} << 40, 8},
+    };
+    for (const Patch& pt : patches) {
+        std::string b = bytes;
+        std::memcpy(b.data() + pt.off, &pt.v, pt.len);
+        std::ofstream(bad, std::ios::binary) << b;
+        EXPECT_THROW(io::load_snapshot<OrderBook>(bad), std::runtime_error) << pt.what;
+    }
+    std::remove(good.c_str());
+    std::remove(bad.c_str());
+}
+
+// A map book may span more ticks than an ArrayLadder will grow to; the
+// restore refuses it rather than growing the window past max_ticks.
+TEST(Snapshot, WideBookRespectsArrayLadderCap) {
+    const std::string snap = tmp_path("wide.snap");
+    OrderBook ob("W", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 500'000, 1, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::Day, 100, 1, 2, false}));     // 499'900 ticks below
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 500'001, 1, 3, false}));
+    io::save_snapshot(ob, snap);
+
+    BookConfig cfg;
+    cfg.ladder.ticks = 64;
+    cfg.ladder.max_ticks = 1024;
+    EXPECT_THROW(io::load_snapshot<ArrayOrderBook>(snap, cfg), std::runtime_error);
+    cfg.ladder.max_ticks = size_t{1} << 21;
+    EXPECT_EQ(io::load_snapshot<ArrayOrderBook>(snap, cfg).order_count(), 3u);
+    std::remove(snap.c_str());
+}
+
+TEST(Snapshot, KeepsTheLastTradePrice) {
+    const std::string snap = tmp_path("last.snap");
+    OrderBook ob("L", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::IOC, 101, 4, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy, Type::Limit, TIF::Day, 99, 5, 3, false}));
+    ASSERT_EQ(ob.last_trade_px(), 101);
+    io::save_snapshot(ob, snap);
+
+    io::SnapshotInfo info;
+    auto back = io::load_snapshot<OrderBook>(snap, BookConfig{}, &info);
+    EXPECT_EQ(info.last_px, 101);
+    EXPECT_EQ(back.last_trade_px(), 101);
+
+    // A sell stop at 102 is already through the last trade: it fires on
+    // arrival in both books and hits the bid at 99.
+    for (OrderBook* b : {&ob, &back}) {
+        b->events().clear();
+        ASSERT_TRUE(b->add(Order{4, Side::Sell, Type::Stop, TIF::Day, 0, 2, 4, false, 102, 0}));
+        EXPECT_EQ(b->stop_count(), 0u);
+        EXPECT_EQ(b->bids(1)[0].qty, 3);
+    }
+    std::remove(snap.c_str());
+}
+
+TEST(Snapshot, RestoresAccountsAndTallies) {
+    const std::string snap = tmp_path("acct.snap");
+    StpOrderBook<> ob("A", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Sell, Type::Limit, TIF::Day, 101, 10, 1, false, 0, 0, 7}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 101, 4, 2, false, 0, 0, 8}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Buy, Type::Limit, TIF::Day, 99, 6, 3, false}));
+    io::save_snapshot(ob, snap);
+
+    auto back = io::load_snapshot<StpOrderBook<>>(snap);
+    EXPECT_TRUE(same(queues(ob, Side::Sell), queues(back, Side::Sell)));
+    EXPECT_TRUE(same(queues(ob, Side::Buy), queues(back, Side::Buy)));
+    EXPECT_EQ(back.stp().account(7).open_sell, 10);
+    EXPECT_EQ(back.stp().account(8).open_sell, 4);
+
+    // Self-trade prevention still applies to restored orders: account 7
+    // cancels itself instead of taking its own 10.
+    ASSERT_TRUE(back.add(Order{4, Side::Buy, Type::Limit, TIF::Day, 101, 3, 4, false, 0, 0, 7}));
+    EXPECT_TRUE(back.pop_trade().empty());
+    EXPECT_EQ(back.asks(1)[0].qty, 14);
+    std::remove(snap.c_str());
+}
+
+TEST(Snapshot, GtcOrdersSurviveTheSessionEnd) {
+    const std::string snap = tmp_path("gtc.snap");
+    OrderBook ob("G", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::GTC, 99, 5, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::Day, 99, 7, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 101, 3, 3, false}));
+    io::save_snapshot(ob, snap);
+
+    auto back = io::load_snapshot<OrderBook>(snap);
+    EXPECT_TRUE(same(queues(ob, Side::Buy), queues(back, Side::Buy)));
+    EXPECT_EQ(back.cancel_day(10), 2u);
+    EXPECT_EQ(back.order_count(), 1u);
+    ASSERT_EQ(back.bids(1).size(), 1u);
+    EXPECT_EQ(back.bids(1)[0].qty, 5);
+    std::remove(snap.c_str());
+}
+
+static int64_t query_int(sqlite3* db, const char* sql)
+{
+    sqlite3_stmt* s = nullptr;
+    EXPECT_EQ(sqlite3_prepare_v2(db, sql, -1, &s, nullptr), SQLITE_OK);
+    int64_t v = -1;
+    if (sqlite3_step(s) == SQLITE_ROW) v = sqlite3_column_int64(s, 0);
+    sqlite3_finalize(s);
+    return v;
+}
+
+TEST(Sqlite, TradesAndSnapshotsLandInWalDatabase) {
+    const std::string path = tmp_path("sink.db");
+    std::remove(path.c_str());
+
+    gen::FlowConfig fcfg;
+    fcfg.marketable_frac = 0.2;
+    gen::PoissonFlow flow(fcfg, 13);
+    std::vector<OrderMsg> msgs(100000);
+    flow.fill(msgs);
+
+    OrderBook ob("SQL", 1);
+    uint64_t trades = 0;
+    int64_t qty = 0;
+    size_t snapshot_rows = 0;
+    {
+        io::SqliteConfig cfg;
+        cfg.queue_capacity = 1024;      // small: exercise producer back-pressure
+        cfg.batch_rows = 5000;
+        cfg.snapshot_depth = 2;         // below the depth asked for: the level buffer grows once
+        io::SqliteSink sink(path, cfg);
+
+        std::vector<RejectReason> status(1000);
+        for (size_t i = 0; i < msgs.size(); i += 1000) {
+            ob.apply_batch(std::span(msgs).subspan(i, 1000), status);
+            for (size_t k = 0; k < ob.events().size(); ++k) {
+                const Event& e = ob.events()[k];
+                if (e.type == EventType::Trade) { ++trades; qty += e.qty; }
+            }
+            sink.write_trades(ob.events());
+            sink.snapshot(ob, 5, msgs[i + 999].ts_ns);
+            snapshot_rows += ob.bids(5).size() + ob.asks(5).size();
+        }
+        sink.flush();
+        EXPECT_FALSE(sink.failed()) << sink.error();
+        EXPECT_EQ(sink.committed(), trades + snapshot_rows);
+    }
+    ASSERT_GT(trades, 0u);
+
+    sqlite3* db = nullptr;
+    ASSERT_EQ(sqlite3_open(path.c_str(), &db), SQLITE_OK);
+    EXPECT_EQ(query_int(db, "SELECT COUNT(*) FROM trades"), static_cast<int64_t>(trades));
+    EXPECT_EQ(query_int(db, "SELECT SUM(qty) FROM trades"), qty);
+    EXPECT_EQ(query_int(db, "SELECT COUNT(*) FROM book_levels"), static_cast<int64_t>(snapshot_rows));
+    EXPECT_EQ(query_int(db, "SELECT COUNT(*) FROM book_levels WHERE level = 0 AND side = 0"), 100);
+    const auto bids = ob.bids(5), asks = ob.asks(5);
+    const std::string last = "SELECT px FROM book_levels WHERE ts_ns = " + std::to_string(msgs.back().ts_ns);
+    EXPECT_EQ(query_int(db, (last + " AND side = 0 AND level = 0").c_str()), bids.front().px);
+    EXPECT_EQ(query_int(db, (last + " AND side = 1 AND level = " + std::to_string(asks.size() - 1)).c_str()),
+              asks.back().px);
+    sqlite3_stmt* s = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(db, "PRAGMA journal_mode", -1, &s, nullptr), SQLITE_OK);
+    ASSERT_EQ(sqlite3_step(s), SQLITE_ROW);
+    EXPECT_STREQ(reinterpret_cast<const char*>(sqlite3_column_text(s, 0)), "wal");
+    sqlite3_finalize(s);
+    sqlite3_close(db);
+
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+TEST(Sqlite, BadPathThrows) {
+    EXPECT_THROW(io::SqliteSink("/nonexistent-dir/x.db"), std::runtime_error);
+}
+
+TEST(Sqlite, UnknownSynchronousLevelThrows) {
+    const std::string path = tmp_path("sync.db");
+    io::SqliteConfig cfg;
+    cfg.synchronous = "NORMAL; DROP TABLE trades";
+    EXPECT_THROW(io::SqliteSink(path, cfg), std::invalid_argument);
+    cfg.synchronous = "normal";
+    EXPECT_THROW(io::SqliteSink(path, cfg), std::invalid_argument);
+    cfg.synchronous = "FULL";
+    EXPECT_NO_THROW(io::SqliteSink(path, cfg));
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
@@ -0,0 +1,165 @@
+#include "ob/book.hpp"
+#include "ob/ladder.hpp"
+#include "ob/order.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+TEST(Ladder, ArrayBestCursorFollowsInsertsAndErases) {
+    ArrayLadder<Side::Buy> bids(1, LadderConfig{10000, 64});
+    ArrayLadder<Side::Sell> asks(1, LadderConfig{10000, 64});
+
+    bids.get_or_create(9990);
+    bids.get_or_create(9995);
+    bids.get_or_create(9980);
+    asks.get_or_create(10010);
+    asks.get_or_create(10005);
+
+    ASSERT_EQ(bids.best()->px, 9995);
+    ASSERT_EQ(asks.best()->px, 10005);
+
+    bids.erase(bids.find(9995));
+    asks.erase(asks.find(10005));
+    EXPECT_EQ(bids.best()->px, 9990);
+    EXPECT_EQ(asks.best()->px, 10010);
+
+    std::vector<int64_t> seen;
+    bids.for_each([&](const Level& l) { seen.push_back(l.px); return true; });
+    EXPECT_EQ(seen, (std::vector<int64_t>{9990, 9980}));
+}
+
+TEST(Ladder, ArrayRecentersAndGrowsOutsideWindow) {
+    ArrayOrderBook ob("TEST", 5, BookConfig{LadderConfig{10000, 64}});
+
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy,  Type::Limit, TIF::Day, 10000, 10, 1, false}));
+    // Far outside a 64-tick window in both directions.
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy,  Type::Limit, TIF::Day,  5000, 10, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 20000, 10, 3, false}));
+
+    auto bs = ob.bids(5);
+    ASSERT_EQ(bs.size(), 2u);
+    EXPECT_EQ(bs[0].px, 10000);
+    EXPECT_EQ(bs[1].px, 5000);
+
+    // Node back-pointers survive the move: cancel and replace still work.
+    EXPECT_TRUE(ob.cancel(1, 4));
+    EXPECT_TRUE(ob.replace(2, 5000, 4, 5));
+    bs = ob.bids(5);
+    ASSERT_EQ(bs.size(), 1u);
+    EXPECT_EQ(bs[0].qty, 4);
+
+    ASSERT_TRUE(ob.add(Order{4, Side::Buy, Type::Market, TIF::IOC, 0, 10, 6, false}));
+    auto trades = ob.pop_trade();
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].px, 20000);
+}
+
+TEST(Ladder, ArrayWindowStopsGrowingAtMaxTicks) {
+    LadderConfig lc{10000, 64};
+    lc.max_ticks = 256;
+    ArrayOrderBook ob("TEST", 1, BookConfig{lc});
+
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 10000, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy, Type::Limit, TIF::Day, 9900, 10, 2, false}));
+    // Spanning 128 ticks would need a 512-tick window.
+    EXPECT_FALSE(ob.add(Order{3, Side::Buy, Type::Limit, TIF::Day, 10127, 10, 3, false}));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadPrice);
+    EXPECT_FALSE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::Day, 1'000'000'000, 10, 4, false}));
+    EXPECT_FALSE(ob.replace(2, 9000, 10, 5));
+    EXPECT_EQ(ob.last_reject(), RejectReason::BadPrice);
+    EXPECT_EQ(ob.order_count(), 2u);
+
+    // 127 ticks still fits; the other side has its own window.
+    ASSERT_TRUE(ob.add(Order{5, Side::Buy, Type::Limit, TIF::Day, 10026, 10, 6, false}));
+    ASSERT_TRUE(ob.add(Order{6, Side::Sell, Type::Limit, TIF::Day, 50000, 10, 7, false}));
+    EXPECT_EQ(ob.bids(5).size(), 3u);
+
+    // Orders that never rest are not limited by the window.
+    EXPECT_TRUE(ob.add(Order{7, Side::Buy, Type::Limit, TIF::IOC, 1'000'000'000, 10, 8, false}));
+    EXPECT_EQ(ob.pop_trade().size(), 1u);
+}
+
+// Drive both ladder types with the same random flow and compare snapshots.
+TEST(Ladder, ArrayMatchesMapUnderRandomFlow) {
+    OrderBook      map_book("TEST", 1);
+    ArrayOrderBook arr_book("TEST", 1, BookConfig{LadderConfig{0, 128}});
+
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> ids;
+    uint64_t next_id = 1;
+    int64_t mid = 10000;
+
+    for (int i = 0; i < 20000; ++i) {
+        const int roll = static_cast<int>(rng() % 10);
+        mid += static_cast<int64_t>(rng() % 5) - 2;
+        if (roll < 6 || ids.empty()) {
+            const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+            const int64_t off = static_cast<int64_t>(rng() % 40);
+            const int64_t px = side == Side::Buy ? mid - off + 5 : mid + off - 5;
+            Order o{next_id, side, Type::Limit, TIF::Day, px, 1 + static_cast<int64_t>(rng() % 50), i, false};
+            ASSERT_EQ(map_book.add(o), arr_book.add(o));
+            ids.push_back(next_id++);
+        } else if (roll < 9) {
+            const uint64_t id = ids[rng() % ids.size()];
+            ASSERT_EQ(map_book.cancel(id, i), arr_book.cancel(id, i));
+        } else {
+            const uint64_t id = ids[rng() % ids.size()];
+            const int64_t px = mid + static_cast<int64_t>(rng() % 21) - 10;
+            const int64_t qty = 1 + static_cast<int64_t>(rng() % 50);
+            ASSERT_EQ(map_book.replace(id, px, qty, i), arr_book.replace(id, px, qty, i));
+        }
+
+        auto mb = map_book.bids(10), ab = arr_book.bids(10);
+        auto ma = map_book.asks(10), aa = arr_book.asks(10);
+        ASSERT_EQ(mb.size(), ab.size());
+        ASSERT_EQ(ma.size(), aa.size());
+        for (size_t k = 0; k < mb.size(); ++k) {
+            ASSERT_EQ(mb[k].px, ab[k].px);
+            ASSERT_EQ(mb[k].qty, ab[k].qty);
+        }
+        for (size_t k = 0; k < ma.size(); ++k) {
+            ASSERT_EQ(ma[k].px, aa[k].px);
+            ASSERT_EQ(ma[k].qty, aa[k].qty);
+        }
+    }
+    EXPECT_EQ(map_book.pop_trade().size(), arr_book.pop_trade().size());
+}
+
+// erase_from(px) on the bitmap must drop what the tree drops, including cut
+// points outside the window and off the tick grid.
+TEST(Ladder, EraseFromMatchesMap) {
+    std::mt19937_64 rng(5);
+    for (int round = 0; round < 200; ++round) {
+        ArrayLadder<Side::Buy> ab(5, LadderConfig{10000, 64});
+        ArrayLadder<Side::Sell> aa(5, LadderConfig{10000, 64});
+        MapLadder<Side::Buy> mb(5, LadderConfig{});
+        MapLadder<Side::Sell> ma(5, LadderConfig{});
+        for (int i = 0; i < 40; ++i) {
+            const int64_t px = 10000 + 5 * (static_cast<int64_t>(rng() % 200) - 100);
+            ab.get_or_create(px);
+            aa.get_or_create(px);
+            mb.get_or_create(px);
+            ma.get_or_create(px);
+        }
+        const int64_t cut = 10000 + static_cast<int64_t>(rng() % 1400) - 700;
+        ab.erase_from(cut);
+        aa.erase_from(cut);
+        mb.erase_from(cut);
+        ma.erase_from(cut);
+
+        auto prices = [](const auto& l) {
+            std::vector<int64_t> v;
+            l.for_each([&](const Level& x) { v.push_back(x.px); return true; });
+            return v;
+        };
+        ASSERT_EQ(prices(ab), prices(mb)) << "cut " << cut;
+        ASSERT_EQ(prices(aa), prices(ma)) << "cut " << cut;
+        ASSERT_EQ(ab.size(), mb.size());
+        ASSERT_EQ(aa.size(), ma.size());
+        if (!ab.empty()) {
+            EXPECT_EQ(ab.best()->px, mb.best()->px);
+        }
+        if (!aa.empty()) {
+            EXPECT_EQ(aa.best()->px, ma.best()->px);
+        }
+    }
+}
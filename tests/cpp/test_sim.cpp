@@ -0,0 +1,221 @@
+#include "sim/radix_heap.hpp"
+#include "sim/simulation.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST(RadixHeap, PopsInTimeOrderFifoOnTies) {
+    sim::RadixHeap<uint32_t> h;
+    std::mt19937_64 rng(7);
+    struct Ref { uint64_t key; uint32_t id; };
+    std::vector<Ref> popped, expected;
+    std::vector<Ref> live;
+    uint64_t now = 0;
+    uint32_t next = 0;
+
+    // Interleave pushes (never below the last pop, often equal to it) and pops.
+    for (int step = 0; step < 200000; ++step) {
+        if (live.empty() || rng() % 3) {
+            const uint64_t key = now + (rng() % 4 == 0 ? 0 : rng() % (1ull << (rng() % 40)));
+            h.push(key, next);
+            live.push_back({key, next++});
+        } else {
+            const auto e = h.pop();
+            now = e.key;
+            popped.push_back({e.key, e.value});
+            // reference: smallest key, earliest push among equals
+            const auto it = std::min_element(live.begin(), live.end(), [](const Ref& a, const Ref& b) {
+                return a.key != b.key ? a.key < b.key : a.id < b.id;
+            });
+            expected.push_back(*it);
+            live.erase(it);
+        }
+        if (live.size() > 64) {     // keep the reference scan cheap
+            while (!h.empty()) {
+                const auto e = h.pop();
+                now = e.key;
+                popped.push_back({e.key, e.value});
+                const auto it = std::min_element(live.begin(), live.end(), [](const Ref& a, const Ref& b) {
+                    return a.key != b.key ? a.key < b.key : a.id < b.id;
+                });
+                expected.push_back(*it);
+                live.erase(it);
+            }
+        }
+    }
+    ASSERT_EQ(popped.size(), expected.size());
+    for (size_t i = 0; i < popped.size(); ++i) {
+        ASSERT_EQ(popped[i].key, expected[i].key) << i;
+        ASSERT_EQ(popped[i].id, expected[i].id) << i;
+    }
+}
+
+namespace {
+sim::AgentConfig fixed(int64_t entry_ns, int64_t md_ns, int64_t start_ns = 0)
+{
+    sim::AgentConfig c;
+    c.order_entry.base_ns = entry_ns;
+    c.market_data.base_ns = md_ns;
+    c.start_ns = start_ns;
+    return c;
+}
+}
+
+TEST(Simulation, LatencyDecidesTheRaceForAQuote) {
+    sim::Simulation<> s;
+    const uint32_t book = s.add_book("SIM", 1);
+
+    // Maker: one offer at t = 0, arriving at the book at t = 100.
+    uint64_t offer = 0;
+    std::vector<sim::Notice> maker_fills;
+    s.add_agent(fixed(100, 50), [&](sim::Agent<>& a) -> sim::Task {
+        offer = a.send(book, Order{.side = Side::Sell, .type = Type::Limit, .tif = TIF::Day, .px = 101, .qty = 10});
+        for (;;) maker_fills.push_back(co_await a.next());
+    });
+
+    // Two takers lift it as soon as they see it; the fast one sees it at
+    // 100 + 20 and hits at 120 + 30, the slow one only reaches the book at
+    // 100 + 80 + 90.
+    struct Seen { std::vector<sim::Notice> notices; int64_t sent_at{0}; };
+    Seen fast, slow;
+    auto taker = [&](Seen& out) {
+        return [&out, book](sim::Agent<>& a) -> sim::Task {
+            a.subscribe(book);
+            for (;;) {
+                const sim::Notice n = co_await a.next();
+                out.notices.push_back(n);
+                if (n.kind == sim::NoticeKind::Quote && n.ask_px && !out.sent_at) {
+                    out.sent_at = a.now();
+                    a.send(book, Order{.side = Side::Buy, .type = Type::Limit, .tif = TIF::IOC, .px = n.ask_px, .qty = 10});
+                }
+            }
+        };
+    };
+    s.add_agent(fixed(30, 20), taker(fast));
+    s.add_agent(fixed(90, 80), taker(slow));
+    s.run();
+
+    EXPECT_EQ(fast.sent_at, 120);
+    EXPECT_EQ(slow.sent_at, 180);
+    ASSERT_EQ(maker_fills.size(), 1u);
+    EXPECT_EQ(maker_fills[0].kind, sim::NoticeKind::Fill);
+    EXPECT_EQ(maker_fills[0].order_id, offer);
+    EXPECT_EQ(maker_fills[0].ts_ns, 150);
+    EXPECT_EQ(maker_fills[0].side, Side::Sell);
+    EXPECT_EQ(s.owner(offer), 0);
+
+    // fast: quote, own fill at 150 reported at 170, then the empty-book quote
+    auto fills = [](const Seen& x) {
+        return std::count_if(x.notices.begin(), x.notices.end(), [](const sim::Notice& n) { return n.kind == sim::NoticeKind::Fill; });
+    };
+    EXPECT_EQ(fills(fast), 1);
+    EXPECT_EQ(fills(slow), 0);
+    EXPECT_EQ(s.book(book).order_count(), 0u);
+    EXPECT_EQ(s.now(), 270);            // slow's IOC reached the book and found nothing
+}
+
+TEST(Simulation, TimersSleepAndRejects) {
+    sim::Simulation<> s;
+    const uint32_t book = s.add_book("SIM", 5);
+    std::vector<std::pair<int64_t, sim::Notice>> log;
+    s.add_agent(fixed(10, 10, 1000), [&](sim::Agent<>& a) -> sim::Task {
+        co_await a.sleep(500);
+        EXPECT_EQ(a.now(), 1500);
+        a.send(book, Order{.side = Side::Buy, .type = Type::Limit, .tif = TIF::Day, .px = 101, .qty = 1});   // off tick
+        sim::Notice n = co_await a.next(5);                                 // times out at 1505
+        log.emplace_back(a.now(), n);
+        n = co_await a.next(100);                                           // reject reported at 1520
+        log.emplace_back(a.now(), n);
+        a.cancel(book, 12345);
+        co_await a.sleep(1000);                                             // reject arrives meanwhile
+        n = co_await a.next();
+        log.emplace_back(a.now(), n);
+    });
+    s.run();
+
+    ASSERT_EQ(log.size(), 3u);
+    EXPECT_EQ(log[0].first, 1505);
+    EXPECT_EQ(log[0].second.kind, sim::NoticeKind::Timer);
+    EXPECT_EQ(log[1].first, 1520);
+    EXPECT_EQ(log[1].second.kind, sim::NoticeKind::Reject);
+    EXPECT_EQ(log[1].second.reason, RejectReason::BadPrice);
+    EXPECT_EQ(log[1].second.ts_ns, 1510);
+    EXPECT_EQ(log[2].first, 2520);
+    EXPECT_EQ(log[2].second.reason, RejectReason::UnknownId);
+    EXPECT_TRUE(s.agent(0).done());
+}
+
+TEST(Simulation, AgentsCannotTouchEachOthersOrders) {
+    sim::Simulation<> s;
+    const uint32_t book = s.add_book("SIM", 1);
+    uint64_t offer = 0;
+    std::vector<sim::Notice> owner_log, other_log;
+    s.add_agent(fixed(10, 10), [&](sim::Agent<>& a) -> sim::Task {
+        offer = a.send(book, Order{.side = Side::Sell, .type = Type::Limit, .tif = TIF::Day, .px = 101, .qty = 10});
+        for (;;) owner_log.push_back(co_await a.next());
+    });
+    s.add_agent(fixed(10, 10, 100), [&](sim::Agent<>& a) -> sim::Task {
+        a.cancel(book, offer);
+        a.replace(book, offer, 105, 1);
+        for (int i = 0; i < 2; ++i) other_log.push_back(co_await a.next());
+    });
+    s.run();
+
+    ASSERT_EQ(other_log.size(), 2u);
+    for (const sim::Notice& n : other_log) {
+        EXPECT_EQ(n.kind, sim::NoticeKind::Reject);
+        EXPECT_EQ(n.reason, RejectReason::UnknownId);
+        EXPECT_EQ(n.order_id, offer);
+    }
+    EXPECT_TRUE(owner_log.empty());
+    ASSERT_EQ(s.book(book).asks(1).size(), 1u);
+    EXPECT_EQ(s.book(book).asks(1)[0].px, 101);
+    EXPECT_EQ(s.book(book).asks(1)[0].qty, 10);
+}
+
+TEST(Simulation, JitteredRunsAreDeterministic) {
+    auto run = [](uint64_t seed) {
+        sim::Simulation<ArrayOrderBook> s;
+        const uint32_t book = s.add_book("SIM", 1);
+        std::vector<int64_t> fills;
+        for (uint32_t i = 0; i < 50; ++i) {
+            sim::AgentConfig c;
+            c.order_entry = {1000, 5000, sim::Latency::Jitter::Exponential};
+            c.market_data = {500, 2000, sim::Latency::Jitter::Uniform};
+            c.processing_ns = 200;
+            c.seed = seed * 1000 + i;
+            s.add_agent(c, [&, book](sim::Agent<ArrayOrderBook>& a) -> sim::Task {
+                for (int k = 0; k < 200; ++k) {
+                    const Side side = a.rng().below(2) ? Side::Buy : Side::Sell;
+                    const int64_t px = 1000 + static_cast<int64_t>(a.rng().below(11)) - 5;
+                    a.send(book, Order{.side = side, .type = Type::Limit, .tif = TIF::Day, .px = px, .qty = 1 + static_cast<int64_t>(a.rng().below(5))});
+                    co_await a.sleep(static_cast<int64_t>(a.rng().below(20000)));
+                    while (a.pending()) {
+                        const sim::Notice n = co_await a.next();
+                        if (n.kind == sim::NoticeKind::Fill) fills.push_back(n.ts_ns);
+                    }
+                }
+            });
+        }
+        s.run();
+        return std::make_pair(s.events_processed(), fills);
+    };
+    const auto a = run(3), b = run(3), c = run(4);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_GT(a.second.size(), 0u);
+}
+
+TEST(Simulation, LinkKeepsOrderUnderJitter) {
+    gen::Rng rng(1);
+    sim::Link link(sim::Latency{100, 10000, sim::Latency::Jitter::Exponential});
+    int64_t last = 0;
+    for (int64_t t = 0; t < 100000; t += 7) {
+        const int64_t at = link.arrival(t, rng);
+        EXPECT_GE(at, t + 100);
+        EXPECT_GE(at, last);
+        last = at;
+    }
+}
@@ -0,0 +1,188 @@
+#include "gen/poisson.hpp"
+#include "ob/book.hpp"
+#include "ob/top_of_book.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <thread>
+#include <vector>
+
+TEST(TopOfBook, PublishesTopNAfterEachMutation) {
+    PublishingOrderBook<2> ob("TEST", 1);
+    const auto& top = ob.top_of_book();
+    EXPECT_EQ(top.read().version, 0u);
+
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy,  Type::Limit, TIF::Day, 100, 10, 1, false}));
+    ASSERT_TRUE(ob.add(Order{2, Side::Buy,  Type::Limit, TIF::Day,  99, 20, 2, false}));
+    ASSERT_TRUE(ob.add(Order{3, Side::Sell, Type::Limit, TIF::Day, 102,  5, 3, false}));
+    auto s = top.read();
+    EXPECT_EQ(s.version, 3u);
+    EXPECT_EQ(s.ts_ns, 3);
+    ASSERT_EQ(s.bid_levels, 2u);
+    ASSERT_EQ(s.ask_levels, 1u);
+    EXPECT_EQ(s.best_bid(), 100);
+    EXPECT_EQ(s.bids[1].px, 99);
+    EXPECT_EQ(s.bids[1].qty, 20);
+    EXPECT_EQ(s.best_ask(), 102);
+    EXPECT_EQ(s.asks[0].orders, 1u);
+
+    // Below the published window: nothing to republish.
+    ASSERT_TRUE(ob.add(Order{4, Side::Buy, Type::Limit, TIF::Day, 98, 7, 4, false}));
+    EXPECT_EQ(top.version(), 3u);
+    EXPECT_FALSE(ob.cancel(99, 5));
+    EXPECT_EQ(top.version(), 3u);
+
+    // Sweeping the best bid shifts the window down a level.
+    ASSERT_TRUE(ob.add(Order{5, Side::Sell, Type::Market, TIF::IOC, 0, 10, 6, false}));
+    s = top.read();
+    EXPECT_EQ(s.version, 4u);
+    ASSERT_EQ(s.bid_levels, 2u);
+    EXPECT_EQ(s.best_bid(), 99);
+    EXPECT_EQ(s.bids[1].px, 98);
+}
+
+TEST(TopOfBook, MoveKeepsPublishedSnapshotAfterOddVersion) {
+    PublishingOrderBook<2> ob("TEST", 1);
+    ASSERT_TRUE(ob.add(Order{1, Side::Buy, Type::Limit, TIF::Day, 100, 10, 1, false}));
+    ASSERT_EQ(ob.top_of_book().version(), 1u);
+
+    PublishingOrderBook<2> moved(std::move(ob));
+    auto s = moved.top_of_book().read();
+    EXPECT_EQ(s.version, 1u);
+    ASSERT_EQ(s.bid_levels, 1u);
+    EXPECT_EQ(s.best_bid(), 100);
+    EXPECT_EQ(s.bids[0].qty, 10);
+
+    // Publishing after the move carries on from the same version.
+    ASSERT_TRUE(moved.add(Order{2, Side::Sell, Type::Limit, TIF::Day, 102, 5, 2, false}));
+    s = moved.top_of_book().read();
+    EXPECT_EQ(s.version, 2u);
+    EXPECT_EQ(s.best_bid(), 100);
+    ASSERT_EQ(s.ask_levels, 1u);
+    EXPECT_EQ(s.best_ask(), 102);
+}
+
+namespace {
+// Publishes levels whose every field is a function of one counter, so a
+// torn copy (words from two different publishes) is detectable.
+struct PatternBook
+{
+    int64_t k{0};
+
+    template <class F>
+    void for_each_level(Side side, F&& f) const
+    {
+        for (int64_t i = 0; i < 8; ++i) {
+            Level l(side == Side::Buy ? k * 100 - i : k * 100 + 50 + i);
+            l.qty = k + i;
+            l.n = static_cast<size_t>(k + i);
+            if (!f(l)) return;
+        }
+    }
+};
+}
+
+TEST(TopOfBook, ConcurrentReadersNeverSeeTornSnapshots) {
+    TopOfBook<8> top;
+    PatternBook book;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0}, bad{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            uint64_t last = 0, n = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const auto s = top.read();
+                ++n;
+                if (s.version < last) ++bad;
+                last = s.version;
+                if (s.version == 0) continue;
+                const auto k = static_cast<int64_t>(s.version);
+                bool ok = s.ts_ns == k && s.bid_levels == 8 && s.ask_levels == 8;
+                for (int64_t i = 0; i < 8; ++i) {
+                    ok &= s.bids[i].px == k * 100 - i && s.asks[i].px == k * 100 + 50 + i;
+                    ok &= s.bids[i].qty == k + i && s.asks[i].orders == static_cast<uint32_t>(k + i);
+                }
+                bad += !ok;
+            }
+            reads += n;
+        });
+    }
+
+    for (int64_t k = 1; k <= 300000; ++k) {
+        book.k = k;
+        top.invalidate();
+        top.publish(book, k);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(bad.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(top.read().version, 300000u);
+}
+
+TEST(TopOfBook, StressReadersUnderFullRateBook) {
+    constexpr size_t N = 5;
+    PublishingArrayOrderBook<N> ob("TEST", 1);
+    gen::FlowConfig cfg;
+    cfg.marketable_frac = 0.05;
+    gen::PoissonFlow flow(cfg, 3);
+    std::vector<OrderMsg> msgs(400000);
+    flow.fill(msgs);
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> bad{0}, reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            const auto& top = ob.top_of_book();
+            uint64_t last = 0, n = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const auto s = top.read();
+                ++n;
+                bool ok = s.version >= last && s.bid_levels <= N && s.ask_levels <= N;
+                last = s.version;
+                for (uint32_t i = 0; i < s.bid_levels; ++i) {
+                    ok &= s.bids[i].qty >= static_cast<int64_t>(s.bids[i].orders) && s.bids[i].orders > 0;
+                    if (i) ok &= s.bids[i].px < s.bids[i - 1].px;
+                }
+                for (uint32_t i = 0; i < s.ask_levels; ++i) {
+                    ok &= s.asks[i].qty >= static_cast<int64_t>(s.asks[i].orders) && s.asks[i].orders > 0;
+                    if (i) ok &= s.asks[i].px > s.asks[i - 1].px;
+                }
+                if (s.has_bid() && s.has_ask()) ok &= s.best_bid() < s.best_ask();   // never mid-sweep
+                bad += !ok;
+            }
+            reads += n;
+        });
+    }
+
+    std::vector<RejectReason> status(1024);
+    for (size_t i = 0; i < msgs.size(); i += 1024) {
+        const size_t n = std::min<size_t>(1024, msgs.size() - i);
+        ob.apply_batch(std::span<const OrderMsg>(msgs).subspan(i, n), std::span(status).first(n));
+        ob.events().clear();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(bad.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+
+    const auto s = ob.top_of_book().read();
+    const auto bids = ob.bids(N), asks = ob.asks(N);
+    ASSERT_EQ(s.bid_levels, bids.size());
+    ASSERT_EQ(s.ask_levels, asks.size());
+    for (size_t i = 0; i < bids.size(); ++i) {
+        EXPECT_EQ(s.bids[i].px, bids[i].px);
+        EXPECT_EQ(s.bids[i].qty, bids[i].qty);
+        EXPECT_EQ(s.bids[i].orders, bids[i].orders);
+    }
+    for (size_t i = 0; i < asks.size(); ++i) {
+        EXPECT_EQ(s.asks[i].px, asks[i].px);
+        EXPECT_EQ(s.asks[i].qty, asks[i].qty);
+    }
+}